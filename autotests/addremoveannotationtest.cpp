@@ -33,6 +33,7 @@ private:
 
 void AddRemoveAnnotationTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("addannotationtest") );
     m_document = new Okular::Document( nullptr );
 }
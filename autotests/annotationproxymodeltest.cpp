@@ -0,0 +1,166 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QStandardItemModel>
+
+#include "../core/annotations.h"
+#include "../ui/annotationmodel.h"
+#include "../ui/annotationproxymodels.h"
+
+class AnnotationProxyModelTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void testRemoveFirstAnnotation_data();
+    void testRemoveFirstAnnotation();
+    void testRemovePage_data();
+    void testRemovePage();
+
+private:
+    QStandardItem *appendPage( int page );
+    void appendAnnotation( QStandardItem *pageItem, const QString &author );
+    void verifyMapping( const AuthorGroupProxyModel &proxy );
+
+    // the same roles and layout as AnnotationModel
+    QStandardItemModel *m_model;
+    QList<Okular::Annotation*> m_annotations;
+};
+
+void AnnotationProxyModelTest::init()
+{
+    m_model = new QStandardItemModel( this );
+
+    QStandardItem *page = appendPage( 0 );
+    appendAnnotation( page, QStringLiteral( "alice" ) );
+    appendAnnotation( page, QStringLiteral( "bob" ) );
+    appendAnnotation( page, QStringLiteral( "alice" ) );
+    appendAnnotation( page, QStringLiteral( "bob" ) );
+
+    page = appendPage( 3 );
+    appendAnnotation( page, QStringLiteral( "bob" ) );
+    appendAnnotation( page, QStringLiteral( "alice" ) );
+}
+
+void AnnotationProxyModelTest::cleanup()
+{
+    delete m_model;
+    qDeleteAll( m_annotations );
+    m_annotations.clear();
+}
+
+QStandardItem *AnnotationProxyModelTest::appendPage( int page )
+{
+    QStandardItem *item = new QStandardItem( QStringLiteral( "Page %1" ).arg( page + 1 ) );
+    item->setData( page, AnnotationModel::PageRole );
+    item->setData( QVariant::fromValue< Okular::Annotation* >( nullptr ), AnnotationModel::AnnotationRole );
+    m_model->appendRow( item );
+    return item;
+}
+
+void AnnotationProxyModelTest::appendAnnotation( QStandardItem *pageItem, const QString &author )
+{
+    Okular::Annotation *annotation = new Okular::TextAnnotation();
+    annotation->setAuthor( author );
+    m_annotations.append( annotation );
+
+    QStandardItem *item = new QStandardItem( QStringLiteral( "%1 %2" ).arg( author ).arg( m_annotations.count() ) );
+    item->setData( author, AnnotationModel::AuthorRole );
+    item->setData( pageItem->data( AnnotationModel::PageRole ), AnnotationModel::PageRole );
+    item->setData( QVariant::fromValue( annotation ), AnnotationModel::AnnotationRole );
+    pageItem->appendRow( item );
+}
+
+void AnnotationProxyModelTest::verifyMapping( const AuthorGroupProxyModel &proxy )
+{
+    int annotationCount = 0;
+    for ( int row = 0; row < m_model->rowCount(); ++row )
+    {
+        const QModelIndex pageIndex = m_model->index( row, 0 );
+        const QModelIndex proxyPageIndex = proxy.mapFromSource( pageIndex );
+        QVERIFY( proxyPageIndex.isValid() );
+        QCOMPARE( proxy.mapToSource( proxyPageIndex ), pageIndex );
+
+        for ( int subRow = 0; subRow < m_model->rowCount( pageIndex ); ++subRow )
+        {
+            const QModelIndex index = m_model->index( subRow, 0, pageIndex );
+            const QModelIndex proxyIndex = proxy.mapFromSource( index );
+            QVERIFY( proxyIndex.isValid() );
+            QCOMPARE( proxy.mapToSource( proxyIndex ), index );
+            QCOMPARE( proxyIndex.data().toString(), index.data().toString() );
+            annotationCount++;
+        }
+    }
+
+    // no item is left of the removed annotations
+    int proxyAnnotationCount = 0;
+    for ( int row = 0; row < proxy.rowCount( QModelIndex() ); ++row )
+    {
+        const QModelIndex pageIndex = proxy.index( row, 0 );
+        for ( int subRow = 0; subRow < proxy.rowCount( pageIndex ); ++subRow )
+        {
+            const QModelIndex index = proxy.index( subRow, 0, pageIndex );
+            const int count = proxy.rowCount( index );
+            proxyAnnotationCount += count == 0 ? 1 : count;
+        }
+    }
+    QCOMPARE( proxyAnnotationCount, annotationCount );
+}
+
+void AnnotationProxyModelTest::testRemoveFirstAnnotation_data()
+{
+    QTest::addColumn<bool>( "groupByAuthor" );
+
+    QTest::newRow( "annotations" ) << false;
+    QTest::newRow( "authors" ) << true;
+}
+
+void AnnotationProxyModelTest::testRemoveFirstAnnotation()
+{
+    QFETCH( bool, groupByAuthor );
+
+    AuthorGroupProxyModel proxy;
+    proxy.setSourceModel( m_model );
+    proxy.groupByAuthor( groupByAuthor );
+    verifyMapping( proxy );
+
+    m_model->removeRow( 0, m_model->index( 0, 0 ) );
+    verifyMapping( proxy );
+
+    m_model->removeRow( 0, m_model->index( 0, 0 ) );
+    verifyMapping( proxy );
+}
+
+void AnnotationProxyModelTest::testRemovePage_data()
+{
+    QTest::addColumn<bool>( "groupByAuthor" );
+
+    QTest::newRow( "annotations" ) << false;
+    QTest::newRow( "authors" ) << true;
+}
+
+void AnnotationProxyModelTest::testRemovePage()
+{
+    QFETCH( bool, groupByAuthor );
+
+    AuthorGroupProxyModel proxy;
+    proxy.setSourceModel( m_model );
+    proxy.groupByAuthor( groupByAuthor );
+
+    m_model->removeRow( 0 );
+    QCOMPARE( proxy.rowCount( QModelIndex() ), 1 );
+    verifyMapping( proxy );
+}
+
+QTEST_MAIN( AnnotationProxyModelTest )
+#include "annotationproxymodeltest.moc"
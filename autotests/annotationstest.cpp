@@ -39,6 +39,7 @@ private:
 
 void AnnotationTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("annotationtest") );
     m_document = new Okular::Document( nullptr );
     const QString testFile = QStringLiteral(KDESRCDIR "data/file1.pdf");
@@ -0,0 +1,196 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QMimeDatabase>
+#include <QStandardPaths>
+
+#include <KBookmarkManager>
+
+#include "../core/bookmarkmanager.h"
+#include "../core/document.h"
+#include "../settings_core.h"
+
+class BookmarkManagerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+    void testPageBookmarks();
+    void testViewportBookmarks();
+    void testNextPrevious();
+    void testDeferredSave();
+    void testSaveBeforeReparse();
+
+private:
+    static Okular::DocumentViewport viewport( int page, double y );
+    bool bookmarksFileContains( const QString &text ) const;
+
+    Okular::Document *m_document;
+    QString m_bookmarksFile;
+};
+
+void BookmarkManagerTest::initTestCase()
+{
+    // keep away from the bookmarks of the user
+    QStandardPaths::setTestModeEnabled( true );
+    m_bookmarksFile = QStandardPaths::writableLocation( QStandardPaths::GenericDataLocation ) + QStringLiteral( "/okular/bookmarks.xml" );
+    QFile::remove( m_bookmarksFile );
+
+    Okular::SettingsCore::instance( QStringLiteral( "bookmarkmanagertest" ) );
+    m_document = new Okular::Document( nullptr );
+}
+
+void BookmarkManagerTest::cleanupTestCase()
+{
+    delete m_document;
+    QFile::remove( m_bookmarksFile );
+}
+
+void BookmarkManagerTest::init()
+{
+    const QString testFile = QStringLiteral( KDESRCDIR "data/simple-multipage.pdf" );
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile( testFile );
+    QCOMPARE( m_document->openDocument( testFile, QUrl::fromLocalFile( testFile ), mime ), Okular::Document::OpenSuccess );
+    QVERIFY( m_document->pages() >= 4 );
+}
+
+void BookmarkManagerTest::cleanup()
+{
+    Okular::BookmarkManager *manager = m_document->bookmarkManager();
+    manager->removeBookmarks( m_document->currentDocument(), manager->bookmarks() );
+    QVERIFY( manager->bookmarks().isEmpty() );
+    manager->save();
+
+    m_document->closeDocument();
+}
+
+Okular::DocumentViewport BookmarkManagerTest::viewport( int page, double y )
+{
+    Okular::DocumentViewport vp( page );
+    vp.rePos.enabled = true;
+    vp.rePos.normalizedX = 0.5;
+    vp.rePos.normalizedY = y;
+    vp.rePos.pos = Okular::DocumentViewport::TopLeft;
+    return vp;
+}
+
+void BookmarkManagerTest::testPageBookmarks()
+{
+    Okular::BookmarkManager *manager = m_document->bookmarkManager();
+
+    manager->addBookmark( 3 );
+    manager->addBookmark( 1 );
+    manager->addBookmark( 1 );
+    QVERIFY( manager->isBookmarked( 1 ) );
+    QVERIFY( manager->isBookmarked( 3 ) );
+    QVERIFY( !manager->isBookmarked( 2 ) );
+    QCOMPARE( manager->bookmarks( 1 ).count(), 1 );
+    QVERIFY( manager->bookmark( 2 ).isNull() );
+    QCOMPARE( Okular::DocumentViewport( manager->bookmark( 3 ).url().fragment( QUrl::FullyDecoded ) ).pageNumber, 3 );
+
+    manager->removeBookmark( 1 );
+    QVERIFY( !manager->isBookmarked( 1 ) );
+    QVERIFY( manager->bookmark( 1 ).isNull() );
+    QVERIFY( manager->isBookmarked( 3 ) );
+    QCOMPARE( manager->bookmarks().count(), 1 );
+}
+
+void BookmarkManagerTest::testViewportBookmarks()
+{
+    Okular::BookmarkManager *manager = m_document->bookmarkManager();
+
+    manager->addBookmark( viewport( 2, 0.75 ) );
+    manager->addBookmark( viewport( 2, 0.25 ) );
+    QCOMPARE( manager->bookmarks( 2 ).count(), 2 );
+    QVERIFY( manager->isBookmarked( viewport( 2, 0.75 ) ) );
+    QVERIFY( manager->isBookmarked( viewport( 2, 0.25 ) ) );
+    QVERIFY( !manager->isBookmarked( viewport( 2, 0.5 ) ) );
+
+    // the bookmarks of a page are in the order of their viewports
+    QCOMPARE( manager->bookmark( 2 ), manager->bookmark( viewport( 2, 0.25 ) ) );
+
+    manager->removeBookmark( viewport( 2, 0.25 ) );
+    QVERIFY( !manager->isBookmarked( viewport( 2, 0.25 ) ) );
+    QVERIFY( manager->isBookmarked( viewport( 2, 0.75 ) ) );
+    QCOMPARE( manager->bookmarks( 2 ).count(), 1 );
+    QVERIFY( manager->isBookmarked( 2 ) );
+}
+
+void BookmarkManagerTest::testNextPrevious()
+{
+    Okular::BookmarkManager *manager = m_document->bookmarkManager();
+
+    manager->addBookmark( viewport( 3, 0.5 ) );
+    manager->addBookmark( viewport( 1, 0.5 ) );
+    manager->addBookmark( viewport( 1, 0.1 ) );
+
+    const KBookmark first = manager->bookmark( viewport( 1, 0.1 ) );
+    const KBookmark second = manager->bookmark( viewport( 1, 0.5 ) );
+    const KBookmark third = manager->bookmark( viewport( 3, 0.5 ) );
+
+    QCOMPARE( manager->nextBookmark( viewport( 0, 0.0 ) ), first );
+    QCOMPARE( manager->nextBookmark( viewport( 1, 0.1 ) ), second );
+    QCOMPARE( manager->nextBookmark( viewport( 1, 0.7 ) ), third );
+    QVERIFY( manager->nextBookmark( viewport( 3, 0.5 ) ).isNull() );
+
+    QCOMPARE( manager->previousBookmark( viewport( 3, 0.9 ) ), third );
+    QCOMPARE( manager->previousBookmark( viewport( 3, 0.5 ) ), second );
+    QCOMPARE( manager->previousBookmark( viewport( 1, 0.3 ) ), first );
+    QVERIFY( manager->previousBookmark( viewport( 1, 0.1 ) ).isNull() );
+}
+
+bool BookmarkManagerTest::bookmarksFileContains( const QString &text ) const
+{
+    QFile file( m_bookmarksFile );
+    return file.open( QIODevice::ReadOnly ) && QString::fromUtf8( file.readAll() ).contains( text );
+}
+
+void BookmarkManagerTest::testDeferredSave()
+{
+    Okular::BookmarkManager *manager = m_document->bookmarkManager();
+
+    // a burst of changes is written once, a moment later
+    manager->addBookmark( viewport( 2, 0.5 ) );
+    manager->addBookmark( viewport( 3, 0.5 ) );
+    QTRY_VERIFY( bookmarksFileContains( QStringLiteral( "<title>#4</title>" ) ) );
+    QVERIFY( bookmarksFileContains( QStringLiteral( "<title>#3</title>" ) ) );
+}
+
+void BookmarkManagerTest::testSaveBeforeReparse()
+{
+    Okular::BookmarkManager *manager = m_document->bookmarkManager();
+
+    manager->addBookmark( viewport( 1, 0.5 ) );
+    manager->addBookmark( viewport( 2, 0.5 ) );
+
+    // another process changed the file before ours was saved, the file is
+    // parsed again, and the changes not saved yet are kept and written
+    KBookmarkManager::managerForFile( m_bookmarksFile, QStringLiteral( "okular" ) )->notifyCompleteChange( QString() );
+    QVERIFY( bookmarksFileContains( QStringLiteral( "<title>#2</title>" ) ) );
+    QVERIFY( bookmarksFileContains( QStringLiteral( "<title>#3</title>" ) ) );
+
+    // the index holds the bookmarks of the parsed file
+    QVERIFY( manager->isBookmarked( 1 ) );
+    QVERIFY( manager->isBookmarked( 2 ) );
+    manager->removeBookmark( 1 );
+    QVERIFY( !manager->isBookmarked( 1 ) );
+    QCOMPARE( manager->bookmarks().count(), 1 );
+    manager->save();
+    QVERIFY( !bookmarksFileContains( QStringLiteral( "<title>#2</title>" ) ) );
+}
+
+QTEST_MAIN( BookmarkManagerTest )
+#include "bookmarkmanagertest.moc"
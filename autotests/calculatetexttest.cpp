@@ -33,6 +33,7 @@ private:
 
 void CalculateTextTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("calculatetexttest") );
     m_document = new Okular::Document( nullptr );
 }
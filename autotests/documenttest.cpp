@@ -31,12 +31,15 @@ class DocumentTest
     private slots:
         void testCloseDuringRotationJob();
         void testDocdataMigration();
+        void testHighlightKeepsTextSelection();
+        void testViewportWithoutHistory();
 };
 
 // Test that we don't crash if the document is closed while a RotationJob
 // is enqueued/running
 void DocumentTest::testCloseDuringRotationJob()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("documenttest") );
     Okular::Document *m_document = new Okular::Document( nullptr );
     const QString testFile = QStringLiteral(KDESRCDIR "data/file1.pdf");
@@ -73,6 +76,7 @@ void DocumentTest::testCloseDuringRotationJob()
 // the document without migrating and that it does get wiped out after migrating
 void DocumentTest::testDocdataMigration()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("documenttest") );
 
     const QUrl testFileUrl = QUrl::fromLocalFile(KDESRCDIR "data/file1.pdf");
@@ -129,5 +133,64 @@ void DocumentTest::testDocdataMigration()
     delete m_document;
 }
 
+// Test that a highlight with its own id, like the one of the sentence read
+// aloud, does not replace nor clear the text selection of the user
+void DocumentTest::testHighlightKeepsTextSelection()
+{
+    QStandardPaths::setTestModeEnabled( true );
+    Okular::SettingsCore::instance( QStringLiteral("documenttest") );
+    Okular::Document *m_document = new Okular::Document( nullptr );
+    const QString testFile = QStringLiteral(KDESRCDIR "data/file1.pdf");
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile( testFile );
+    QCOMPARE( m_document->openDocument( testFile, QUrl(), mime ), Okular::Document::OpenSuccess );
+
+    const Okular::Page *page = m_document->page( 0 );
+    m_document->setPageTextSelection( 0, new Okular::RegularAreaRect( Okular::NormalizedRect( 0.1, 0.1, 0.4, 0.2 ) ), Qt::blue );
+    QVERIFY( page->textSelection() );
+
+    m_document->setPageHighlight( 0, TTS_HIGHLIGHT_ID, new Okular::RegularAreaRect( Okular::NormalizedRect( 0.1, 0.5, 0.4, 0.6 ) ), Qt::red );
+    QVERIFY( page->hasHighlights( TTS_HIGHLIGHT_ID ) );
+    QVERIFY( page->textSelection() );
+
+    m_document->setPageHighlight( 0, TTS_HIGHLIGHT_ID, new Okular::RegularAreaRect( Okular::NormalizedRect( 0.1, 0.7, 0.4, 0.8 ) ), Qt::red );
+    QVERIFY( page->hasHighlights( TTS_HIGHLIGHT_ID ) );
+    QVERIFY( page->textSelection() );
+
+    m_document->setPageHighlight( 0, TTS_HIGHLIGHT_ID, nullptr, QColor() );
+    QVERIFY( !page->hasHighlights( TTS_HIGHLIGHT_ID ) );
+    QVERIFY( page->textSelection() );
+
+    delete m_document;
+}
+
+// Test that a viewport set without history replaces the current entry,
+// so that going back does not step through it
+void DocumentTest::testViewportWithoutHistory()
+{
+    QStandardPaths::setTestModeEnabled( true );
+    Okular::SettingsCore::instance( QStringLiteral("documenttest") );
+    Okular::Document *m_document = new Okular::Document( nullptr );
+    const QString testFile = QStringLiteral(KDESRCDIR "data/simple-multipage.pdf");
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile( testFile );
+    QCOMPARE( m_document->openDocument( testFile, QUrl(), mime ), Okular::Document::OpenSuccess );
+    QVERIFY( m_document->pages() > 2 );
+
+    m_document->setViewportPage( 0 );
+    m_document->setViewportWithHistory( Okular::DocumentViewport( 1 ), nullptr, false, false );
+    QCOMPARE( m_document->viewport().pageNumber, 1 );
+    m_document->setViewportWithHistory( Okular::DocumentViewport( 2 ), nullptr, false, false );
+    QCOMPARE( m_document->viewport().pageNumber, 2 );
+    m_document->setPrevViewport();
+    QCOMPARE( m_document->viewport().pageNumber, 2 );
+
+    m_document->setViewport( Okular::DocumentViewport( 1 ) );
+    m_document->setPrevViewport();
+    QCOMPARE( m_document->viewport().pageNumber, 2 );
+
+    delete m_document;
+}
+
 QTEST_MAIN( DocumentTest )
 #include "documenttest.moc"
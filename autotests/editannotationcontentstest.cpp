@@ -94,6 +94,7 @@ void MockEditor::slotAnnotationContentsChangedByUndoRedo(Okular::Annotation* ann
 
 void EditAnnotationContentsTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("editannotationcontentstest") );
     m_document = new Okular::Document( nullptr );
 }
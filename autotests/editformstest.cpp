@@ -27,6 +27,7 @@ private slots:
     void cleanup();
 
     void testRadioButtonForm();
+    void testRadioButtonFormOnPages();
     void testCheckBoxForm();
     void testTextLineForm();
     void testTextAreaForm();
@@ -54,6 +55,7 @@ private:
 
 void EditFormsTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("editformstest") );
     m_document = new Okular::Document( nullptr );
 }
@@ -179,6 +181,29 @@ void EditFormsTest::testRadioButtonForm()
     QVERIFY( !m_document->canRedo() );
 }
 
+void EditFormsTest::testRadioButtonFormOnPages()
+{
+    verifyRadioButtonStates( true, false, false );
+
+    // The buttons are all on the first page here, the undo and redo
+    // notifications are sent once per page
+    QSignalSpy spy( m_document, &Okular::Document::formButtonsChangedByUndoRedo );
+    m_document->editFormButtonsOnPages( 0, QList<int>() << 0 << 0 << 0, m_radioButtonForms, QList<bool>() << false << false << true );
+    verifyRadioButtonStates( false, false, true );
+    QCOMPARE( spy.count(), 1 );
+    QCOMPARE( spy.at( 0 ).at( 0 ).toInt(), 0 );
+
+    m_document->undo();
+    verifyRadioButtonStates( true, false, false );
+    QCOMPARE( spy.count(), 2 );
+    QCOMPARE( spy.at( 1 ).at( 0 ).toInt(), 0 );
+
+    m_document->redo();
+    verifyRadioButtonStates( false, false, true );
+    QVERIFY( m_document->canUndo() );
+    QVERIFY( !m_document->canRedo() );
+}
+
 void EditFormsTest::testCheckBoxForm()
 {
     // Examine the first and second checkboxes
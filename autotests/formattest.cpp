@@ -13,6 +13,7 @@
 #include <QMimeType>
 #include <QMimeDatabase>
 #include "../settings_core.h"
+#include <core/action.h>
 #include <core/document.h>
 #include <core/page.h>
 #include <core/form.h>
@@ -35,6 +36,7 @@ private slots:
     void testFocusAction_data();
     void testValidateAction();
     void testValidateAction_data();
+    void testScriptGlobals();
 private:
 
     Okular::Document *m_document;
@@ -44,6 +46,7 @@ private:
 
 void FormatTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral( "formattest" ) );
     m_document = new Okular::Document( nullptr );
 
@@ -178,6 +181,31 @@ void FormatTest::testValidateAction_data()
     QTest::newRow( "invalid text was set" ) << QStringLiteral( "abc" ) << QStringLiteral( "invalid" );
 }
 
+void FormatTest::testScriptGlobals()
+{
+    Okular::FormFieldText *fft = reinterpret_cast< Okular::FormFieldText * >(  m_fields[ "time1" ] );
+
+    // the variables declared by a script stay global
+    const Okular::ScriptAction declare( Okular::JavaScript, QStringLiteral( "var okularCounter = 0; function okularNext() { return ++okularCounter; }" ) );
+    fft->setText( QString() );
+    m_document->processFormatAction( &declare, fft );
+
+    // and scripts run again, that are compiled only once, still see them
+    const Okular::ScriptAction increment( Okular::JavaScript, QStringLiteral( "event.value = String( okularNext() );" ) );
+    fft->setText( QString() );
+    m_document->processFormatAction( &increment, fft );
+    QCOMPARE( m_formattedText, QStringLiteral( "1" ) );
+
+    fft->setText( QString() );
+    m_document->processFormatAction( &increment, fft );
+    QCOMPARE( m_formattedText, QStringLiteral( "2" ) );
+
+    const Okular::ScriptAction read( Okular::JavaScript, QStringLiteral( "event.value = 'counter ' + okularCounter;" ) );
+    fft->setText( QString() );
+    m_document->processFormatAction( &read, fft );
+    QCOMPARE( m_formattedText, QStringLiteral( "counter 2" ) );
+}
+
 void FormatTest::cleanupTestCase()
 {
     m_document->closeDocument();
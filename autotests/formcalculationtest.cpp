@@ -0,0 +1,205 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include "../core/action.h"
+#include "../core/form.h"
+#include "../core/formcalculation_p.h"
+#include "../core/page.h"
+
+class TestFormField : public Okular::FormFieldText
+{
+public:
+    TestFormField( int id, const QString &name, const QString &calculateScript = QString() )
+        : m_id( id ), m_name( name )
+    {
+        if ( !calculateScript.isEmpty() )
+            setAdditionalAction( CalculateField, new Okular::ScriptAction( Okular::JavaScript, calculateScript ) );
+    }
+
+    Okular::NormalizedRect rect() const override { return Okular::NormalizedRect(); }
+    int id() const override { return m_id; }
+    QString name() const override { return m_name; }
+    QString uiName() const override { return m_name; }
+    QString fullyQualifiedName() const override { return m_name; }
+    TextType textType() const override { return Normal; }
+    QString text() const override { return m_text; }
+    void setText( const QString &text ) override { m_text = text; }
+    void setAppearanceText( const QString &text ) override { m_text = text; }
+
+private:
+    int m_id;
+    QString m_name;
+    QString m_text;
+};
+
+class FormCalculationTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+
+    void testReferencedFieldNames_data();
+    void testReferencedFieldNames();
+    void testDownstreamOrder();
+    void testUnknownScriptAlwaysCalculated();
+    void benchmarkBuild();
+    void benchmarkFieldsToCalculate();
+
+private:
+    void createLargeForm( int pageCount, int fieldsPerPage, QVector<int> *calculateOrder );
+
+    QVector<Okular::Page *> m_pages;
+};
+
+void FormCalculationTest::cleanup()
+{
+    qDeleteAll( m_pages );
+    m_pages.clear();
+}
+
+// Every page has fieldsPerPage input fields, one field summing them and a
+// total field adding the sum to the total of the previous page.
+void FormCalculationTest::createLargeForm( int pageCount, int fieldsPerPage, QVector<int> *calculateOrder )
+{
+    int id = 0;
+    for ( int page = 0; page < pageCount; ++page )
+    {
+        QLinkedList<Okular::FormField *> fields;
+        QStringList inputs;
+        for ( int i = 0; i < fieldsPerPage; ++i )
+        {
+            const QString name = QStringLiteral( "p%1.f%2" ).arg( page ).arg( i );
+            fields.append( new TestFormField( id++, name ) );
+            inputs.append( QStringLiteral( "\"%1\"" ).arg( name ) );
+        }
+
+        const int sumId = id++;
+        fields.append( new TestFormField( sumId, QStringLiteral( "p%1.sum" ).arg( page ),
+                       QStringLiteral( "AFSimple_Calculate(\"SUM\", new Array (%1));" ).arg( inputs.join( QStringLiteral( ", " ) ) ) ) );
+
+        const int totalId = id++;
+        const QString previousTotal = page > 0 ? QStringLiteral( " + Number(this.getField(\"p%1.total\").value)" ).arg( page - 1 ) : QString();
+        fields.append( new TestFormField( totalId, QStringLiteral( "p%1.total" ).arg( page ),
+                       QStringLiteral( "event.value = Number(this.getField(\"p%1.sum\").value)%2;" ).arg( page ).arg( previousTotal ) ) );
+
+        // the document lists the totals first, the graph has to fix that
+        calculateOrder->prepend( totalId );
+        calculateOrder->append( sumId );
+
+        Okular::Page *p = new Okular::Page( page, 600, 800, Okular::Rotation0 );
+        p->setFormFields( fields );
+        m_pages.append( p );
+    }
+}
+
+void FormCalculationTest::testReferencedFieldNames_data()
+{
+    QTest::addColumn<QString>( "script" );
+    QTest::addColumn<QStringList>( "names" );
+    QTest::addColumn<bool>( "complete" );
+
+    QTest::newRow( "getField" ) << QStringLiteral( "event.value = this.getField(\"a\").value * getField('b').value;" )
+                                << ( QStringList() << QStringLiteral( "a" ) << QStringLiteral( "b" ) ) << true;
+    QTest::newRow( "AFSimple_Calculate" ) << QStringLiteral( "AFSimple_Calculate(\"SUM\", new Array (\"field1\", \"field2\", \"field3\"));" )
+                                          << ( QStringList() << QStringLiteral( "field1" ) << QStringLiteral( "field2" ) << QStringLiteral( "field3" ) ) << true;
+    QTest::newRow( "array literal" ) << QStringLiteral( "AFSimple_Calculate('AVG', ['x', 'y'])" )
+                                     << ( QStringList() << QStringLiteral( "x" ) << QStringLiteral( "y" ) ) << true;
+    QTest::newRow( "computed name" ) << QStringLiteral( "var n = \"a\"; event.value = getField(n).value + getField(\"b\").value;" )
+                                     << ( QStringList() << QStringLiteral( "b" ) ) << false;
+    QTest::newRow( "no field" ) << QStringLiteral( "event.value = 42;" ) << QStringList() << false;
+}
+
+void FormCalculationTest::testReferencedFieldNames()
+{
+    QFETCH( QString, script );
+    QFETCH( QStringList, names );
+    QFETCH( bool, complete );
+
+    bool isComplete = !complete;
+    QCOMPARE( Okular::FormCalculation::referencedFieldNames( script, &isComplete ), names );
+    QCOMPARE( isComplete, complete );
+}
+
+void FormCalculationTest::testDownstreamOrder()
+{
+    QVector<int> calculateOrder;
+    createLargeForm( 4, 3, &calculateOrder );
+
+    Okular::FormCalculation calculation;
+    calculation.build( m_pages, calculateOrder );
+
+    // p2.f0 only affects p2.sum, p2.total and p3.total
+    Okular::FormField *changed = calculation.field( 2 * 5 );
+    QCOMPARE( changed->name(), QStringLiteral( "p2.f0" ) );
+    QCOMPARE( calculation.pageNumber( changed->id() ), 2 );
+
+    const QVector<int> order = calculation.fieldsToCalculate( QList<Okular::FormField *>() << changed );
+    QStringList names;
+    for ( int id : order )
+        names.append( calculation.field( id )->name() );
+
+    QCOMPARE( names, QStringList() << QStringLiteral( "p2.sum" ) << QStringLiteral( "p2.total" ) << QStringLiteral( "p3.total" ) );
+
+    // a field nobody reads does not trigger anything
+    QVERIFY( calculation.fieldsToCalculate( QList<Okular::FormField *>() << calculation.field( 3 * 5 + 4 ) ).isEmpty() );
+}
+
+void FormCalculationTest::testUnknownScriptAlwaysCalculated()
+{
+    QLinkedList<Okular::FormField *> fields;
+    Okular::FormField *input = new TestFormField( 0, QStringLiteral( "input" ) );
+    fields.append( input );
+    fields.append( new TestFormField( 1, QStringLiteral( "other" ) ) );
+    fields.append( new TestFormField( 2, QStringLiteral( "dynamic" ), QStringLiteral( "event.value = getField(\"in\" + \"put\").value;" ) ) );
+    fields.append( new TestFormField( 3, QStringLiteral( "static" ), QStringLiteral( "event.value = getField(\"input\").value;" ) ) );
+
+    Okular::Page *page = new Okular::Page( 0, 600, 800, Okular::Rotation0 );
+    page->setFormFields( fields );
+    m_pages.append( page );
+
+    Okular::FormCalculation calculation;
+    calculation.build( m_pages, QVector<int>() << 2 << 3 );
+
+    QCOMPARE( calculation.fieldsToCalculate( QList<Okular::FormField *>() << calculation.field( 1 ) ), QVector<int>() << 2 );
+    QCOMPARE( calculation.fieldsToCalculate( QList<Okular::FormField *>() << input ), QVector<int>() << 2 << 3 );
+}
+
+void FormCalculationTest::benchmarkBuild()
+{
+    QVector<int> calculateOrder;
+    createLargeForm( 50, 38, &calculateOrder );
+
+    QBENCHMARK {
+        Okular::FormCalculation calculation;
+        calculation.build( m_pages, calculateOrder );
+    }
+}
+
+void FormCalculationTest::benchmarkFieldsToCalculate()
+{
+    QVector<int> calculateOrder;
+    createLargeForm( 50, 38, &calculateOrder );
+
+    Okular::FormCalculation calculation;
+    calculation.build( m_pages, calculateOrder );
+
+    // a keystroke in the middle of the document
+    const QList<Okular::FormField *> changed = QList<Okular::FormField *>() << calculation.field( 25 * 40 );
+    QVector<int> order;
+    QBENCHMARK {
+        order = calculation.fieldsToCalculate( changed );
+    }
+    QCOMPARE( order.count(), 26 );
+}
+
+QTEST_MAIN( FormCalculationTest )
+#include "formcalculationtest.moc"
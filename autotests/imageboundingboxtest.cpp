@@ -0,0 +1,92 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QPainter>
+
+#include "../core/area.h"
+#include "../core/utils.h"
+#include "../settings_core.h"
+
+Q_DECLARE_METATYPE(QImage::Format)
+
+class ImageBoundingBoxTest : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void testBoundingBox_data();
+        void testBoundingBox();
+        void testBlankImage();
+        void testTranslucentPremultiplied();
+};
+
+void ImageBoundingBoxTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled( true );
+    Okular::SettingsCore::instance( QStringLiteral("imageboundingboxtest") );
+}
+
+void ImageBoundingBoxTest::testBoundingBox_data()
+{
+    QTest::addColumn<QImage::Format>("format");
+
+    QTest::newRow("RGB32") << QImage::Format_RGB32;
+    QTest::newRow("ARGB32") << QImage::Format_ARGB32;
+    QTest::newRow("ARGB32_Premultiplied") << QImage::Format_ARGB32_Premultiplied;
+    QTest::newRow("Grayscale8") << QImage::Format_Grayscale8;
+}
+
+void ImageBoundingBoxTest::testBoundingBox()
+{
+    QFETCH(QImage::Format, format);
+
+    QImage image( 200, 100, QImage::Format_RGB32 );
+    image.fill( Okular::SettingsCore::paperColor() );
+    {
+        QPainter painter( &image );
+        painter.fillRect( 20, 10, 30, 5, Qt::black );
+        painter.fillRect( 120, 60, 40, 20, Qt::black );
+    }
+    image = image.convertToFormat( format );
+
+    const Okular::NormalizedRect bbox = Okular::Utils::imageBoundingBox( &image );
+    QCOMPARE( bbox, Okular::NormalizedRect( QRect( 20, 10, 140, 70 ), 200, 100 ) );
+}
+
+void ImageBoundingBoxTest::testBlankImage()
+{
+    QImage image( 50, 50, QImage::Format_RGB32 );
+    image.fill( Okular::SettingsCore::paperColor() );
+
+    QCOMPARE( Okular::Utils::imageBoundingBox( &image ), Okular::NormalizedRect( 0, 0, 0, 0 ) );
+}
+
+void ImageBoundingBoxTest::testTranslucentPremultiplied()
+{
+    // translucent paper is not ink, even though its premultiplied color
+    // differs from the paper color
+    QColor translucentPaper = Okular::SettingsCore::paperColor();
+    translucentPaper.setAlpha( 128 );
+
+    QImage image( 200, 100, QImage::Format_ARGB32_Premultiplied );
+    image.fill( translucentPaper );
+    {
+        QPainter painter( &image );
+        painter.fillRect( 20, 10, 30, 5, Qt::black );
+    }
+
+    const Okular::NormalizedRect bbox = Okular::Utils::imageBoundingBox( &image );
+    QCOMPARE( bbox, Okular::NormalizedRect( QRect( 20, 10, 30, 5 ), 200, 100 ) );
+}
+
+QTEST_MAIN( ImageBoundingBoxTest )
+#include "imageboundingboxtest.moc"
@@ -101,6 +101,7 @@ private:
 
 void KJSFunctionsTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("kjsfunctionstest") );
     m_document = new Okular::Document( nullptr );
 
@@ -599,6 +599,22 @@ void MainShellTest::testSessionRestore()
 
     QCOMPARE( numDocs, paths.size() );
     QCOMPARE( shells.size(), useTabsRestore ? numWindows : paths.size() );
+
+    // Only the active tab has opened its document, the others open it when
+    // they get activated
+    for ( Shell* shell : qAsConst(shells) )
+    {
+        const int activeTab = shell->m_tabWidget->currentIndex();
+        for ( int i = 0; i < shell->m_tabs.size(); ++i )
+            QCOMPARE( shell->m_tabs[i].part->url().isEmpty(), i != activeTab );
+
+        if ( shell->m_tabs.size() > 1 )
+        {
+            const int otherTab = activeTab == 0 ? 1 : 0;
+            shell->setActiveTab( otherTab );
+            QVERIFY( !shell->m_tabs[otherTab].part->url().isEmpty() );
+        }
+    }
 }
 
 void MainShellTest::testMiddleButtonCloseUndo()
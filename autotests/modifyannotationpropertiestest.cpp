@@ -40,6 +40,7 @@ private:
 
 void ModifyAnnotationPropertiesTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("editannotationcontentstest") );
     m_document = new Okular::Document( nullptr );
 }
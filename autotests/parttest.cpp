@@ -1986,6 +1986,7 @@ int main(int argc, char *argv[])
     qputenv("HOME", homePath);
     qputenv("XDG_DATA_HOME", homePath + "/.local");
     qputenv("XDG_CONFIG_HOME", homePath + "/.kde-unit-test/xdg/config");
+    qputenv("XDG_CACHE_HOME", homePath + "/.cache");
 
     // Disable fancy debug output
     qunsetenv("QT_MESSAGE_PATTERN");
@@ -0,0 +1,101 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QMutex>
+#include <QPrinter>
+#include <QTemporaryDir>
+
+#include "../core/rasterprinter.h"
+
+class RasterPrinterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPrintToFile();
+    void testSkippedPages();
+};
+
+void RasterPrinterTest::testPrintToFile()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+
+    QPrinter printer;
+    printer.setOutputFormat( QPrinter::PdfFormat );
+    printer.setOutputFileName( dir.filePath( QStringLiteral( "out.pdf" ) ) );
+    printer.setResolution( 72 );
+
+    QMutex mutex;
+    QList<int> renderedPages;
+    QAtomicInt rendering;
+    int maxRendering = 0;
+
+    Okular::RasterPrinter rasterPrinter( [&]( int page, QRectF *targetRect ) {
+        const int running = rendering.fetchAndAddOrdered( 1 ) + 1;
+        QThread::msleep( 10 );
+
+        QImage image( 100, 150, QImage::Format_RGB32 );
+        image.fill( Qt::white );
+        *targetRect = QRectF( 0, 0, 50, 75 );
+
+        QMutexLocker locker( &mutex );
+        renderedPages.append( page );
+        maxRendering = qMax( maxRendering, running );
+        rendering.fetchAndAddOrdered( -1 );
+        return image;
+    } );
+    rasterPrinter.setMaxPagesInFlight( 3 );
+
+    QList<int> pageList;
+    for ( int i = 1; i <= 20; ++i )
+        pageList.append( i );
+
+    QVERIFY( rasterPrinter.print( printer, pageList ) );
+    QVERIFY( !rasterPrinter.wasCanceled() );
+
+    std::sort( renderedPages.begin(), renderedPages.end() );
+    QList<int> expectedPages;
+    for ( int i = 0; i < 20; ++i )
+        expectedPages.append( i );
+    QCOMPARE( renderedPages, expectedPages );
+    QVERIFY( maxRendering <= 3 );
+
+    QFileInfo output( printer.outputFileName() );
+    QVERIFY( output.exists() );
+    QVERIFY( output.size() > 0 );
+}
+
+void RasterPrinterTest::testSkippedPages()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+
+    QPrinter printer;
+    printer.setOutputFormat( QPrinter::PdfFormat );
+    printer.setOutputFileName( dir.filePath( QStringLiteral( "out.pdf" ) ) );
+
+    // every other page can not be rendered
+    Okular::RasterPrinter rasterPrinter( []( int page, QRectF * ) {
+        if ( page % 2 )
+            return QImage();
+
+        QImage image( 10, 10, QImage::Format_RGB32 );
+        image.fill( Qt::black );
+        return image;
+    } );
+
+    QVERIFY( rasterPrinter.print( printer, QList<int>() << 1 << 2 << 3 << 4 ) );
+    QVERIFY( QFileInfo::exists( printer.outputFileName() ) );
+}
+
+QTEST_MAIN( RasterPrinterTest )
+#include "rasterprintertest.moc"
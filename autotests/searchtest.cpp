@@ -48,11 +48,14 @@ class SearchTest : public QObject
         void testHyphenAtEndOfPage();
         void testOneColumn();
         void testTwoColumns();
+        void testDenseTwoColumns();
+        void benchmarkTextOrder();
 };
 
 void SearchTest::initTestCase()
 {
     qRegisterMetaType<Okular::Document::SearchStatus>();
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("searchtest") );
 }
 
@@ -423,5 +426,65 @@ void SearchTest::testTwoColumns()
   delete page;
 }
 
+// Builds a page of two columns of @p lines lines each, with 4 words of 4
+// characters per line. Every character is its own entity and they are handed
+// over bottom-up and right-to-left, so the layout analysis has to restore the
+// order. Returns the text expected after the layout analysis.
+static QString createDenseTwoColumns(int lines, QVector<QString>& text, QVector<Okular::NormalizedRect>& rect)
+{
+  const double charWidth = 0.01, charHeight = 0.015, lineStep = 0.03;
+  const double wordWidth = 4 * charWidth, wordStep = wordWidth + charWidth;
+  const double columnLeft[2] = { 0.05, 0.55 };
+
+  QString expected;
+  for (int column = 0; column < 2; ++column) {
+    for (int line = 0; line < lines; ++line) {
+      for (int word = 0; word < 4; ++word) {
+        if (word > 0)
+          expected += QLatin1Char(' ');
+        for (int c = 0; c < 4; ++c) {
+          const QChar ch = QLatin1Char((column ? 'A' : 'a') + (line + word * 4 + c) % 26);
+          expected += ch;
+
+          const double left = columnLeft[column] + word * wordStep;
+          const double top = 0.05 + line * lineStep;
+          text.prepend(QString(ch));
+          rect.prepend(Okular::NormalizedRect(left + c * charWidth, top, left + (c + 1) * charWidth, top + charHeight));
+        }
+      }
+    }
+  }
+  return expected;
+}
+
+void SearchTest::testDenseTwoColumns()
+{
+  //Tests that the layout analysis keeps the reading order of a page made of
+  //single characters: words are rebuilt, lines are sorted top to bottom and
+  //the two columns are read one after the other.
+
+  QVector<QString> text;
+  QVector<Okular::NormalizedRect> rect;
+  const QString expected = createDenseTwoColumns(20, text, rect);
+
+  CREATE_PAGE;
+
+  QCOMPARE(tp->text(), expected);
+
+  delete page;
+}
+
+void SearchTest::benchmarkTextOrder()
+{
+  QVector<QString> text;
+  QVector<Okular::NormalizedRect> rect;
+  createDenseTwoColumns(30, text, rect);
+
+  QBENCHMARK {
+    CREATE_PAGE;
+    delete page;
+  }
+}
+
 QTEST_MAIN( SearchTest )
 #include "searchtest.moc"
@@ -32,6 +32,7 @@ private:
 
 void SignatureFormTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("signatureformtest") );
     m_document = new Okular::Document( nullptr );
 }
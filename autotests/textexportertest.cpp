@@ -0,0 +1,68 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QTemporaryDir>
+
+#include "../core/textexporter.h"
+
+class TextExporterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testPageOrder();
+    void testWriteError();
+};
+
+void TextExporterTest::testPageOrder()
+{
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+
+    QAtomicInt extracting;
+    QAtomicInt maxExtracting;
+
+    // the later pages are extracted faster, so that they are ready before
+    // the earlier ones
+    Okular::TextExporter exporter( [&]( int page ) {
+        const int running = extracting.fetchAndAddOrdered( 1 ) + 1;
+        int max = maxExtracting.load();
+        while ( running > max && !maxExtracting.testAndSetOrdered( max, running ) )
+            max = maxExtracting.load();
+
+        QThread::msleep( 50 - page );
+        extracting.fetchAndAddOrdered( -1 );
+        return QStringLiteral( "page %1" ).arg( page );
+    } );
+    exporter.setMaxThreadCount( 4 );
+    exporter.setPageSeparator( QStringLiteral( "\n" ) );
+
+    const QString fileName = dir.filePath( QStringLiteral( "out.txt" ) );
+    QVERIFY( exporter.exportTo( fileName, 40 ) );
+    QVERIFY( !exporter.wasCanceled() );
+    QVERIFY( maxExtracting.load() <= 4 );
+
+    QFile file( fileName );
+    QVERIFY( file.open( QIODevice::ReadOnly ) );
+    QString expected;
+    for ( int i = 0; i < 40; ++i )
+        expected += QStringLiteral( "page %1\n" ).arg( i );
+    QCOMPARE( QString::fromUtf8( file.readAll() ), expected );
+}
+
+void TextExporterTest::testWriteError()
+{
+    Okular::TextExporter exporter( []( int ) { return QString(); } );
+    QVERIFY( !exporter.exportTo( QStringLiteral( "/nonexistent/dir/out.txt" ), 1 ) );
+}
+
+QTEST_MAIN( TextExporterTest )
+#include "textexportertest.moc"
@@ -66,6 +66,7 @@ private:
 
 void TranslateAnnotationTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("editannotationcontentstest") );
     m_document = new Okular::Document( nullptr );
 
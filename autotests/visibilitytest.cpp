@@ -40,6 +40,7 @@ private:
 
 void VisibilityTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("visibilitytest") );
     m_document = new Okular::Document( nullptr );
 
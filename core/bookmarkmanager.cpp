@@ -16,9 +16,11 @@
 #include <kbookmarkmanager.h>
 #include <kbookmarkmenu.h>
 #include <QDebug>
+#include <QDomDocument>
 #include <QGuiApplication>
 #include <QUrl>
 #include <QStandardPaths>
+#include <QTimer>
 
 // local includes
 #include "document_p.h"
@@ -75,27 +77,31 @@ static inline bool documentViewportFuzzyCompare( const DocumentViewport &vp1, co
     return true;
 }
 
-static inline bool bookmarkLessThan( const KBookmark &b1, const KBookmark &b2 )
+static inline bool okularBookmarkActionLessThan( QAction * a1, QAction * a2 )
 {
-    DocumentViewport vp1( b1.url().fragment(QUrl::FullyDecoded) );
-    DocumentViewport vp2( b2.url().fragment(QUrl::FullyDecoded) );
+    DocumentViewport vp1( static_cast< OkularBookmarkAction * >( a1 )->htmlRef() );
+    DocumentViewport vp2( static_cast< OkularBookmarkAction * >( a2 )->htmlRef() );
 
     return vp1 < vp2;
 }
 
-static inline bool okularBookmarkActionLessThan( QAction * a1, QAction * a2 )
+// a bookmark of the current url, with the viewport of its url
+struct IndexedBookmark
 {
-    DocumentViewport vp1( static_cast< OkularBookmarkAction * >( a1 )->htmlRef() );
-    DocumentViewport vp2( static_cast< OkularBookmarkAction * >( a2 )->htmlRef() );
+    DocumentViewport viewport;
+    KBookmark bookmark;
+};
 
-    return vp1 < vp2;
+static inline bool indexedBookmarkLessThan( const IndexedBookmark &b1, const IndexedBookmark &b2 )
+{
+    return b1.viewport < b2.viewport;
 }
 
 class BookmarkManager::Private : public KBookmarkOwner
 {
     public:
         Private( BookmarkManager * qq )
-            : KBookmarkOwner(), q( qq ), document( nullptr ), manager( nullptr )
+            : KBookmarkOwner(), q( qq ), document( nullptr ), manager( nullptr ), saveTimer( nullptr )
         {
         }
 
@@ -113,16 +119,35 @@ class BookmarkManager::Private : public KBookmarkOwner
 
         QHash<QUrl, QString>::iterator bookmarkFind( const QUrl& url, bool doCreate, KBookmarkGroup *result  = nullptr);
 
+        void indexBookmark( const KBookmark &bm );
+        void unindexBookmark( const KBookmark &bm );
+        QVector<IndexedBookmark>::const_iterator pageBegin( int page ) const;
+        QVector<IndexedBookmark>::const_iterator pageEnd( int page ) const;
+
+        // writes the bookmarks file a moment later, once for all the
+        // changes done meanwhile
+        void scheduleSave( const QUrl &groupUrl, const KBookmarkGroup &group );
+        void saveChangedGroups();
+        // puts the unsaved changes into the groups of a file parsed again
+        void restoreChangedGroups();
+
         // slots
         void _o_changed( const QString & groupAddress, const QString & caller );
 
         BookmarkManager * q;
         QUrl url;
         QHash<int,int> urlBookmarks;
+        // the bookmarks of the current url sorted by viewport
+        QVector<IndexedBookmark> urlIndex;
         DocumentPrivate * document;
         QString file;
         KBookmarkManager * manager;
         QHash<QUrl, QString> knownFiles;
+        // the groups with unsaved changes, by their url
+        QHash<QUrl, KBookmarkGroup> changedGroups;
+        QTimer * saveTimer;
+        // the document the bookmarks we hold belong to
+        QDomDocument parsedDocument;
 };
 
 static inline QUrl urlForGroup(const KBookmark &group)
@@ -148,10 +173,17 @@ BookmarkManager::BookmarkManager( DocumentPrivate * document )
     connect( d->manager, &KBookmarkManager::changed, this, [this](const QString & groupAddress, const QString & caller) {
         d->_o_changed(groupAddress, caller);
     });
+    d->parsedDocument = d->manager->root().internalElement().ownerDocument();
+
+    d->saveTimer = new QTimer( this );
+    d->saveTimer->setSingleShot( true );
+    d->saveTimer->setInterval( 250 );
+    connect( d->saveTimer, &QTimer::timeout, this, [this] { d->saveChangedGroups(); } );
 }
 
 BookmarkManager::~BookmarkManager()
 {
+    d->saveChangedGroups();
     delete d;
 }
 
@@ -178,44 +210,126 @@ void BookmarkManager::Private::openBookmark( const KBookmark & bm, Qt::MouseButt
 }
 //END Reimplementations from KBookmarkOwner
 
-void BookmarkManager::Private::_o_changed( const QString & groupAddress, const QString & caller )
+void BookmarkManager::Private::indexBookmark( const KBookmark &bm )
 {
-    Q_UNUSED( caller );
-    if ( groupAddress.isEmpty() )
+    IndexedBookmark entry{ DocumentViewport( bm.url().fragment(QUrl::FullyDecoded) ), bm };
+    if ( !entry.viewport.isValid() )
         return;
 
-    QUrl referurl;
-    // first, try to find the bookmark group whom change notification was just received
-    QHash<QUrl, QString>::iterator it = knownFiles.begin(), itEnd = knownFiles.end();
-    for ( ; it != itEnd; ++it )
+    // after the bookmarks at the same viewport, like when reading the group
+    urlIndex.insert( std::upper_bound( urlIndex.begin(), urlIndex.end(), entry, indexedBookmarkLessThan ), entry );
+}
+
+void BookmarkManager::Private::unindexBookmark( const KBookmark &bm )
+{
+    const DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
+    for ( QVector<IndexedBookmark>::iterator it = urlIndex.begin() + ( pageBegin( vp.pageNumber ) - urlIndex.constBegin() ); it != urlIndex.end(); ++it )
     {
-        if ( it.value() == groupAddress )
+        if ( it->bookmark == bm )
         {
-            referurl = it.key();
-            knownFiles.erase( it );
-            break;
+            urlIndex.erase( it );
+            return;
         }
     }
-    if ( !referurl.isValid() )
+}
+
+QVector<IndexedBookmark>::const_iterator BookmarkManager::Private::pageBegin( int page ) const
+{
+    return std::lower_bound( urlIndex.constBegin(), urlIndex.constEnd(), page,
+        []( const IndexedBookmark &b, int p ) { return b.viewport.pageNumber < p; } );
+}
+
+QVector<IndexedBookmark>::const_iterator BookmarkManager::Private::pageEnd( int page ) const
+{
+    return std::upper_bound( urlIndex.constBegin(), urlIndex.constEnd(), page,
+        []( int p, const IndexedBookmark &b ) { return p < b.viewport.pageNumber; } );
+}
+
+void BookmarkManager::Private::scheduleSave( const QUrl &groupUrl, const KBookmarkGroup &group )
+{
+    changedGroups.insert( groupUrl, group );
+    saveTimer->start();
+}
+
+void BookmarkManager::Private::saveChangedGroups()
+{
+    saveTimer->stop();
+    const QHash<QUrl, KBookmarkGroup> groups = changedGroups;
+    changedGroups.clear();
+    for ( const KBookmarkGroup &group : groups )
+        manager->emitChanged( group );
+}
+
+void BookmarkManager::Private::restoreChangedGroups()
+{
+    const QHash<QUrl, KBookmarkGroup> oldGroups = changedGroups;
+    changedGroups.clear();
+    for ( QHash<QUrl, KBookmarkGroup>::const_iterator it = oldGroups.constBegin(), itEnd = oldGroups.constEnd(); it != itEnd; ++it )
     {
-        const KBookmark bm = manager->findByAddress( groupAddress );
-        // better be safe than sorry
-        if ( bm.isNull() )
-            return;
-        Q_ASSERT( bm.isGroup() );
-        referurl = urlForGroup( bm );
+        KBookmarkGroup group;
+        bookmarkFind( it.key(), true, &group );
+
+        // the changed group wins over the one in the file
+        QDomElement element = group.internalElement();
+        while ( !element.firstChild().isNull() )
+            element.removeChild( element.firstChild() );
+        const QDomElement oldElement = it.value().internalElement();
+        for ( QDomNode n = oldElement.firstChild(); !n.isNull(); n = n.nextSibling() )
+            element.appendChild( element.ownerDocument().importNode( n, true ) );
+
+        changedGroups.insert( it.key(), group );
     }
-    Q_ASSERT( referurl.isValid() );
-    emit q->bookmarksChanged( referurl );
-    // case for the url representing the current document
-    // (this might happen if the same document is open in another place;
-    // in such case, make really sure to be in sync)
-    if ( referurl == url )
+}
+
+void BookmarkManager::Private::_o_changed( const QString & groupAddress, const QString & caller )
+{
+    Q_UNUSED( caller );
+
+    // A change done by another process (like the same document open in
+    // another place) makes the manager parse the whole file again, the
+    // next time it is used. The addresses of the groups may have moved and
+    // the bookmarks we hold are the ones of the old file; our own changes
+    // only come back as a notification.
+    const QDomDocument currentDocument = manager->root().internalElement().ownerDocument();
+    const bool reparsed = currentDocument != parsedDocument;
+    if ( reparsed )
+    {
+        knownFiles.clear();
+        // the changes not saved yet are still in the old file, save them
+        // now before any other process overwrites them
+        restoreChangedGroups();
+        parsedDocument = currentDocument;
+        saveChangedGroups();
+    }
+
+    QUrl referurl;
+    if ( !groupAddress.isEmpty() )
+    {
+        // first, try to find the bookmark group whom change notification was just received
+        QHash<QUrl, QString>::const_iterator it = knownFiles.constBegin(), itEnd = knownFiles.constEnd();
+        for ( ; it != itEnd; ++it )
+        {
+            if ( it.value() == groupAddress )
+            {
+                referurl = it.key();
+                break;
+            }
+        }
+        if ( !referurl.isValid() )
+        {
+            const KBookmark bm = manager->findByAddress( groupAddress );
+            // better be safe than sorry
+            if ( bm.isGroup() )
+                referurl = urlForGroup( bm );
+        }
+    }
+
+    if ( reparsed || referurl == url )
     {
         // save the old bookmarks for the current url
         const QHash<int,int> oldUrlBookmarks = urlBookmarks;
         // set the same url again, so we reload the information we have about it
-        q->setUrl( referurl );
+        q->setUrl( url );
         // then notify the observers about the changes in the bookmarks
         for ( int i = 0; i < qMax( oldUrlBookmarks.size(), urlBookmarks.size() ); i++ )
         {
@@ -230,9 +344,13 @@ void BookmarkManager::Private::_o_changed( const QString & groupAddress, const Q
             {
                 foreachObserverD( notifyPageChanged( i, DocumentObserver::Bookmark ) );
             }
-
         }
     }
+
+    if ( !referurl.isValid() )
+        return;
+
+    emit q->bookmarksChanged( referurl );
     emit q->saved();
 }
 
@@ -280,54 +398,31 @@ KBookmark::List BookmarkManager::bookmarks() const
 
 KBookmark::List BookmarkManager::bookmarks( int page ) const
 {
-    const KBookmark::List bmarks = bookmarks();
     KBookmark::List ret;
-    for ( const KBookmark &bm : bmarks )
-    {
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp.isValid() && vp.pageNumber == page )
-        {
-            ret.append(bm);
-        }
-    }
+    for ( QVector<IndexedBookmark>::const_iterator it = d->pageBegin( page ), end = d->pageEnd( page ); it != end; ++it )
+        ret.append( it->bookmark );
 
     return ret;
 }
 
 KBookmark BookmarkManager::bookmark( int page ) const
 {
-    const KBookmark::List bmarks = bookmarks();
-    for ( const KBookmark &bm : bmarks )
-    {
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp.isValid() && vp.pageNumber == page )
-        {
-            return bm;
-        }
-    }
+    const QVector<IndexedBookmark>::const_iterator it = d->pageBegin( page );
+    if ( it != d->urlIndex.constEnd() && it->viewport.pageNumber == page )
+        return it->bookmark;
+
     return KBookmark();
 }
 
 KBookmark BookmarkManager::bookmark( const DocumentViewport &viewport ) const
 {
-    if ( !viewport.isValid() || !isBookmarked( viewport.pageNumber ) )
+    if ( !viewport.isValid() )
         return KBookmark();
 
-    KBookmarkGroup thebg;
-    QHash<QUrl, QString>::iterator it = d->bookmarkFind( d->url, false, &thebg );
-    if ( it == d->knownFiles.end() )
-        return KBookmark();
-
-    for ( KBookmark bm = thebg.first(); !bm.isNull(); bm = thebg.next( bm ) )
+    for ( QVector<IndexedBookmark>::const_iterator it = d->pageBegin( viewport.pageNumber ), end = d->pageEnd( viewport.pageNumber ); it != end; ++it )
     {
-        if ( bm.isSeparator() || bm.isGroup() )
-            continue;
-
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( documentViewportFuzzyCompare( vp, viewport ) )
-        {
-            return bm;
-        }
+        if ( documentViewportFuzzyCompare( it->viewport, viewport ) )
+            return it->bookmark;
     }
 
     return KBookmark();
@@ -335,6 +430,7 @@ KBookmark BookmarkManager::bookmark( const DocumentViewport &viewport ) const
 
 void BookmarkManager::save() const
 {
+    d->saveChangedGroups();
     d->manager->emitChanged();
     emit const_cast<BookmarkManager*>( this )->saved();
 }
@@ -451,13 +547,15 @@ bool BookmarkManager::addBookmark(const QUrl &referurl, const Okular::DocumentVi
 
     QUrl newurl = referurl;
     newurl.setFragment(vp.toString(), QUrl::DecodedMode);
-    thebg.addBookmark( newtitle, newurl, QString() );
+    const KBookmark newbm = thebg.addBookmark( newtitle, newurl, QString() );
+    if ( referurl == d->url )
+        d->indexBookmark( newbm );
     if ( referurl == d->document->m_url )
     {
         d->urlBookmarks[ vp.pageNumber ]++;
         foreachObserver( notifyPageChanged( vp.pageNumber, DocumentObserver::Bookmark ) );
     }
-    d->manager->emitChanged( thebg );
+    d->scheduleSave( referurl, thebg );
     return true;
 }
 
@@ -488,7 +586,7 @@ void BookmarkManager::renameBookmark( KBookmark* bm, const QString& newName)
         return;
 
     bm->setFullText( newName );
-    d->manager->emitChanged( thebg );
+    d->scheduleSave( d->url, thebg );
 }
 
 void BookmarkManager::renameBookmark(const QUrl &referurl, const QString& newName )
@@ -503,7 +601,7 @@ void BookmarkManager::renameBookmark(const QUrl &referurl, const QString& newNam
         return;
 
     thebg.setFullText( newName );
-    d->manager->emitChanged( thebg );
+    d->scheduleSave( referurl, thebg );
 }
 
 QString BookmarkManager::titleForUrl(const QUrl &referurl ) const
@@ -529,6 +627,8 @@ int BookmarkManager::removeBookmark(const QUrl &referurl, const KBookmark& bm )
     if ( it == d->knownFiles.end() )
         return -1;
 
+    if ( referurl == d->url )
+        d->unindexBookmark( bm );
     thebg.deleteBookmark( bm );
 
     if ( referurl == d->document->m_url )
@@ -536,7 +636,7 @@ int BookmarkManager::removeBookmark(const QUrl &referurl, const KBookmark& bm )
         d->urlBookmarks[ vp.pageNumber ]--;
         foreachObserver( notifyPageChanged( vp.pageNumber, DocumentObserver::Bookmark ) );
     }
-    d->manager->emitChanged( thebg );
+    d->scheduleSave( referurl, thebg );
 
     return vp.pageNumber;
 }
@@ -557,6 +657,8 @@ void BookmarkManager::removeBookmarks(const QUrl &referurl, const KBookmark::Lis
     {
         if ( bm.parentGroup() == thebg )
         {
+            if ( referurl == d->url )
+                d->unindexBookmark( bm );
             thebg.deleteBookmark( bm );
             deletedAny = true;
 
@@ -586,7 +688,7 @@ void BookmarkManager::removeBookmarks(const QUrl &referurl, const KBookmark::Lis
         }
     }
     if ( deletedAny )
-        d->manager->emitChanged( thebg );
+        d->scheduleSave( referurl, thebg );
 }
 
 QList< QAction * > BookmarkManager::actionsForUrl(const QUrl &url ) const
@@ -616,6 +718,7 @@ void BookmarkManager::setUrl(const QUrl &url )
 {
     d->url = url;
     d->urlBookmarks.clear();
+    d->urlIndex.clear();
     KBookmarkGroup thebg;
     QHash<QUrl, QString>::iterator it = d->bookmarkFind( url, false, &thebg );
     if ( it != d->knownFiles.end() )
@@ -630,7 +733,9 @@ void BookmarkManager::setUrl(const QUrl &url )
                 continue;
 
             d->urlBookmarks[ vp.pageNumber ]++;
+            d->urlIndex.append( IndexedBookmark{ vp, bm } );
         }
+        std::stable_sort( d->urlIndex.begin(), d->urlIndex.end(), indexedBookmarkLessThan );
     }
 }
 
@@ -640,28 +745,17 @@ bool BookmarkManager::setPageBookmark( int page )
     QHash<QUrl, QString>::iterator it = d->bookmarkFind( d->url, true, &thebg );
     Q_ASSERT( it != d->knownFiles.end() );
 
-    bool found = false;
     bool added = false;
-    for ( KBookmark bm = thebg.first(); !found && !bm.isNull(); bm = thebg.next( bm ) )
-    {
-        if ( bm.isSeparator() || bm.isGroup() )
-            continue;
-
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp.isValid() && vp.pageNumber == page )
-            found = true;
-
-    }
-    if ( !found )
+    if ( d->pageBegin( page ) == d->pageEnd( page ) )
     {
         d->urlBookmarks[ page ]++;
         DocumentViewport vp;
         vp.pageNumber = page;
         QUrl newurl = d->url;
         newurl.setFragment(vp.toString(), QUrl::DecodedMode);
-        thebg.addBookmark( QLatin1String( "#" ) + QString::number( vp.pageNumber + 1 ), newurl, QString() );
+        d->indexBookmark( thebg.addBookmark( QLatin1String( "#" ) + QString::number( vp.pageNumber + 1 ), newurl, QString() ) );
         added = true;
-        d->manager->emitChanged( thebg );
+        d->scheduleSave( d->url, thebg );
     }
     return added;
 }
@@ -673,22 +767,15 @@ bool BookmarkManager::removePageBookmark( int page )
     if ( it == d->knownFiles.end() )
         return false;
 
-    bool found = false;
-    for ( KBookmark bm = thebg.first(); !found && !bm.isNull(); bm = thebg.next( bm ) )
-    {
-        if ( bm.isSeparator() || bm.isGroup() )
-            continue;
+    const KBookmark bm = bookmark( page );
+    if ( bm.isNull() )
+        return false;
 
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp.isValid() && vp.pageNumber == page )
-        {
-            found = true;
-            thebg.deleteBookmark( bm );
-            d->urlBookmarks[ page ]--;
-            d->manager->emitChanged( thebg );
-        }
-    }
-    return found;
+    d->unindexBookmark( bm );
+    thebg.deleteBookmark( bm );
+    d->urlBookmarks[ page ]--;
+    d->scheduleSave( d->url, thebg );
+    return true;
 }
 
 bool BookmarkManager::isBookmarked( int page ) const
@@ -705,41 +792,18 @@ bool BookmarkManager::isBookmarked( const DocumentViewport &viewport ) const
 
 KBookmark BookmarkManager::nextBookmark( const DocumentViewport &viewport) const
 {
-    KBookmark::List bmarks = bookmarks();
-    std::sort(bmarks.begin(), bmarks.end(), bookmarkLessThan);
-
-    KBookmark bookmark;
-    for ( const KBookmark &bm : qAsConst(bmarks) )
-    {
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( viewport < vp )
-        {
-            bookmark = bm;
-            break;
-        }
-    }
+    const QVector<IndexedBookmark>::const_iterator it = std::upper_bound( d->urlIndex.constBegin(), d->urlIndex.constEnd(), viewport,
+        []( const DocumentViewport &vp, const IndexedBookmark &b ) { return vp < b.viewport; } );
 
-    return bookmark;
+    return it != d->urlIndex.constEnd() ? it->bookmark : KBookmark();
 }
 
 KBookmark BookmarkManager::previousBookmark( const DocumentViewport &viewport ) const
 {
-    KBookmark::List bmarks = bookmarks();
-    std::sort(bmarks.begin(), bmarks.end(), bookmarkLessThan);
-
-    KBookmark bookmark;
-    for ( KBookmark::List::const_iterator it = bmarks.constEnd(); it != bmarks.constBegin(); --it )
-    {
-        KBookmark bm = *(it-1);
-        DocumentViewport vp( bm.url().fragment(QUrl::FullyDecoded) );
-        if ( vp < viewport )
-        {
-            bookmark = bm;
-            break;
-        }
-    }
+    const QVector<IndexedBookmark>::const_iterator it = std::lower_bound( d->urlIndex.constBegin(), d->urlIndex.constEnd(), viewport,
+        []( const IndexedBookmark &b, const DocumentViewport &vp ) { return b.viewport < vp; } );
 
-    return bookmark;
+    return it != d->urlIndex.constBegin() ? ( it - 1 )->bookmark : KBookmark();
 }
 
 #undef foreachObserver
@@ -16,6 +16,7 @@
 #include "documentcommands_p.h"
 
 #include <limits.h>
+#include <algorithm>
 #include <memory>
 #ifdef Q_OS_WIN
 #define _WIN32_WINNT 0x0500
@@ -28,10 +29,12 @@
 
 // qt/kde/system includes
 #include <QtAlgorithms>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
 #include <QMap>
+#include <QMutexLocker>
 #include <qtemporaryfile.h>
 #include <QTextStream>
 #include <QTimer>
@@ -44,6 +47,7 @@
 #include <QMimeDatabase>
 #include <QDesktopServices>
 #include <QPageSize>
+#include <QScopedValueRollback>
 #include <QStandardPaths>
 
 #include <kauthorized.h>
@@ -74,18 +78,24 @@
 #include "interfaces/configinterface.h"
 #include "interfaces/guiinterface.h"
 #include "interfaces/printinterface.h"
+#include "interfaces/reloadinterface.h"
 #include "interfaces/saveinterface.h"
 #include "observer.h"
 #include "misc.h"
 #include "page.h"
 #include "page_p.h"
 #include "pagecontroller_p.h"
+#include "pixmapbudget_p.h"
 #include "scripter.h"
 #include "script/event_p.h"
 #include "settings_core.h"
 #include "sourcereference.h"
 #include "sourcereference_p.h"
+#include "synctexloader_p.h"
+#include "textdocumentgenerator.h"
+#include "textdocumentsettings.h"
 #include "texteditors_p.h"
+#include "textpagecache_p.h"
 #include "tile.h"
 #include "tilesmanager_p.h"
 #include "utils_p.h"
@@ -217,29 +227,31 @@ QString DocumentPrivate::localizedSize(const QSizeF &size) const
 
 qulonglong DocumentPrivate::calculateMemoryToFree()
 {
-    // [MEM] choose memory parameters based on configuration profile
+    // [MEM] choose memory parameters based on configuration profile, the
+    // pixmaps of all the open documents count
     qulonglong clipValue = 0;
     qulonglong memoryToFree = 0;
+    const qulonglong allocatedPixmapsTotalMemory = PixmapBudget::self()->totalMemory();
 
     switch ( SettingsCore::memoryLevel() )
     {
         case SettingsCore::EnumMemoryLevel::Low:
-            memoryToFree = m_allocatedPixmapsTotalMemory;
+            memoryToFree = allocatedPixmapsTotalMemory;
             break;
 
         case SettingsCore::EnumMemoryLevel::Normal:
         {
             qulonglong thirdTotalMemory = getTotalMemory() / 3;
             qulonglong freeMemory = getFreeMemory();
-            if (m_allocatedPixmapsTotalMemory > thirdTotalMemory) memoryToFree = m_allocatedPixmapsTotalMemory - thirdTotalMemory;
-            if (m_allocatedPixmapsTotalMemory > freeMemory) clipValue = (m_allocatedPixmapsTotalMemory - freeMemory) / 2;
+            if (allocatedPixmapsTotalMemory > thirdTotalMemory) memoryToFree = allocatedPixmapsTotalMemory - thirdTotalMemory;
+            if (allocatedPixmapsTotalMemory > freeMemory) clipValue = (allocatedPixmapsTotalMemory - freeMemory) / 2;
         }
         break;
 
         case SettingsCore::EnumMemoryLevel::Aggressive:
         {
             qulonglong freeMemory = getFreeMemory();
-            if (m_allocatedPixmapsTotalMemory > freeMemory) clipValue = (m_allocatedPixmapsTotalMemory - freeMemory) / 2;
+            if (allocatedPixmapsTotalMemory > freeMemory) clipValue = (allocatedPixmapsTotalMemory - freeMemory) / 2;
         }
         break;
         case SettingsCore::EnumMemoryLevel::Greedy:
@@ -247,7 +259,7 @@ qulonglong DocumentPrivate::calculateMemoryToFree()
             qulonglong freeSwap;
             qulonglong freeMemory = getFreeMemory( &freeSwap );
             const qulonglong memoryLimit = qMin( qMax( freeMemory, getTotalMemory()/2 ), freeMemory+freeSwap );
-            if (m_allocatedPixmapsTotalMemory > memoryLimit) clipValue = (m_allocatedPixmapsTotalMemory - memoryLimit) / 2;
+            if (allocatedPixmapsTotalMemory > memoryLimit) clipValue = (allocatedPixmapsTotalMemory - memoryLimit) / 2;
         }
         break;
     }
@@ -265,8 +277,15 @@ void DocumentPrivate::cleanupPixmapMemory()
 
 void DocumentPrivate::cleanupPixmapMemory( qulonglong memoryToFree )
 {
-    if ( memoryToFree < 1 )
-        return;
+    PixmapBudget::self()->freeMemory( memoryToFree, this );
+}
+
+qulonglong DocumentPrivate::releasePixmapMemory( qulonglong memoryToFree )
+{
+    if ( memoryToFree < 1 || m_pagesVector.isEmpty() )
+        return 0;
+
+    const qulonglong memoryBefore = m_allocatedPixmapsTotalMemory;
 
     const int currentViewportPage = (*m_viewportIterator).pageNumber;
 
@@ -347,6 +366,8 @@ void DocumentPrivate::cleanupPixmapMemory( qulonglong memoryToFree )
 
     m_allocatedPixmaps += pixmapsToKeep;
     //p--rintf("freeMemory A:[%d -%d = %d] \n", m_allocatedPixmaps.count() + pagesFreed, pagesFreed, m_allocatedPixmaps.count() );
+
+    return memoryBefore - m_allocatedPixmapsTotalMemory;
 }
 
 /* Returns the next pixmap to evict from cache, or NULL if no suitable pixmap
@@ -659,6 +680,57 @@ bool DocumentPrivate::loadDocumentInfo( QFile &infoFile, LoadDocumentInfoFlags l
                         viewNode = viewNode.nextSibling();
                     }
                 }
+                // restore the fonts found the last time, so they need not be read again
+                else if ( infoElement.tagName() == QLatin1String("fonts") && m_generator && m_generator->hasFeature( Generator::FontInfo ) )
+                {
+                    m_fontsCache.clear();
+                    QDomNode fontNode = infoNode.firstChild();
+                    while ( fontNode.isElement() )
+                    {
+                        const QDomElement fontElement = fontNode.toElement();
+                        if ( fontElement.tagName() == QLatin1String("font") )
+                        {
+                            FontInfo font;
+                            font.setName( fontElement.attribute( QStringLiteral("name") ) );
+                            font.setSubstituteName( fontElement.attribute( QStringLiteral("substituteName") ) );
+                            font.setType( (FontInfo::FontType)fontElement.attribute( QStringLiteral("type") ).toInt() );
+                            font.setEmbedType( (FontInfo::EmbedType)fontElement.attribute( QStringLiteral("embedType") ).toInt() );
+                            font.setFile( fontElement.attribute( QStringLiteral("file") ) );
+                            font.setCanBeExtracted( fontElement.attribute( QStringLiteral("canBeExtracted") ) == QLatin1String("true") );
+                            m_fontsCache.append( font );
+                        }
+                        fontNode = fontNode.nextSibling();
+                    }
+                    m_fontsCached = true;
+                    loadedAnything = true;
+                }
+                // restore the bounding boxes found the last time, unless the
+                // paper color they were computed against, the generator or
+                // its layout changed
+                else if ( infoElement.tagName() == QLatin1String("boundingBoxes") &&
+                          infoElement.attribute( QStringLiteral("rotation") ).toInt() == (int)m_rotation &&
+                          QColor( infoElement.attribute( QStringLiteral("paperColor") ) ) == SettingsCore::paperColor() &&
+                          infoElement.attribute( QStringLiteral("fingerprint") ) == boundingBoxesFingerprint() )
+                {
+                    QDomNode boxNode = infoNode.firstChild();
+                    while ( boxNode.isElement() )
+                    {
+                        const QDomElement boxElement = boxNode.toElement();
+                        bool ok;
+                        const int pageNumber = boxElement.attribute( QStringLiteral("number") ).toInt( &ok );
+                        if ( boxElement.tagName() == QLatin1String("page") && ok && pageNumber >= 0 && pageNumber < m_pagesVector.count() )
+                        {
+                            const NormalizedRect bbox( boxElement.attribute( QStringLiteral("l") ).toDouble(),
+                                                       boxElement.attribute( QStringLiteral("t") ).toDouble(),
+                                                       boxElement.attribute( QStringLiteral("r") ).toDouble(),
+                                                       boxElement.attribute( QStringLiteral("b") ).toDouble() );
+                            if ( bbox.left >= 0 && bbox.top >= 0 && bbox.right <= 1 && bbox.bottom <= 1 )
+                                m_pagesVector[ pageNumber ]->setBoundingBox( bbox );
+                        }
+                        boxNode = boxNode.nextSibling();
+                    }
+                    loadedAnything = true;
+                }
                 infoNode = infoNode.nextSibling();
             }
         }
@@ -1181,72 +1253,73 @@ void DocumentPrivate::performSetAnnotationContents( const QString & newContents,
     performModifyPageAnnotation( pageNumber,  annot, appearanceChanged );
 }
 
-void DocumentPrivate::recalculateForms()
+void DocumentPrivate::recalculateForms( const QList< FormField * > &changedFields )
 {
-    const QVariant fco = m_parent->metaData(QStringLiteral("FormCalculateOrder"));
-    const QVector<int> formCalculateOrder = fco.value<QVector<int>>();
-    foreach(int formId, formCalculateOrder) {
-        for ( uint pageIdx = 0; pageIdx  < m_parent->pages(); pageIdx++ )
+    if ( !m_formCalculation.isBuilt() )
+    {
+        const QVariant fco = m_parent->metaData(QStringLiteral("FormCalculateOrder"));
+        m_formCalculation.build( m_pagesVector, fco.value<QVector<int>>() );
+    }
+
+    // only the fields reading the changed ones, directly or through other
+    // calculated fields, need to run their calculate script
+    const QVector<int> fieldsToCalculate = m_formCalculation.fieldsToCalculate( changedFields );
+    QSet<int> pagesNeedingRefresh;
+    for ( int formId : fieldsToCalculate )
+    {
+        FormField *form = m_formCalculation.field( formId );
+        const int pageIdx = m_formCalculation.pageNumber( formId );
+        if ( !form )
+            continue;
+
+        Action *action = form->additionalAction( FormField::CalculateField );
+        if ( !action )
+        {
+            qWarning() << "Form that is part of calculate order doesn't have a calculate action";
+            continue;
+        }
+
+        FormFieldText *fft = dynamic_cast< FormFieldText * >( form );
+        std::shared_ptr<Event> event;
+        QString oldVal;
+        if ( fft )
+        {
+            // Prepare text calculate event
+            event = Event::createFormCalculateEvent( fft, m_pagesVector[pageIdx] );
+            if ( !m_scripter )
+                m_scripter = new Scripter( this );
+            m_scripter->setEvent( event.get() );
+            // The value maybe changed in javascript so save it first.
+            oldVal = fft->text();
+        }
+
+        m_parent->processAction( action );
+        if ( event && fft )
         {
-            const Page *p = m_parent->page( pageIdx );
-            if (p)
+            // Update text field from calculate
+            m_scripter->setEvent( nullptr );
+            const QString newVal = event->value().toString();
+            if ( newVal != oldVal )
             {
-                bool pageNeedsRefresh = false;
-                foreach( FormField *form, p->formFields() )
+                fft->setText( newVal );
+                if ( const Okular::Action *action = fft->additionalAction( Okular::FormField::FormatField ) )
                 {
-                    if ( form->id() == formId ) {
-                        Action *action = form->additionalAction( FormField::CalculateField );
-                        if (action)
-                        {
-                            FormFieldText *fft = dynamic_cast< FormFieldText * >( form );
-                            std::shared_ptr<Event> event;
-                            QString oldVal;
-                            if ( fft )
-                            {
-                                // Prepare text calculate event
-                                event = Event::createFormCalculateEvent( fft, m_pagesVector[pageIdx] );
-                                if ( !m_scripter )
-                                    m_scripter = new Scripter( this );
-                                m_scripter->setEvent( event.get() );
-                                // The value maybe changed in javascript so save it first.
-                                oldVal = fft->text();
-                            }
-
-                            m_parent->processAction( action );
-                            if ( event && fft )
-                            {
-                                // Update text field from calculate
-                                m_scripter->setEvent( nullptr );
-                                const QString newVal = event->value().toString();
-                                if ( newVal != oldVal )
-                                {
-                                    fft->setText( newVal );
-                                    if ( const Okular::Action *action = fft->additionalAction( Okular::FormField::FormatField ) )
-                                    {
-                                        // The format action handles the refresh.
-                                        m_parent->processFormatAction( action, fft );
-                                    }
-                                    else
-                                    {
-                                        emit m_parent->refreshFormWidget( fft );
-                                        pageNeedsRefresh = true;
-                                    }
-                                }
-                            }
-                        }
-                        else
-                        {
-                            qWarning() << "Form that is part of calculate order doesn't have a calculate action";
-                        }
-                    }
+                    // The format action handles the refresh.
+                    m_parent->processFormatAction( action, fft );
                 }
-                if ( pageNeedsRefresh )
+                else
                 {
-                    refreshPixmaps( p->number() );
+                    emit m_parent->refreshFormWidget( fft );
+                    pagesNeedingRefresh.insert( pageIdx );
                 }
             }
         }
     }
+
+    for ( int pageIdx : qAsConst( pagesNeedingRefresh ) )
+    {
+        refreshPixmaps( pageIdx );
+    }
 }
 
 void DocumentPrivate::saveDocumentInfo() const
@@ -1334,6 +1407,49 @@ void DocumentPrivate::saveDocumentInfo() const
         viewsNode.appendChild( viewEntry );
         saveViewsInfo( view, viewEntry );
     }
+    // create fonts node, only once all of them have been read
+    if ( m_fontsCached )
+    {
+        QDomElement fontsNode = doc.createElement( QStringLiteral("fonts") );
+        generalInfo.appendChild( fontsNode );
+        for ( const FontInfo &font : m_fontsCache )
+        {
+            QDomElement fontEntry = doc.createElement( QStringLiteral("font") );
+            fontEntry.setAttribute( QStringLiteral("name"), font.name() );
+            if ( !font.substituteName().isEmpty() )
+                fontEntry.setAttribute( QStringLiteral("substituteName"), font.substituteName() );
+            fontEntry.setAttribute( QStringLiteral("type"), (int)font.type() );
+            fontEntry.setAttribute( QStringLiteral("embedType"), (int)font.embedType() );
+            if ( !font.file().isEmpty() )
+                fontEntry.setAttribute( QStringLiteral("file"), font.file() );
+            fontEntry.setAttribute( QStringLiteral("canBeExtracted"), font.canBeExtracted() ? QStringLiteral("true") : QStringLiteral("false") );
+            fontsNode.appendChild( fontEntry );
+        }
+    }
+    // create bounding boxes node, so that trimming the margins does not have
+    // to wait for the pages to be rendered the next time
+    QDomElement boxesNode = doc.createElement( QStringLiteral("boundingBoxes") );
+    for ( const Page *page : qAsConst(m_pagesVector) )
+    {
+        if ( !page->isBoundingBoxKnown() )
+            continue;
+
+        const NormalizedRect bbox = page->boundingBox();
+        QDomElement boxEntry = doc.createElement( QStringLiteral("page") );
+        boxEntry.setAttribute( QStringLiteral("number"), page->number() );
+        boxEntry.setAttribute( QStringLiteral("l"), bbox.left );
+        boxEntry.setAttribute( QStringLiteral("t"), bbox.top );
+        boxEntry.setAttribute( QStringLiteral("r"), bbox.right );
+        boxEntry.setAttribute( QStringLiteral("b"), bbox.bottom );
+        boxesNode.appendChild( boxEntry );
+    }
+    if ( boxesNode.hasChildNodes() )
+    {
+        boxesNode.setAttribute( QStringLiteral("rotation"), (int)m_rotation );
+        boxesNode.setAttribute( QStringLiteral("paperColor"), SettingsCore::paperColor().name() );
+        boxesNode.setAttribute( QStringLiteral("fingerprint"), boundingBoxesFingerprint() );
+        generalInfo.appendChild( boxesNode );
+    }
 
     // 3. Save DOM to XML file
     QString xml = doc.toString();
@@ -1347,7 +1463,7 @@ void DocumentPrivate::slotTimedMemoryCheck()
 {
     // [MEM] clean memory (for 'free mem dependent' profiles only)
     if ( SettingsCore::memoryLevel() != SettingsCore::EnumMemoryLevel::Low &&
-         m_allocatedPixmapsTotalMemory > 1024*1024 )
+         PixmapBudget::self()->totalMemory() > 1024*1024 )
         cleanupPixmapMemory();
 }
 
@@ -1541,6 +1657,9 @@ void DocumentPrivate::sendGeneratorPixmapRequest()
         // we can not really know if the generator can do async requests
         m_executingPixmapRequests.push_back( request );
         m_pixmapRequestsMutex.unlock();
+        // no need for the generator to extract the text if we have it cached
+        if ( !request->page()->hasTextPage() )
+            loadCachedTextPage( request->page() );
         m_generator->generatePixmap( request );
     }
     else
@@ -1575,12 +1694,10 @@ void DocumentPrivate::slotFontReadingProgress( int page )
 
 void DocumentPrivate::fontReadingGotFont( const Okular::FontInfo& font )
 {
-    // Try to avoid duplicate fonts
-    if (m_fontsCache.indexOf(font) == -1) {
-        m_fontsCache.append( font );
+    // the extraction thread already skips duplicate fonts
+    m_fontsCache.append( font );
 
-        emit m_parent->gotFont( font );
-    }
+    emit m_parent->gotFont( font );
 }
 
 void DocumentPrivate::slotGeneratorConfigChanged()
@@ -1601,6 +1718,10 @@ void DocumentPrivate::slotGeneratorConfigChanged()
                 configchanged = true;
         }
     }
+    // the text may be laid out differently now, it belongs to another cache
+    if ( m_textPageCache )
+        openTextPageCache();
+
     if ( configchanged )
     {
         // invalidate pixmaps
@@ -1624,6 +1745,65 @@ void DocumentPrivate::slotGeneratorConfigChanged()
         cleanupPixmapMemory();
 }
 
+void DocumentPrivate::setPages( const QVector< Page * > &pages )
+{
+    const int count = pages.count();
+
+    // nothing may use the pages going away anymore: the text generation
+    // thread is not waited for by clearAndWaitForRequests(), and its result
+    // is delivered to the page through a queued call
+    clearAndWaitForRequests();
+    if ( TextPageGenerationThread *textThread = m_generator->d_ptr->mTextPageGenerationThread )
+    {
+        textThread->wait();
+        QCoreApplication::sendPostedEvents( m_generator, QEvent::MetaCall );
+    }
+
+    // forget the pixmaps and the text of the pages going away
+    QLinkedList< AllocatedPixmap * >::iterator aIt = m_allocatedPixmaps.begin();
+    while ( aIt != m_allocatedPixmaps.end() )
+    {
+        if ( (*aIt)->page >= count )
+        {
+            m_allocatedPixmapsTotalMemory -= (*aIt)->memory;
+            delete *aIt;
+            aIt = m_allocatedPixmaps.erase( aIt );
+        }
+        else
+            ++aIt;
+    }
+    m_allocatedTextPagesFifo.erase( std::remove_if( m_allocatedTextPagesFifo.begin(), m_allocatedTextPagesFifo.end(),
+                                                    [count]( int page ) { return page >= count; } ),
+                                    m_allocatedTextPagesFifo.end() );
+
+    const QVector< Page * > oldPages = m_pagesVector;
+    m_pagesVector = pages;
+    for ( Page *p : qAsConst(m_pagesVector) )
+        p->d->m_doc = this;
+
+    // the undo commands and the form fields may refer to the pages going away
+    if ( count < oldPages.count() )
+    {
+        m_undoStack->clear();
+        m_formCalculation.clear();
+        if ( m_scripter )
+            m_scripter->clearCachedFields();
+    }
+
+    QLinkedList< DocumentViewport >::iterator vIt = m_viewportHistory.begin(), vEnd = m_viewportHistory.end();
+    for ( ; vIt != vEnd; ++vIt )
+    {
+        if ( (*vIt).pageNumber >= count )
+            (*vIt).pageNumber = count - 1;
+    }
+
+    foreachObserverD( notifySetup( m_pagesVector, DocumentObserver::DocumentChanged ) );
+
+    // the observers let go of the pages going away only now
+    for ( int i = count; i < oldPages.count(); ++i )
+        delete oldPages.at( i );
+}
+
 void DocumentPrivate::refreshPixmaps( int pageNumber )
 {
     Page* page = m_pagesVector.value( pageNumber, 0 );
@@ -2129,6 +2309,84 @@ struct pdfsyncpoint
     int page;
 };
 
+QByteArray DocumentPrivate::layoutConfiguration() const
+{
+    // text documents are laid out with the settings of the generator, so
+    // they are part of what identifies the text and the look of the pages
+    QByteArray configuration;
+    if ( TextDocumentGenerator *textGenerator = qobject_cast< TextDocumentGenerator * >( m_generator ) )
+    {
+        const KConfigSkeletonItem::List items = textGenerator->generalSettings()->items();
+        for ( const KConfigSkeletonItem *item : items )
+        {
+            const QVariant value = item->property();
+            configuration += item->key().toUtf8() + '=';
+            configuration += ( value.type() == QVariant::Font ? value.value< QFont >().toString() : value.toString() ).toUtf8() + '\n';
+        }
+    }
+    return configuration;
+}
+
+QString DocumentPrivate::boundingBoxesFingerprint() const
+{
+    // the bounding boxes depend on what renders the pages, and on how the
+    // pages are laid out
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    hash.addData( m_generatorName.toUtf8() );
+    hash.addData( layoutConfiguration() );
+    hash.addData( QByteArray::number( m_pagesVector.count() ) );
+    return QString::fromLatin1( hash.result().toHex() );
+}
+
+void DocumentPrivate::openTextPageCache()
+{
+    delete m_textPageCache;
+    m_textPageCache = nullptr;
+
+    const QByteArray fingerprint = TextPageCache::fingerprint( m_docFileName, m_generatorName, layoutConfiguration() );
+    m_textPageCache = new TextPageCache( TextPageCache::cacheFileName( fingerprint ), fingerprint, m_pagesVector.count() );
+    if ( !m_textPageCache->isValid() )
+    {
+        delete m_textPageCache;
+        m_textPageCache = nullptr;
+    }
+}
+
+void DocumentPrivate::loadSynctex( const QString & docFile )
+{
+    // owned by the document too, which waits for it if it is still
+    // running once the document goes away
+    SynctexLoader *loader = new SynctexLoader( docFile, m_pagesVector.count(), m_parent );
+    m_synctex = loader;
+
+    // the pdfsync file is only used without SyncTeX data
+    QObject::connect( loader, &QThread::finished, loader, [this, loader, docFile] {
+        bool hasScanner;
+        {
+            QMutexLocker locker( loader->mutex() );
+            hasScanner = loader->scanner();
+        }
+        if ( m_synctex == loader && !hasScanner && QFile::exists( docFile + QLatin1String( "sync" ) ) )
+        {
+            unloadSynctex();
+            loadSyncFile( docFile );
+        }
+    } );
+}
+
+void DocumentPrivate::unloadSynctex()
+{
+    if ( !m_synctex )
+        return;
+
+    // don't wait for a scanner nobody needs anymore, the loader deletes
+    // itself once done, or together with the document
+    QObject::connect( m_synctex, &QThread::finished, m_synctex, &QObject::deleteLater );
+    if ( m_synctex->wait( 0 ) )
+        delete m_synctex;
+    m_synctex = nullptr;
+}
+
 void DocumentPrivate::loadSyncFile( const QString & filePath )
 {
     QFile f( filePath + QLatin1String( "sync" ) );
@@ -2319,6 +2577,7 @@ Document::Document( QWidget *widget )
     d->m_bookmarkManager = new BookmarkManager( d );
     d->m_viewportIterator = d->m_viewportHistory.insert( d->m_viewportHistory.end(), DocumentViewport() );
     d->m_undoStack = new QUndoStack(this);
+    PixmapBudget::self()->registerDocument( d );
 
     connect( SettingsCore::self(), &SettingsCore::configChanged, this, [this] { d->_o_configChanged(); } );
     connect(d->m_undoStack, &QUndoStack::canUndoChanged, this, &Document::canUndoChanged);
@@ -2332,6 +2591,7 @@ Document::~Document()
 {
     // delete generator, pages, and related stuff
     closeDocument();
+    PixmapBudget::self()->unregisterDocument( d );
 
     QSet< View * >::const_iterator viewIt = d->m_views.constBegin(), viewEnd = d->m_views.constEnd();
     for ( ; viewIt != viewEnd; ++viewIt )
@@ -2609,11 +2869,7 @@ Document::OpenResult Document::openDocument(const QString & docFile, const QUrl
 
     // no need to check for the existence of a synctex file, no parser will be
     // created if none exists
-    d->m_synctex_scanner = synctex_scanner_new_with_output_file( QFile::encodeName( docFile ).constData(), nullptr, 1);
-    if ( !d->m_synctex_scanner && QFile::exists(docFile + QLatin1String( "sync" ) ) )
-    {
-        d->loadSyncFile(docFile);
-    }
+    d->loadSynctex( docFile );
 
     d->m_generatorName = offer.pluginId();
     d->m_pageController = new PageController();
@@ -2623,6 +2879,12 @@ Document::OpenResult Document::openDocument(const QString & docFile, const QUrl
     for ( Page *p : qAsConst(d->m_pagesVector) )
         p->d->m_doc = d;
 
+    // text pages of local documents are cached on disk across sessions
+    if ( SettingsCore::cacheTextPages() && !d->m_archiveData && !fromFileDescriptor && d->m_generator->hasFeature( Generator::TextExtraction ) )
+    {
+        d->openTextPageCache();
+    }
+
     d->m_metadataLoadingCompleted = false;
     d->m_docdataMigrationNeeded = false;
 
@@ -2770,11 +3032,10 @@ void Document::closeDocument()
         d->m_generator->closeDocument();
     }
 
-    if ( d->m_synctex_scanner )
-    {
-        synctex_scanner_free( d->m_synctex_scanner );
-        d->m_synctex_scanner = nullptr;
-    }
+    d->unloadSynctex();
+
+    delete d->m_textPageCache;
+    d->m_textPageCache = nullptr;
 
     // stop timers
     if ( d->m_memCheckTimer )
@@ -2819,6 +3080,7 @@ void Document::closeDocument()
     for ( ; pIt != pEnd; ++pIt )
         delete *pIt;
     d->m_pagesVector.clear();
+    d->m_formCalculation.clear();
 
     // clear 'memory allocation' descriptors
     qDeleteAll( d->m_allocatedPixmaps );
@@ -2897,6 +3159,7 @@ void Document::removeObserver( DocumentObserver * pObserver )
             if ( p->observer == pObserver )
             {
                 aIt = d->m_allocatedPixmaps.erase( aIt );
+                d->m_allocatedPixmapsTotalMemory -= p->memory;
                 delete p;
             }
             else
@@ -2954,6 +3217,11 @@ bool Document::isOpened() const
     return d->m_generator;
 }
 
+bool Document::isBusy() const
+{
+    return d->m_busy;
+}
+
 bool Document::canConfigurePrinter( ) const
 {
     if ( d->m_generator )
@@ -3174,6 +3442,7 @@ bool Document::exportToText( const QString& fileName ) const
     if ( d->m_exportToText.isNull() )
         return false;
 
+    QScopedValueRollback<bool> busy( d->m_busy, true );
     return d->m_generator->exportTo( fileName, d->m_exportToText );
 }
 
@@ -3188,7 +3457,11 @@ ExportFormat::List Document::exportFormats() const
 
 bool Document::exportTo( const QString& fileName, const ExportFormat& format ) const
 {
-    return d->m_generator ? d->m_generator->exportTo( fileName, format ) : false;
+    if ( !d->m_generator )
+        return false;
+
+    QScopedValueRollback<bool> busy( d->m_busy, true );
+    return d->m_generator->exportTo( fileName, format );
 }
 
 bool Document::historyAtBegin() const
@@ -3207,7 +3480,7 @@ QVariant Document::metaData( const QString & key, const QVariant & option ) cons
     // source reference
     if ( key == QLatin1String("NamedViewport")
          && option.toString().startsWith( QLatin1String("src:"), Qt::CaseInsensitive )
-         && d->m_synctex_scanner)
+         && d->m_synctex)
     {
         const QString reference = option.toString();
 
@@ -3236,34 +3509,46 @@ QVariant Document::metaData( const QString & key, const QVariant & option ) cons
         int line = lineString.toInt( &ok );
         if (!ok) line = -1;
 
+        // the index has the first node of the lines, which is also the first
+        // hit of the scanner, that is only asked for the lines not in it
+        SynctexLoader::Position position;
+        bool found = d->m_synctex->findPosition( name, line, &position );
+
         // Use column == -1 for now.
-        if( synctex_display_query( d->m_synctex_scanner, QFile::encodeName(name).constData(), line, -1, 0 ) > 0 )
+        QMutexLocker locker( d->m_synctex->mutex() );
+        synctex_scanner_p scanner = found ? nullptr : d->m_synctex->scanner();
+        if( scanner && synctex_display_query( scanner, QFile::encodeName(name).constData(), line, -1, 0 ) > 0 )
         {
             synctex_node_p node;
             // For now use the first hit. Could possibly be made smarter
             // in case there are multiple hits.
-            while( ( node = synctex_scanner_next_result( d->m_synctex_scanner ) ) )
+            while( !found && ( node = synctex_scanner_next_result( scanner ) ) )
             {
-                Okular::DocumentViewport viewport;
-
                 // TeX pages start at 1.
-                viewport.pageNumber = synctex_node_page( node ) - 1;
+                position.page = synctex_node_page( node ) - 1;
+                position.h = synctex_node_visible_h( node );
+                position.v = synctex_node_visible_v( node );
+                found = position.page >= 0;
+            }
+        }
+        locker.unlock();
 
-                if ( viewport.pageNumber >= 0 )
-                {
-                    const QSizeF dpi = d->m_generator->dpi();
+        if ( found && position.page < (int)d->m_pagesVector.count() )
+        {
+            Okular::DocumentViewport viewport;
+            viewport.pageNumber = position.page;
 
-                    // TeX small points ...
-                    double px = (synctex_node_visible_h( node ) * dpi.width()) / 72.27;
-                    double py = (synctex_node_visible_v( node ) * dpi.height()) / 72.27;
-                    viewport.rePos.normalizedX = px / page(viewport.pageNumber)->width();
-                    viewport.rePos.normalizedY = ( py + 0.5 ) / page(viewport.pageNumber)->height();
-                    viewport.rePos.enabled = true;
-                    viewport.rePos.pos = Okular::DocumentViewport::Center;
+            const QSizeF dpi = d->m_generator->dpi();
 
-                    return viewport.toString();
-                }
-            }
+            // TeX small points ...
+            double px = (position.h * dpi.width()) / 72.27;
+            double py = (position.v * dpi.height()) / 72.27;
+            viewport.rePos.normalizedX = px / page(viewport.pageNumber)->width();
+            viewport.rePos.normalizedY = ( py + 0.5 ) / page(viewport.pageNumber)->height();
+            viewport.rePos.enabled = true;
+            viewport.rePos.pos = Okular::DocumentViewport::Center;
+
+            return viewport.toString();
         }
     }
     return d->m_generator ? d->m_generator->metaData( key, option ) : QVariant();
@@ -3400,6 +3685,8 @@ void Document::requestPixmaps( const QLinkedList< PixmapRequest * > & requests,
         return;
     }
 
+    PixmapBudget::self()->touch( d );
+
     QSet< DocumentObserver * > observersPixmapCleared;
 
     // 1. [CLEAN STACK] remove previous requests of requesterID
@@ -3542,6 +3829,9 @@ void Document::requestTextPage( uint pageNumber )
 
     // Memory management for TextPages
 
+    if ( d->loadCachedTextPage( kp ) )
+        return;
+
     d->m_generator->generateTextPage( kp );
 }
 
@@ -3550,9 +3840,9 @@ void DocumentPrivate::notifyAnnotationChanges( int page )
     foreachObserverD( notifyPageChanged( page, DocumentObserver::Annotations ) );
 }
 
-void DocumentPrivate::notifyFormChanges( int /*page*/ )
+void DocumentPrivate::notifyFormChanges( int /*page*/, const QList< FormField * > &changedFields )
 {
-    recalculateForms();
+    recalculateForms( changedFields );
 }
 
 void Document::addPageAnnotation( int page, Annotation * annotation )
@@ -3735,6 +4025,25 @@ void Document::setPageTextSelection( int page, RegularAreaRect * rect, const QCo
     foreachObserver( notifyPageChanged( page, DocumentObserver::TextSelection ) );
 }
 
+void Document::setPageHighlight( int page, int id, RegularAreaRect * rect, const QColor & color )
+{
+    Page * kp = d->m_pagesVector.value( page );
+    if ( !d->m_generator || !kp )
+    {
+        delete rect;
+        return;
+    }
+
+    kp->d->deleteHighlights( id );
+    if ( rect )
+    {
+        kp->d->setHighlight( id, rect, color );
+        delete rect;
+    }
+
+    foreachObserver( notifyPageChanged( page, DocumentObserver::Highlights ) );
+}
+
 bool Document::canUndo() const
 {
     return d->m_undoStack->canUndo();
@@ -3773,6 +4082,11 @@ void Document::setViewportPage( int page, DocumentObserver *excludeObserver, boo
 }
 
 void Document::setViewport( const DocumentViewport & viewport, DocumentObserver *excludeObserver, bool smoothMove )
+{
+    setViewportWithHistory( viewport, excludeObserver, smoothMove, true );
+}
+
+void Document::setViewportWithHistory( const DocumentViewport & viewport, DocumentObserver *excludeObserver, bool smoothMove, bool updateHistory )
 {
     if ( !viewport.isValid() )
     {
@@ -3794,7 +4108,7 @@ void Document::setViewport( const DocumentViewport & viewport, DocumentObserver
     const int oldPageNumber = oldViewport.pageNumber;
 
     // set internal viewport taking care of history
-    if ( oldViewport.pageNumber == viewport.pageNumber || !oldViewport.isValid() )
+    if ( oldViewport.pageNumber == viewport.pageNumber || !oldViewport.isValid() || !updateHistory )
     {
         // if page is unchanged save the viewport at current position in queue
         oldViewport = viewport;
@@ -4104,7 +4418,15 @@ void Document::editFormCombo( int pageNumber,
 
 void Document::editFormButtons( int pageNumber, const QList< FormFieldButton* >& formButtons, const QList< bool >& newButtonStates )
 {
-    QUndoCommand *uc = new EditFormButtonsCommand( this->d, pageNumber, formButtons, newButtonStates );
+    QList< int > buttonPageNumbers;
+    for ( int i = 0; i < formButtons.size(); ++i )
+        buttonPageNumbers.append( pageNumber );
+    editFormButtonsOnPages( pageNumber, buttonPageNumbers, formButtons, newButtonStates );
+}
+
+void Document::editFormButtonsOnPages( int pageNumber, const QList< int >& buttonPageNumbers, const QList< FormFieldButton* >& formButtons, const QList< bool >& newButtonStates )
+{
+    QUndoCommand *uc = new EditFormButtonsCommand( this->d, pageNumber, buttonPageNumbers, formButtons, newButtonStates );
     d->m_undoStack->push( uc );
 }
 
@@ -4582,16 +4904,22 @@ void Document::processSourceReference( const SourceReference * ref )
 
 const SourceReference * Document::dynamicSourceReference( int pageNr, double absX, double absY )
 {
-    if  ( !d->m_synctex_scanner )
+    if ( !d->m_synctex )
+        return nullptr;
+
+    // waits for the scanner if it is still being parsed
+    QMutexLocker locker( d->m_synctex->mutex() );
+    synctex_scanner_p scanner = d->m_synctex->scanner();
+    if  ( !scanner )
         return nullptr;
 
     const QSizeF dpi = d->m_generator->dpi();
 
-    if (synctex_edit_query(d->m_synctex_scanner, pageNr + 1, absX * 72. / dpi.width(), absY * 72. / dpi.height()) > 0)
+    if (synctex_edit_query(scanner, pageNr + 1, absX * 72. / dpi.width(), absY * 72. / dpi.height()) > 0)
     {
         synctex_node_p node;
         // TODO what should we do if there is really more than one node?
-        while (( node = synctex_scanner_next_result( d->m_synctex_scanner ) ))
+        while (( node = synctex_scanner_next_result( scanner ) ))
         {
             int line = synctex_node_line(node);
             int col = synctex_node_column(node);
@@ -4600,7 +4928,7 @@ const SourceReference * Document::dynamicSourceReference( int pageNr, double abs
             {
                 col = 0;
             }
-            const char *name = synctex_scanner_get_name( d->m_synctex_scanner, synctex_node_tag( node ) );
+            const char *name = synctex_scanner_get_name( scanner, synctex_node_tag( node ) );
 
             return new Okular::SourceReference( QFile::decodeName( name ), line, col );
         }
@@ -4637,7 +4965,11 @@ bool Document::supportsPrintToFile() const
 
 bool Document::print( QPrinter &printer )
 {
-    return d->m_generator ? d->m_generator->print( printer ) : false;
+    if ( !d->m_generator )
+        return false;
+
+    QScopedValueRollback<bool> busy( d->m_busy, true );
+    return d->m_generator->print( printer );
 }
 
 QString Document::printError() const
@@ -4888,6 +5220,11 @@ bool Document::swapBackingFile( const QString &newFileName, const QUrl &url )
                 oldPage->m_rects = newPage->m_rects;
             }
             qDeleteAll( newPagesVector );
+
+            // the form fields are the ones of the new pages now
+            d->m_formCalculation.clear();
+            if ( d->m_scripter )
+                d->m_scripter->clearCachedFields();
         }
 
         d->m_url = url;
@@ -4897,14 +5234,10 @@ bool Document::swapBackingFile( const QString &newFileName, const QUrl &url )
         d->m_documentInfo = DocumentInfo();
         d->m_documentInfoAskedKeys.clear();
 
-        if ( d->m_synctex_scanner )
+        if ( d->m_synctex )
         {
-            synctex_scanner_free( d->m_synctex_scanner );
-            d->m_synctex_scanner = synctex_scanner_new_with_output_file( QFile::encodeName( newFileName ).constData(), nullptr, 1);
-            if ( !d->m_synctex_scanner && QFile::exists(newFileName + QLatin1String( "sync" ) ) )
-            {
-                d->loadSyncFile(newFileName);
-            }
+            d->unloadSynctex();
+            d->loadSynctex( newFileName );
         }
 
         foreachObserver( notifySetup( d->m_pagesVector, DocumentObserver::UrlChanged ) );
@@ -4921,6 +5254,41 @@ bool Document::swapBackingFile( const QString &newFileName, const QUrl &url )
     }
 }
 
+bool Document::reloadDocumentInPlace()
+{
+    if ( !d->m_generator || d->m_busy || d->m_archiveData || d->m_docFileName.isEmpty() )
+        return false;
+
+    Okular::ReloadInterface * iface = qobject_cast< Okular::ReloadInterface * >( d->m_generator );
+    if ( !iface )
+        return false;
+
+    d->clearAndWaitForRequests();
+
+    const DocumentViewport viewport = *d->m_viewportIterator;
+    const int pageCount = d->m_pagesVector.count();
+    if ( !iface->reloadDocument( d->m_docFileName ) )
+        return false;
+
+    // the document info and the cached text are the ones of the old file
+    d->updateMetadataXmlNameAndDocSize();
+    d->m_documentInfo = DocumentInfo();
+    d->m_documentInfoAskedKeys.clear();
+
+    if ( d->m_textPageCache )
+        d->openTextPageCache();
+
+    // the observers were set up again if the page count changed
+    if ( viewport.isValid() && pageCount != d->m_pagesVector.count() )
+    {
+        DocumentViewport newViewport = viewport;
+        newViewport.pageNumber = qMin( newViewport.pageNumber, d->m_pagesVector.count() - 1 );
+        setViewport( newViewport );
+    }
+
+    return true;
+}
+
 bool Document::swapBackingFileArchive( const QString &newFileName, const QUrl &url )
 {
     qCDebug(OkularCoreDebug) << "Swapping backing archive to" << newFileName;
@@ -5487,6 +5855,24 @@ void DocumentPrivate::textGenerationDone( Page *page )
 
     // 2. Add the page to the fifo of generated text pages
     m_allocatedTextPagesFifo.append( page->number() );
+
+    // 3. Remember its layout for the next time the document is opened
+    if ( m_textPageCache && page->d->m_text && !m_textPageCache->contains( page->number() ) )
+        m_textPageCache->store( page->number(), page->d->m_text );
+}
+
+bool DocumentPrivate::loadCachedTextPage( Page *page )
+{
+    if ( !m_textPageCache || !m_textPageCache->contains( page->number() ) )
+        return false;
+
+    TextPage *textPage = m_textPageCache->textPage( page->number() );
+    if ( !textPage )
+        return false;
+
+    page->setTextPage( textPage );
+    textGenerationDone( page );
+    return true;
 }
 
 void Document::setRotation( int r )
@@ -66,6 +66,8 @@ class SignatureInfo;
 #define PAGEVIEW_SEARCH_ID 2
 #define SW_SEARCH_ID 3
 #define PRESENTATION_SEARCH_ID 4
+/** ID for the highlight of the sentence being read aloud. **/
+#define TTS_HIGHLIGHT_ID 5
 
 /**
  * The DocumentInfo structure can be filled in by generators to display
@@ -246,6 +248,15 @@ class OKULARCORE_EXPORT Document : public QObject
          */
         bool isOpened() const;
 
+        /**
+         * Returns whether the document is being printed or exported. Events
+         * are processed meanwhile, the document must not be closed nor
+         * reloaded until it is done.
+         *
+         * @since 1.10
+         */
+        bool isBusy() const;
+
         /**
          * Returns the meta data of the document.
          */
@@ -434,6 +445,18 @@ class OKULARCORE_EXPORT Document : public QObject
          */
         void setViewport( const DocumentViewport &viewport, DocumentObserver *excludeObserver = nullptr, bool smoothMove = false );
 
+        /**
+         * Sets the current document viewport to the given @p viewport.
+         *
+         * @param viewport The document viewport.
+         * @param excludeObserver The observer which shouldn't be effected by this change.
+         * @param smoothMove Whether the move shall be animated smoothly.
+         * @param updateHistory Whether the move shall be recorded in the viewport history,
+         *                      otherwise it replaces the current entry.
+         * @since 1.11
+         */
+        void setViewportWithHistory( const DocumentViewport &viewport, DocumentObserver *excludeObserver = nullptr, bool smoothMove = false, bool updateHistory = true );
+
         /**
          * Sets the current document viewport to the next viewport in the
          * viewport history.
@@ -590,6 +613,20 @@ class OKULARCORE_EXPORT Document : public QObject
          */
         void setPageTextSelection( int page, RegularAreaRect * rect, const QColor & color );
 
+        /**
+         * Clears the highlights with the given @p id of the given @p page,
+         * creates a new one if @p rect is not nullptr, and deletes @p rect.
+         * Unlike setPageTextSelection() this leaves the text selection
+         * of the user alone.
+         *
+         * @param page The number of the page.
+         * @param id The id of the highlight, which must not be used by a search.
+         * @param rect The area to highlight.
+         * @param color The color of the highlight.
+         * @since 1.11
+         */
+        void setPageHighlight( int page, int id, RegularAreaRect * rect, const QColor & color );
+
         /**
          * Returns true if there is an undo command available; otherwise returns false.
          * @since 0.17 (KDE 4.11)
@@ -801,6 +838,19 @@ class OKULARCORE_EXPORT Document : public QObject
          */
         bool swapBackingFile( const QString &newFileName, const QUrl &url );
 
+        /**
+         * Reloads the document from its file, which changed, without closing
+         * it: the viewport, the observers and the pixmaps of the pages whose
+         * content did not change are kept.
+         *
+         * Returns false when the generator does not implement
+         * ReloadInterface or the file could not be read again, the document
+         * must then be closed and opened again.
+         *
+         * @since 1.10
+         */
+        bool reloadDocumentInPlace();
+
         /**
          * Same as swapBackingFile, but newFileName must be a .okular file.
          *
@@ -1052,6 +1102,18 @@ class OKULARCORE_EXPORT Document : public QObject
                               const QList< Okular::FormFieldButton* > & formButtons,
                               const QList< bool > & newButtonStates );
 
+        /**
+         * Set the states of the group of form buttons @p formButtons to @p newButtonStates,
+         * like editFormButtons(), for a group whose buttons lie on several pages.
+         * @p buttonPageNumbers holds the page of each entry of @p formButtons, and
+         * @p pageNumber is the page the change was made on.
+         * @since 1.11
+         */
+        void editFormButtonsOnPages( int pageNumber,
+                                     const QList< int > & buttonPageNumbers,
+                                     const QList< Okular::FormFieldButton* > & formButtons,
+                                     const QList< bool > & newButtonStates );
+
         /**
          * Reloads the pixmaps for whole document
          *
@@ -1261,6 +1323,13 @@ class OKULARCORE_EXPORT Document : public QObject
          * @since 1.4
          */
         void refreshFormWidget( Okular::FormField *field );
+
+        /**
+         * This signal is emitted whenever the document synopsis changed
+         * while the pages stayed the same, e.g. after reloadDocumentInPlace().
+         * @since 1.10
+         */
+        void documentSynopsisChanged();
     private:
         /// @cond PRIVATE
         friend class DocumentPrivate;
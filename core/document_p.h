@@ -14,7 +14,6 @@
 #include "document.h"
 #include "script/event_p.h"
 
-#include "synctex/synctex_parser.h"
 #include <memory>
 
 // qt/kde/system includes
@@ -29,6 +28,7 @@
 
 // local includes
 #include "fontinfo.h"
+#include "formcalculation_p.h"
 #include "generator.h"
 
 class QUndoStack;
@@ -48,6 +48,8 @@ class ConfigInterface;
 class PageController;
 class SaveInterface;
 class Scripter;
+class SynctexLoader;
+class TextPageCache;
 class View;
 }
 
@@ -127,7 +129,9 @@ class DocumentPrivate
             m_annotationEditingEnabled ( true ),
             m_annotationBeingModified( false ),
             m_docdataMigrationNeeded( false ),
-            m_synctex_scanner( nullptr )
+            m_busy( false ),
+            m_synctex( nullptr ),
+            m_textPageCache( nullptr )
         {
             calculateMaxTextPages();
         }
@@ -140,6 +144,7 @@ class DocumentPrivate
         qulonglong calculateMemoryToFree();
         void cleanupPixmapMemory();
         void cleanupPixmapMemory( qulonglong memoryToFree );
+        qulonglong releasePixmapMemory( qulonglong memoryToFree );
         AllocatedPixmap * searchLowestPriorityPixmap( bool unloadableOnly = false, bool thenRemoveIt = false, DocumentObserver *observer = nullptr /* any */ );
         void calculateMaxTextPages();
         qulonglong getTotalMemory();
@@ -163,7 +168,7 @@ class DocumentPrivate
         bool savePageDocumentInfo( QTemporaryFile *infoFile, int what ) const;
         DocumentViewport nextDocumentViewport() const;
         void notifyAnnotationChanges( int page );
-        void notifyFormChanges( int page );
+        void notifyFormChanges( int page, const QList< FormField * > &changedFields );
         bool canAddAnnotationsNatively() const;
         bool canModifyExternalAnnotations() const;
         bool canRemoveExternalAnnotations() const;
@@ -176,7 +181,14 @@ class DocumentPrivate
         void performModifyPageAnnotation( int page, Annotation * annotation, bool appearanceChanged );
         void performSetAnnotationContents( const QString & newContents, Annotation *annot, int pageNumber );
 
-        void recalculateForms();
+        void recalculateForms( const QList< FormField * > &changedFields );
+
+        /**
+         * Replaces the pages by @p pages, which start with the current pages
+         * when there are more of them: the pending requests are waited for,
+         * the pages going away are deleted and the observers set up again.
+         */
+        void setPages( const QVector< Page * > &pages );
 
         // private slots
         void saveDocumentInfo() const;
@@ -208,6 +220,11 @@ class DocumentPrivate
          */
         void requestDone( PixmapRequest * request );
         void textGenerationDone( Page *page );
+        /**
+         * Gives @p page its text page from the on-disk text cache, if there.
+         * Returns whether the page got it.
+         */
+        bool loadCachedTextPage( Page *page );
         /**
          * Sets the bounding box of the given @p page (in terms of upright orientation, i.e., Rotation0).
          */
@@ -225,8 +242,28 @@ class DocumentPrivate
          */
         bool isNormalizedRectangleFullyVisible( const Okular::NormalizedRect & rectOfInterest, int rectPage );
 
+        /**
+         * (Re)opens the on-disk cache of the text pages of the document,
+         * which depends on the file and on the layout settings of the generator.
+         */
+        void openTextPageCache();
+
+        /**
+         * Returns the layout settings of the generator, for the caches
+         * depending on them.
+         */
+        QByteArray layoutConfiguration() const;
+
+        /**
+         * Returns what identifies the bounding boxes kept in the docdata:
+         * the generator, its layout settings and the page count.
+         */
+        QString boundingBoxesFingerprint() const;
+
         // For sync files
         void loadSyncFile( const QString & filePath );
+        void loadSynctex( const QString & docFile );
+        void unloadSynctex();
 
         void clearAndWaitForRequests();
 
@@ -337,7 +374,19 @@ class DocumentPrivate
         // for the current document contains any annotation or form.
         bool m_docdataMigrationNeeded;
 
-        synctex_scanner_p m_synctex_scanner;
+        // set while the generator prints or exports the document, it
+        // processes events meanwhile and must not be closed under its threads
+        bool m_busy;
+
+        // SyncTeX data, loaded in a thread
+        SynctexLoader *m_synctex;
+
+        // on-disk cache of the laid out text pages
+        TextPageCache *m_textPageCache;
+
+        // form fields by id and what their calculate scripts read,
+        // built on the first recalculation
+        FormCalculation m_formCalculation;
 
         // generator selection
         static QVector<KPluginMetaData> availableGenerators();
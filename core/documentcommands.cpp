@@ -507,7 +507,7 @@ void EditFormTextCommand::undo()
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     m_form->setText( m_prevContents );
     emit m_docPriv->m_parent->formTextChangedByUndoRedo( m_pageNumber, m_form, m_prevContents, m_prevCursorPos, m_prevAnchorPos );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QList< FormField * >() << m_form );
 }
 
 void EditFormTextCommand::redo()
@@ -515,7 +515,7 @@ void EditFormTextCommand::redo()
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     m_form->setText( m_newContents  );
     emit m_docPriv->m_parent->formTextChangedByUndoRedo( m_pageNumber, m_form, m_newContents, m_newCursorPos, m_newCursorPos );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QList< FormField * >() << m_form );
 }
 
 int EditFormTextCommand::id() const
@@ -564,7 +564,7 @@ void EditFormListCommand::undo()
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     m_form->setCurrentChoices( m_prevChoices );
     emit m_docPriv->m_parent->formListChangedByUndoRedo( m_pageNumber, m_form, m_prevChoices );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QList< FormField * >() << m_form );
 }
 
 void EditFormListCommand::redo()
@@ -572,7 +572,7 @@ void EditFormListCommand::redo()
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     m_form->setCurrentChoices( m_newChoices );
     emit m_docPriv->m_parent->formListChangedByUndoRedo( m_pageNumber, m_form, m_newChoices );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QList< FormField * >() << m_form );
 }
 
 bool EditFormListCommand::refreshInternalPageReferences( const QVector< Page * > &newPagesVector )
@@ -627,7 +627,7 @@ void EditFormComboCommand::undo()
     }
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     emit m_docPriv->m_parent->formComboChangedByUndoRedo( m_pageNumber, m_form, m_prevContents, m_prevCursorPos, m_prevAnchorPos );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QList< FormField * >() << m_form );
 }
 
 void EditFormComboCommand::redo()
@@ -642,7 +642,7 @@ void EditFormComboCommand::redo()
     }
     moveViewportIfBoundingRectNotFullyVisible( m_form->rect(), m_docPriv, m_pageNumber );
     emit m_docPriv->m_parent->formComboChangedByUndoRedo( m_pageNumber, m_form, m_newContents, m_newCursorPos, m_newCursorPos );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    m_docPriv->notifyFormChanges( m_pageNumber, QList< FormField * >() << m_form );
 }
 
 int EditFormComboCommand::id() const
@@ -677,12 +677,24 @@ bool EditFormComboCommand::refreshInternalPageReferences( const QVector< Page *
 }
 
 
+static QList< FormField * > formFields( const QList< FormFieldButton * > &formButtons )
+{
+    QList< FormField * > fields;
+    for ( FormFieldButton *formButton : formButtons )
+    {
+        fields.append( formButton );
+    }
+    return fields;
+}
+
 EditFormButtonsCommand::EditFormButtonsCommand( Okular::DocumentPrivate* docPriv,
                                                 int pageNumber,
+                                                const QList< int > & buttonPageNumbers,
                                                 const QList< FormFieldButton* > & formButtons,
                                                 const QList< bool > & newButtonStates )
 : m_docPriv( docPriv ),
   m_pageNumber( pageNumber ),
+  m_buttonPageNumbers( buttonPageNumbers ),
   m_formButtons( formButtons ),
   m_newButtonStates( newButtonStates ),
   m_prevButtonStates( QList< bool >() )
@@ -704,10 +716,7 @@ void EditFormButtonsCommand::undo()
             m_formButtons.at( i )->setState( checked );
     }
 
-    Okular::NormalizedRect boundingRect = buildBoundingRectangleForButtons( m_formButtons );
-    moveViewportIfBoundingRectNotFullyVisible( boundingRect, m_docPriv, m_pageNumber );
-    emit m_docPriv->m_parent->formButtonsChangedByUndoRedo( m_pageNumber, m_formButtons );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    notifyButtonChanges();
 }
 
 void EditFormButtonsCommand::redo()
@@ -720,19 +729,17 @@ void EditFormButtonsCommand::redo()
             m_formButtons.at( i )->setState( checked );
     }
 
-    Okular::NormalizedRect boundingRect = buildBoundingRectangleForButtons( m_formButtons );
-    moveViewportIfBoundingRectNotFullyVisible( boundingRect, m_docPriv, m_pageNumber );
-    emit m_docPriv->m_parent->formButtonsChangedByUndoRedo( m_pageNumber, m_formButtons );
-    m_docPriv->notifyFormChanges( m_pageNumber );
+    notifyButtonChanges();
 }
 
 bool EditFormButtonsCommand::refreshInternalPageReferences( const QVector< Okular::Page * > &newPagesVector )
 {
     const QList< FormFieldButton* > oldFormButtons = m_formButtons;
     m_formButtons.clear();
-    for ( FormFieldButton *oldFormButton : oldFormButtons )
+    for ( int i = 0; i < oldFormButtons.size(); ++i )
     {
-        FormFieldButton *button = dynamic_cast<FormFieldButton *>(Okular::PagePrivate::findEquivalentForm( newPagesVector[m_pageNumber], oldFormButton ));
+        FormFieldButton *oldFormButton = oldFormButtons.at( i );
+        FormFieldButton *button = dynamic_cast<FormFieldButton *>(Okular::PagePrivate::findEquivalentForm( newPagesVector[m_buttonPageNumbers.at( i )], oldFormButton ));
         if ( !button )
             return false;
         m_formButtons << button;
@@ -749,5 +756,24 @@ void EditFormButtonsCommand::clearFormButtonStates()
     }
 }
 
+void EditFormButtonsCommand::notifyButtonChanges()
+{
+    // the buttons of a group may lie on several pages, the viewport only
+    // follows the ones of the page the change was made on
+    QMap< int, QList< FormFieldButton* > > pageButtons;
+    for ( int i = 0; i < m_formButtons.size(); i++ )
+    {
+        pageButtons[ m_buttonPageNumbers.at( i ) ].append( m_formButtons.at( i ) );
+    }
+
+    Okular::NormalizedRect boundingRect = buildBoundingRectangleForButtons( pageButtons.value( m_pageNumber ) );
+    moveViewportIfBoundingRectNotFullyVisible( boundingRect, m_docPriv, m_pageNumber );
+    for ( auto it = pageButtons.constBegin(); it != pageButtons.constEnd(); ++it )
+    {
+        emit m_docPriv->m_parent->formButtonsChangedByUndoRedo( it.key(), it.value() );
+    }
+    m_docPriv->notifyFormChanges( m_pageNumber, formFields( m_formButtons ) );
+}
+
 }
 
@@ -290,6 +290,7 @@ class EditFormButtonsCommand : public OkularUndoCommand
     public:
         EditFormButtonsCommand( Okular::DocumentPrivate* docPriv,
                                 int pageNumber,
+                                const QList< int > & buttonPageNumbers,
                                 const QList< FormFieldButton* > & formButtons,
                                 const QList< bool > & newButtonStates
                               );
@@ -301,10 +302,12 @@ class EditFormButtonsCommand : public OkularUndoCommand
 
     private:
         void clearFormButtonStates();
+        void notifyButtonChanges();
 
     private:
         Okular::DocumentPrivate* m_docPriv;
         int m_pageNumber;
+        QList< int > m_buttonPageNumbers;
         QList< FormFieldButton* > m_formButtons;
         QList< bool > m_newButtonStates;
         QList< bool > m_prevButtonStates;
@@ -0,0 +1,239 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "formcalculation_p.h"
+
+#include <QLinkedList>
+#include <QMap>
+#include <QRegularExpression>
+#include <QSet>
+
+#include "action.h"
+#include "form.h"
+#include "page.h"
+
+using namespace Okular;
+
+FormCalculation::FormCalculation()
+    : m_built( false )
+{
+}
+
+void FormCalculation::build( const QVector< Page * > &pages, const QVector< int > &calculateOrder )
+{
+    clear();
+
+    QHash< QString, QVector< int > > idsByName;
+    for ( const Page *page : pages )
+    {
+        const QLinkedList< FormField * > fields = page->formFields();
+        for ( FormField *field : fields )
+        {
+            m_fields.insert( field->id(), Entry{ field, int( page->number() ) } );
+            idsByName[ field->fullyQualifiedName() ].append( field->id() );
+        }
+    }
+
+    for ( int i = 0; i < calculateOrder.count(); ++i )
+    {
+        const int id = calculateOrder[ i ];
+        if ( m_calculatePosition.contains( id ) )
+            continue;
+
+        m_calculatePosition.insert( id, i );
+
+        const FormField *calculated = field( id );
+        const Action *action = calculated ? calculated->additionalAction( FormField::CalculateField ) : nullptr;
+
+        bool complete = false;
+        QStringList names;
+        if ( action && action->actionType() == Action::Script )
+            names = referencedFieldNames( static_cast< const ScriptAction * >( action )->script(), &complete );
+
+        if ( !complete )
+            m_alwaysCalculated.append( id );
+
+        for ( const QString &name : qAsConst( names ) )
+        {
+            const QVector< int > sourceIds = idsByName.value( name );
+            for ( int sourceId : sourceIds )
+            {
+                if ( sourceId == id )
+                    continue;
+
+                QVector< int > &dependents = m_dependents[ sourceId ];
+                if ( !dependents.contains( id ) )
+                    dependents.append( id );
+            }
+        }
+    }
+
+    m_built = true;
+}
+
+void FormCalculation::clear()
+{
+    m_fields.clear();
+    m_dependents.clear();
+    m_alwaysCalculated.clear();
+    m_calculatePosition.clear();
+    m_built = false;
+}
+
+bool FormCalculation::isBuilt() const
+{
+    return m_built;
+}
+
+FormField *FormCalculation::field( int id ) const
+{
+    const QHash< int, Entry >::const_iterator it = m_fields.constFind( id );
+    return it != m_fields.constEnd() ? it->field : nullptr;
+}
+
+int FormCalculation::pageNumber( int id ) const
+{
+    const QHash< int, Entry >::const_iterator it = m_fields.constFind( id );
+    return it != m_fields.constEnd() ? it->pageNumber : -1;
+}
+
+QVector< int > FormCalculation::fieldsToCalculate( const QList< FormField * > &changedFields ) const
+{
+    // everything downstream of the changed fields
+    QSet< int > affected;
+    QVector< int > pending;
+    for ( const FormField *changed : changedFields )
+        pending.append( changed->id() );
+    for ( int id : m_alwaysCalculated )
+    {
+        affected.insert( id );
+        pending.append( id );
+    }
+
+    while ( !pending.isEmpty() )
+    {
+        const int id = pending.takeLast();
+        const QHash< int, QVector< int > >::const_iterator it = m_dependents.constFind( id );
+        if ( it == m_dependents.constEnd() )
+            continue;
+
+        for ( int dependent : it.value() )
+        {
+            if ( !affected.contains( dependent ) )
+            {
+                affected.insert( dependent );
+                pending.append( dependent );
+            }
+        }
+    }
+
+    // topological order of the affected fields, the ones ready to be
+    // calculated are taken in calculation order
+    QHash< int, int > inDegree;
+    for ( int id : qAsConst( affected ) )
+    {
+        const QHash< int, QVector< int > >::const_iterator it = m_dependents.constFind( id );
+        if ( it == m_dependents.constEnd() )
+            continue;
+
+        for ( int dependent : it.value() )
+            inDegree[ dependent ]++;
+    }
+
+    QMap< int, int > ready;
+    for ( int id : qAsConst( affected ) )
+    {
+        if ( inDegree.value( id ) == 0 )
+            ready.insert( m_calculatePosition.value( id ), id );
+    }
+
+    QVector< int > order;
+    order.reserve( affected.count() );
+    while ( !ready.isEmpty() )
+    {
+        const int id = ready.take( ready.firstKey() );
+        order.append( id );
+        affected.remove( id );
+
+        const QHash< int, QVector< int > >::const_iterator it = m_dependents.constFind( id );
+        if ( it == m_dependents.constEnd() )
+            continue;
+
+        for ( int dependent : it.value() )
+        {
+            if ( --inDegree[ dependent ] == 0 )
+                ready.insert( m_calculatePosition.value( dependent ), dependent );
+        }
+    }
+
+    // fields left are part of a cycle
+    if ( !affected.isEmpty() )
+    {
+        QMap< int, int > cyclic;
+        for ( int id : qAsConst( affected ) )
+            cyclic.insert( m_calculatePosition.value( id ), id );
+        for ( int id : qAsConst( cyclic ) )
+            order.append( id );
+    }
+
+    return order;
+}
+
+static void appendStringLiterals( const QString &text, QStringList *names )
+{
+    static const QRegularExpression literal( QStringLiteral( "\"([^\"]*)\"|'([^']*)'" ) );
+
+    QRegularExpressionMatchIterator it = literal.globalMatch( text );
+    while ( it.hasNext() )
+    {
+        const QRegularExpressionMatch match = it.next();
+        names->append( match.capturedRef( 1 ).isNull() ? match.captured( 2 ) : match.captured( 1 ) );
+    }
+}
+
+QStringList FormCalculation::referencedFieldNames( const QString &script, bool *complete )
+{
+    static const QRegularExpression getFieldCall( QStringLiteral( "\\bgetField\\s*\\(" ) );
+    static const QRegularExpression getFieldLiteral( QStringLiteral( "\\bgetField\\s*\\(\\s*(\"[^\"]*\"|'[^']*')\\s*\\)" ) );
+    static const QRegularExpression simpleCalculateCall( QStringLiteral( "\\bAFSimple_Calculate\\s*\\(" ) );
+    static const QRegularExpression simpleCalculateLiteral( QStringLiteral( "\\bAFSimple_Calculate\\s*\\(\\s*(?:\"\\w*\"|'\\w*')\\s*,\\s*(?:new\\s+Array\\s*\\(([^)]*)\\)|\\[([^\\]]*)\\])\\s*\\)" ) );
+
+    QStringList names;
+    int calls = 0;
+    int literals = 0;
+
+    QRegularExpressionMatchIterator it = getFieldCall.globalMatch( script );
+    for ( ; it.hasNext(); it.next() )
+        calls++;
+
+    it = getFieldLiteral.globalMatch( script );
+    while ( it.hasNext() )
+    {
+        appendStringLiterals( it.next().captured( 1 ), &names );
+        literals++;
+    }
+
+    it = simpleCalculateCall.globalMatch( script );
+    for ( ; it.hasNext(); it.next() )
+        calls++;
+
+    it = simpleCalculateLiteral.globalMatch( script );
+    while ( it.hasNext() )
+    {
+        const QRegularExpressionMatch match = it.next();
+        appendStringLiterals( match.capturedRef( 1 ).isNull() ? match.captured( 2 ) : match.captured( 1 ), &names );
+        literals++;
+    }
+
+    // a script not reading any field might depend on anything else
+    *complete = calls == literals && !names.isEmpty();
+
+    names.removeDuplicates();
+    return names;
+}
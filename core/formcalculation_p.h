@@ -0,0 +1,98 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_FORMCALCULATION_P_H_
+#define _OKULAR_FORMCALCULATION_P_H_
+
+#include "okularcore_export.h"
+
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QVector>
+
+namespace Okular {
+
+class FormField;
+class Page;
+
+/**
+ * Index of the form fields of a document and graph of the fields read by
+ * the calculate scripts.
+ *
+ * The scripts of the fields in the calculation order are scanned once for
+ * the names of the fields they read (through getField() and
+ * AFSimple_Calculate()), so that a change only recalculates the fields
+ * downstream of it. Scripts whose fields can not be told statically are
+ * recalculated on every change.
+ */
+class OKULARCORE_EXPORT FormCalculation
+{
+    public:
+        FormCalculation();
+
+        /**
+         * Indexes the form fields of @p pages and builds the graph of the
+         * fields in @p calculateOrder.
+         */
+        void build( const QVector< Page * > &pages, const QVector< int > &calculateOrder );
+
+        /**
+         * Forgets the fields, they are about to be deleted.
+         */
+        void clear();
+
+        bool isBuilt() const;
+
+        /**
+         * Returns the field with the given @p id, or nullptr.
+         */
+        FormField *field( int id ) const;
+
+        /**
+         * Returns the number of the page of the field with the given @p id,
+         * or -1.
+         */
+        int pageNumber( int id ) const;
+
+        /**
+         * Returns the ids of the calculated fields affected by a change of
+         * @p changedFields, sorted so that every field comes after the
+         * fields it reads. Ties and cycles follow the calculation order of
+         * the document.
+         */
+        QVector< int > fieldsToCalculate( const QList< FormField * > &changedFields ) const;
+
+        /**
+         * Returns the names of the fields read by @p script. @p complete is
+         * set to false if the script may read fields that can not be found
+         * this way.
+         */
+        static QStringList referencedFieldNames( const QString &script, bool *complete );
+
+    private:
+        struct Entry
+        {
+            FormField *field;
+            int pageNumber;
+        };
+
+        QHash< int, Entry > m_fields;
+        // calculated fields reading the field with the key id
+        QHash< int, QVector< int > > m_dependents;
+        // calculated fields whose script could not be analysed
+        QVector< int > m_alwaysCalculated;
+        // position of the calculated fields in the calculation order
+        QHash< int, int > m_calculatePosition;
+        bool m_built;
+};
+
+}
+
+#endif
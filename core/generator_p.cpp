@@ -148,7 +148,8 @@ void FontExtractionThread::startExtraction( bool async )
     if ( async )
     {
         connect(this, &FontExtractionThread::finished, this, &FontExtractionThread::deleteLater);
-        start( QThread::InheritPriority );
+        // the font list is not urgent, don't steal time from rendering
+        start( QThread::IdlePriority );
     }
     else
     {
@@ -164,11 +165,17 @@ void FontExtractionThread::stopExtraction()
 
 void FontExtractionThread::run()
 {
+    // the same fonts are usually used by many pages, only report them once
+    FontInfo::List seenFonts;
     for ( int i = -1; i < mNumOfPages && mGoOn; ++i )
     {
         const FontInfo::List list = mGenerator->fontsForPage( i );
         for ( const FontInfo &fi : list )
         {
+            if ( seenFonts.contains( fi ) )
+                continue;
+
+            seenFonts.append( fi );
             emit gotFont( fi );
         }
         emit progress( i );
@@ -579,8 +579,10 @@ void Page::setTextPage( TextPage * textPage )
     if ( d->m_text )
     {
         d->m_text->d->m_page = this;
-        // Correct/optimize text order for search and text selection
-        d->m_text->d->correctTextOrder();
+        // Correct/optimize text order for search and text selection,
+        // unless it has been done already (e.g. text page from the disk cache)
+        if ( !d->m_text->d->m_textOrderCorrected )
+            d->m_text->d->correctTextOrder();
     }
 }
 
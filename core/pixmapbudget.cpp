@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "pixmapbudget_p.h"
+
+#include <QWidget>
+
+#include <algorithm>
+
+#include "debug_p.h"
+#include "document_p.h"
+
+using namespace Okular;
+
+static bool isVisible( const DocumentPrivate *document )
+{
+    return document->m_widget && document->m_widget->isVisible();
+}
+
+PixmapBudget::PixmapBudget()
+    : m_clock( 0 )
+{
+}
+
+PixmapBudget *PixmapBudget::self()
+{
+    static PixmapBudget budget;
+    return &budget;
+}
+
+void PixmapBudget::registerDocument( DocumentPrivate *document )
+{
+    m_documents.insert( document, ++m_clock );
+}
+
+void PixmapBudget::unregisterDocument( DocumentPrivate *document )
+{
+    m_documents.remove( document );
+}
+
+void PixmapBudget::touch( DocumentPrivate *document )
+{
+    const QHash< DocumentPrivate *, quint64 >::iterator it = m_documents.find( document );
+    if ( it != m_documents.end() )
+        it.value() = ++m_clock;
+}
+
+qulonglong PixmapBudget::totalMemory() const
+{
+    qulonglong memory = 0;
+    for ( QHash< DocumentPrivate *, quint64 >::const_iterator it = m_documents.constBegin(); it != m_documents.constEnd(); ++it )
+        memory += it.key()->m_allocatedPixmapsTotalMemory;
+    return memory;
+}
+
+void PixmapBudget::freeMemory( qulonglong memoryToFree, DocumentPrivate *requester )
+{
+    if ( memoryToFree < 1 )
+        return;
+
+    // hidden documents first, then the visible ones, the least recently used
+    // first, and the one asking for memory last
+    QVector< DocumentPrivate * > documents;
+    documents.reserve( m_documents.count() );
+    for ( QHash< DocumentPrivate *, quint64 >::const_iterator it = m_documents.constBegin(); it != m_documents.constEnd(); ++it )
+    {
+        if ( it.key() != requester && it.key()->m_allocatedPixmapsTotalMemory > 0 )
+            documents.append( it.key() );
+    }
+    std::sort( documents.begin(), documents.end(), [this]( DocumentPrivate *a, DocumentPrivate *b ) {
+        const bool aVisible = isVisible( a );
+        if ( aVisible != isVisible( b ) )
+            return !aVisible;
+        return m_documents.value( a ) < m_documents.value( b );
+    } );
+    if ( m_documents.contains( requester ) )
+        documents.append( requester );
+
+    for ( DocumentPrivate *document : qAsConst( documents ) )
+    {
+        const qulonglong freed = document->releasePixmapMemory( memoryToFree );
+        memoryToFree = freed < memoryToFree ? memoryToFree - freed : 0;
+        if ( memoryToFree == 0 )
+            break;
+    }
+
+    if ( documents.count() > 1 && OkularCoreDebug().isDebugEnabled() )
+    {
+        const QVector< DocumentUsage > documentsUsage = usage();
+        for ( const DocumentUsage &documentUsage : documentsUsage )
+            qCDebug(OkularCoreDebug).nospace() << "Pixmap memory of " << documentUsage.url << ": " << documentUsage.memory / 1024 << " KiB" << ( documentUsage.visible ? "" : " (hidden)" );
+    }
+}
+
+QVector< PixmapBudget::DocumentUsage > PixmapBudget::usage() const
+{
+    QVector< DocumentUsage > documentsUsage;
+    documentsUsage.reserve( m_documents.count() );
+    for ( QHash< DocumentPrivate *, quint64 >::const_iterator it = m_documents.constBegin(); it != m_documents.constEnd(); ++it )
+        documentsUsage.append( DocumentUsage{ it.key()->m_url, it.key()->m_allocatedPixmapsTotalMemory, isVisible( it.key() ) } );
+    return documentsUsage;
+}
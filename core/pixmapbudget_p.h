@@ -0,0 +1,77 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_PIXMAPBUDGET_P_H_
+#define _OKULAR_PIXMAPBUDGET_P_H_
+
+#include <QHash>
+#include <QUrl>
+#include <QVector>
+
+namespace Okular {
+
+class DocumentPrivate;
+
+/**
+ * Pixmap memory shared by all the documents of the process.
+ *
+ * The memory profiles compare the pixmaps of every open document with the
+ * memory of the machine, not those of one document only. When memory has
+ * to be freed the documents whose view is hidden, like the ones of the
+ * background tabs, give their pixmaps first, least recently used first,
+ * then the visible ones, and the document asking for memory last.
+ */
+class PixmapBudget
+{
+    public:
+        struct DocumentUsage
+        {
+            QUrl url;
+            qulonglong memory;
+            bool visible;
+        };
+
+        static PixmapBudget *self();
+
+        void registerDocument( DocumentPrivate *document );
+        void unregisterDocument( DocumentPrivate *document );
+
+        /**
+         * Marks @p document as the most recently used one.
+         */
+        void touch( DocumentPrivate *document );
+
+        /**
+         * Returns the memory used by the pixmaps of all the documents.
+         */
+        qulonglong totalMemory() const;
+
+        /**
+         * Frees @p memoryToFree bytes of pixmaps for @p requester.
+         */
+        void freeMemory( qulonglong memoryToFree, DocumentPrivate *requester );
+
+        /**
+         * Returns the pixmap memory used by every document.
+         */
+        QVector< DocumentUsage > usage() const;
+
+    private:
+        PixmapBudget();
+
+        // the documents with the time they were last used
+        QHash< DocumentPrivate *, quint64 > m_documents;
+        quint64 m_clock;
+
+        Q_DISABLE_COPY( PixmapBudget )
+};
+
+}
+
+#endif
@@ -0,0 +1,200 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "rasterprinter.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QPainter>
+#include <QPrinter>
+#include <QProgressDialog>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <KLocalizedString>
+
+#include "debug_p.h"
+
+using namespace Okular;
+
+namespace {
+
+struct RenderedPage
+{
+    QImage image;
+    QRectF targetRect;
+};
+
+}
+
+class Okular::RasterPrinterPrivate
+{
+    public:
+        explicit RasterPrinterPrivate( const RasterPrinter::RenderFunction &render )
+            : m_render( render ), m_maxPagesInFlight( 4 ), m_canceled( false )
+        {
+        }
+
+        bool takePage( int index, RenderedPage *page, int timeout );
+
+        RasterPrinter::RenderFunction m_render;
+        int m_maxPagesInFlight;
+        bool m_canceled;
+        QThreadPool m_pool;
+
+        // pages rendered and not printed yet, by position in the page list
+        QMutex m_mutex;
+        QWaitCondition m_pageRendered;
+        QHash< int, RenderedPage > m_renderedPages;
+        QAtomicInt m_stopped;
+};
+
+namespace {
+
+class RenderPageRunnable : public QRunnable
+{
+    public:
+        RenderPageRunnable( RasterPrinterPrivate *printer, int index, int page )
+            : m_printer( printer ), m_index( index ), m_page( page )
+        {
+        }
+
+        void run() override
+        {
+            RenderedPage rendered;
+            if ( !m_printer->m_stopped.load() )
+                rendered.image = m_printer->m_render( m_page, &rendered.targetRect );
+
+            QMutexLocker locker( &m_printer->m_mutex );
+            m_printer->m_renderedPages.insert( m_index, rendered );
+            m_printer->m_pageRendered.wakeAll();
+        }
+
+    private:
+        RasterPrinterPrivate *m_printer;
+        int m_index;
+        int m_page;
+};
+
+}
+
+bool RasterPrinterPrivate::takePage( int index, RenderedPage *page, int timeout )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( !m_renderedPages.contains( index ) )
+        m_pageRendered.wait( &m_mutex, timeout );
+
+    const QHash< int, RenderedPage >::iterator it = m_renderedPages.find( index );
+    if ( it == m_renderedPages.end() )
+        return false;
+
+    *page = it.value();
+    m_renderedPages.erase( it );
+    return true;
+}
+
+RasterPrinter::RasterPrinter( const RenderFunction &render )
+    : d( new RasterPrinterPrivate( render ) )
+{
+}
+
+RasterPrinter::~RasterPrinter()
+{
+    delete d;
+}
+
+void RasterPrinter::setMaxPagesInFlight( int count )
+{
+    d->m_maxPagesInFlight = qMax( count, 1 );
+}
+
+int RasterPrinter::maxPagesInFlight() const
+{
+    return d->m_maxPagesInFlight;
+}
+
+bool RasterPrinter::print( QPrinter &printer, const QList< int > &pageList )
+{
+    d->m_canceled = false;
+    d->m_stopped.store( 0 );
+    d->m_pool.setMaxThreadCount( qMin( QThread::idealThreadCount(), d->m_maxPagesInFlight ) );
+
+    QPainter painter;
+    if ( !painter.begin( &printer ) )
+        return false;
+
+    const int count = pageList.count();
+    QProgressDialog progress( i18n( "Preparing the pages to print..." ), i18n( "Cancel" ), 0, count, QApplication::activeWindow() );
+    progress.setWindowTitle( i18n( "Printing" ) );
+    progress.setWindowModality( Qt::WindowModal );
+    progress.setMinimumDuration( 1000 );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int scheduled = 0;
+    int printed = 0;
+    for ( int i = 0; i < count; ++i )
+    {
+        for ( ; scheduled < count && scheduled < i + d->m_maxPagesInFlight; ++scheduled )
+            d->m_pool.start( new RenderPageRunnable( d, scheduled, pageList.at( scheduled ) - 1 ) );
+
+        RenderedPage rendered;
+        while ( !d->takePage( i, &rendered, 50 ) && !progress.wasCanceled() )
+        {
+            // once visible the dialog is modal, before that the user must not
+            // act on the document being printed
+            QCoreApplication::processEvents( progress.isVisible() ? QEventLoop::AllEvents : QEventLoop::ExcludeUserInputEvents );
+        }
+
+        if ( progress.wasCanceled() )
+        {
+            d->m_canceled = true;
+            break;
+        }
+
+        if ( !rendered.image.isNull() )
+        {
+            if ( printed != 0 )
+                printer.newPage();
+
+            if ( rendered.targetRect.isEmpty() )
+                painter.drawImage( QPointF( 0, 0 ), rendered.image );
+            else
+                painter.drawImage( rendered.targetRect, rendered.image );
+            printed++;
+        }
+
+        const double pagesPerSecond = ( i + 1 ) * 1000.0 / qMax( timer.elapsed(), qint64( 1 ) );
+        progress.setLabelText( i18n( "Printed page %1 of %2 (%3 pages per second)", i + 1, count, QString::number( pagesPerSecond, 'f', 1 ) ) );
+        progress.setValue( i + 1 );
+    }
+
+    // drop the pages not rendered yet and wait for the ones being rendered
+    d->m_stopped.store( 1 );
+    d->m_pool.clear();
+    d->m_pool.waitForDone();
+    d->m_renderedPages.clear();
+
+    if ( d->m_canceled )
+        printer.abort();
+    painter.end();
+
+    qCDebug(OkularCoreDebug) << "Printed" << printed << "of" << count << "rasterized pages in" << timer.elapsed() << "ms";
+    return true;
+}
+
+bool RasterPrinter::wasCanceled() const
+{
+    return d->m_canceled;
+}
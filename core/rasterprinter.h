@@ -0,0 +1,90 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_RASTERPRINTER_H_
+#define _OKULAR_RASTERPRINTER_H_
+
+#include <QImage>
+#include <QList>
+#include <QRectF>
+
+#include <functional>
+
+#include "okularcore_export.h"
+
+class QPrinter;
+
+namespace Okular {
+
+class RasterPrinterPrivate;
+
+/**
+ * Prints pages rasterized by a generator.
+ *
+ * The pages are rendered in a pool of threads ahead of the printer, with at
+ * most maxPagesInFlight() pages rendered and not printed yet, and are drawn
+ * on the printer in order by the calling thread, which keeps processing
+ * events meanwhile. A progress dialog showing the throughput appears when
+ * printing takes a while, printing can be canceled from it. The generator
+ * must not be closed meanwhile, Document::print() marks the document busy.
+ *
+ * @since 1.10
+ */
+class OKULARCORE_EXPORT RasterPrinter
+{
+    public:
+        /**
+         * Renders the page @p page (0 based). It is called from the threads
+         * of the pool, it must not use the printer nor the GUI.
+         *
+         * @p targetRect is set to the rectangle, in the coordinates of the
+         * painter of the printer, the image is drawn into. The image is
+         * drawn at its size in the top left corner when it is left empty.
+         * The page is skipped when the image is null.
+         */
+        typedef std::function< QImage( int page, QRectF *targetRect ) > RenderFunction;
+
+        explicit RasterPrinter( const RenderFunction &render );
+        ~RasterPrinter();
+
+        /**
+         * Sets the maximum number of pages rendered and not printed yet,
+         * which bounds the memory used: a page rendered at the resolution of
+         * a printer takes tens of megabytes. It defaults to 4.
+         */
+        void setMaxPagesInFlight( int count );
+
+        /**
+         * Returns the maximum number of pages rendered and not printed yet.
+         */
+        int maxPagesInFlight() const;
+
+        /**
+         * Prints the pages of @p pageList, 1 based as returned by
+         * FilePrinter::pageList(), on @p printer.
+         *
+         * Returns false if painting on the printer failed. Printing canceled
+         * by the user is not a failure, see wasCanceled().
+         */
+        bool print( QPrinter &printer, const QList< int > &pageList );
+
+        /**
+         * Returns whether the user canceled the last print().
+         */
+        bool wasCanceled() const;
+
+    private:
+        RasterPrinterPrivate *const d;
+
+        Q_DISABLE_COPY( RasterPrinter )
+};
+
+}
+
+#endif
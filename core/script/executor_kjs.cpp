@@ -16,6 +16,8 @@
 #include <kjs/kjsarguments.h>
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
 
 #include "../debug_p.h"
 #include "../document_p.h"
@@ -39,8 +41,12 @@ class Okular::ExecutorKJSPrivate
 {
     public:
         ExecutorKJSPrivate( DocumentPrivate *doc )
-            : m_doc( doc )
+            : m_doc( doc ), m_event( nullptr )
         {
+            m_statistics.executions = 0;
+            m_statistics.cacheHits = 0;
+            m_statistics.executionTime = 0;
+
             initTypes();
         }
         ~ExecutorKJSPrivate()
@@ -53,6 +59,16 @@ class Okular::ExecutorKJSPrivate
         DocumentPrivate *m_doc;
         KJSInterpreter *m_interpreter;
         KJSGlobalObject m_docObject;
+
+        // the event being run, read by m_eventObject
+        Event *m_event;
+        KJSObject m_eventObject;
+
+        // name of the function running each event script, empty if the
+        // script is not run through a function
+        QHash< QString, QString > m_functions;
+
+        ExecutorKJS::Statistics m_statistics;
 };
 
 void ExecutorKJSPrivate::initTypes()
@@ -81,6 +97,68 @@ void ExecutorKJSPrivate::initTypes()
     m_docObject.setProperty( ctx, QStringLiteral("OCG"), JSOCG::object( ctx ) );
     m_docObject.setProperty( ctx, QStringLiteral("spell"), JSSpell::object( ctx ) );
     m_docObject.setProperty( ctx, QStringLiteral("util"), JSUtil::object( ctx ) );
+
+    // keep the event object referenced while no event is set
+    m_eventObject = JSEvent::wrapEvent( ctx, &m_event );
+    m_docObject.setProperty( ctx, QStringLiteral("okular_event"), m_eventObject );
+}
+
+// at most this many event scripts are kept compiled
+static const int MaxCompiledScripts = 256;
+
+// Whether the variables or functions declared by the script could be global.
+// Such scripts cannot be moved into a function, their declarations would
+// become local to it. Any declaration outside of strings and comments counts,
+// as do scripts that cannot be scanned reliably.
+static bool mayDeclareGlobals( const QString &script )
+{
+    const int length = script.length();
+    int i = 0;
+    while ( i < length )
+    {
+        const QChar c = script.at( i );
+        const QChar next = i + 1 < length ? script.at( i + 1 ) : QChar();
+        if ( c == QLatin1Char('/') && next == QLatin1Char('/') )
+        {
+            while ( i < length && script.at( i ) != QLatin1Char('\n') )
+                ++i;
+        }
+        else if ( c == QLatin1Char('/') && next == QLatin1Char('*') )
+        {
+            const int end = script.indexOf( QLatin1String("*/"), i + 2 );
+            if ( end < 0 )
+                return true;
+            i = end + 2;
+        }
+        else if ( c == QLatin1Char('"') || c == QLatin1Char('\'') )
+        {
+            ++i;
+            while ( i < length && script.at( i ) != c )
+            {
+                if ( script.at( i ) == QLatin1Char('\n') )
+                    return true;
+                i += script.at( i ) == QLatin1Char('\\') ? 2 : 1;
+            }
+            if ( i >= length )
+                return true;
+            ++i;
+        }
+        else if ( c.isLetter() || c == QLatin1Char('_') || c == QLatin1Char('$') )
+        {
+            const int start = i;
+            while ( i < length && ( script.at( i ).isLetterOrNumber() || script.at( i ) == QLatin1Char('_') || script.at( i ) == QLatin1Char('$') ) )
+                ++i;
+            const QStringRef word = script.midRef( start, i - start );
+            if ( word == QLatin1String("var") || word == QLatin1String("function") || word == QLatin1String("let")
+                 || word == QLatin1String("const") || word == QLatin1String("eval") )
+                return true;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    return false;
 }
 
 ExecutorKJS::ExecutorKJS( DocumentPrivate *doc )
@@ -90,6 +168,10 @@ ExecutorKJS::ExecutorKJS( DocumentPrivate *doc )
 
 ExecutorKJS::~ExecutorKJS()
 {
+    qCDebug(OkularCoreDebug) << "JS executions:" << d->m_statistics.executions
+                             << "cache hits:" << d->m_statistics.cacheHits
+                             << "time (ms):" << d->m_statistics.executionTime / 1000000;
+
     JSField::clearCachedFields();
     JSApp::clearCachedFields();
     JSOCG::clearCachedFields();
@@ -111,10 +193,49 @@ void ExecutorKJS::execute( const QString &script, Event *event )
 
     KJSContext* ctx = d->m_interpreter->globalContext();
 
-    d->m_docObject.setProperty( ctx, QStringLiteral("event"), event ? JSEvent::wrapEvent( ctx, event ) : KJSUndefined() );
+    QElapsedTimer timer;
+    timer.start();
+
+    // scripts can trigger other scripts, put the outer event back afterwards
+    Event *previousEvent = d->m_event;
+    d->m_event = event;
+    d->m_docObject.setProperty( ctx, QStringLiteral("event"), event ? d->m_eventObject : KJSUndefined() );
+
+    // The field scripts run over and over while the user types, so they
+    // are parsed once into a function, and later runs only call it
+    QString code = script;
+    if ( event )
+    {
+        QHash< QString, QString >::const_iterator it = d->m_functions.constFind( script );
+        if ( it == d->m_functions.constEnd() && d->m_functions.count() < MaxCompiledScripts )
+        {
+            QString name;
+            if ( !mayDeclareGlobals( script ) )
+            {
+                name = QStringLiteral("okular_script%1").arg( d->m_functions.count() );
+                const KJSResult definition = d->m_interpreter->evaluate( QStringLiteral("okular.js"), 0,
+                                                                         QStringLiteral("function %1() {\n%2\n}").arg( name, script ),
+                                                                         &d->m_docObject );
+                if ( definition.isException() )
+                    name.clear();
+            }
+            it = d->m_functions.insert( script, name );
+        }
+        else if ( it != d->m_functions.constEnd() && !it.value().isEmpty() )
+        {
+            d->m_statistics.cacheHits++;
+        }
+
+        if ( it != d->m_functions.constEnd() && !it.value().isEmpty() )
+            code = it.value() + QStringLiteral("();");
+    }
 
     KJSResult result = d->m_interpreter->evaluate( QStringLiteral("okular.js"), 1,
-                                                   script, &d->m_docObject );
+                                                   code, &d->m_docObject );
+
+    d->m_event = previousEvent;
+    d->m_statistics.executions++;
+    d->m_statistics.executionTime += timer.nsecsElapsed();
     
     if ( result.isException() || ctx->hasException() )
     {
@@ -131,3 +252,13 @@ void ExecutorKJS::execute( const QString &script, Event *event )
         }
     }
 }
+
+void ExecutorKJS::clearCachedFields()
+{
+    JSField::clearCachedFields();
+}
+
+ExecutorKJS::Statistics ExecutorKJS::statistics() const
+{
+    return d->m_statistics;
+}
@@ -10,6 +10,8 @@
 #ifndef OKULAR_SCRIPT_EXECUTOR_KJS_P_H
 #define OKULAR_SCRIPT_EXECUTOR_KJS_P_H
 
+#include <QtGlobal>
+
 class QString;
 
 namespace Okular {
@@ -27,8 +29,30 @@ class ExecutorKJS
         ExecutorKJS(const ExecutorKJS &) = delete;
         ExecutorKJS &operator=(const ExecutorKJS &) = delete;
 
+        /**
+         * Runs @p script. Scripts run for an @p event that do not declare
+         * anything are compiled once into a function, and the function is
+         * called on the next runs.
+         */
         void execute( const QString &script, Event *event );
 
+        /**
+         * Forgets the script objects of the form fields.
+         */
+        void clearCachedFields();
+
+        struct Statistics
+        {
+            int executions;         ///< scripts run
+            int cacheHits;          ///< runs reusing an already compiled script
+            qint64 executionTime;   ///< time spent running scripts, in nanoseconds
+        };
+
+        /**
+         * Returns the counters of the scripts run so far.
+         */
+        Statistics statistics() const;
+
     private:
         friend class ExecutorKJSPrivate;
         ExecutorKJSPrivate* d;
@@ -21,45 +21,64 @@ using namespace Okular;
 
 static KJSPrototype *g_eventProto;
 
+// The event object is created once per interpreter and reads the event
+// being run through a pointer, a reference kept after the run sees no event
+static Event *currentEvent( void *object )
+{
+    return *reinterpret_cast< Event ** >( object );
+}
+
 // Event.name
 static KJSObject eventGetName( KJSContext *, void *object )
 {
-    const Event *event = reinterpret_cast< Event * >( object );
+    const Event *event = currentEvent( object );
+    if ( !event )
+        return KJSUndefined();
     return KJSString( event->name() );
 }
 
 // Event.type
 static KJSObject eventGetType( KJSContext *, void *object )
 {
-    const Event *event = reinterpret_cast< Event * >( object );
+    const Event *event = currentEvent( object );
+    if ( !event )
+        return KJSUndefined();
     return KJSString( event->type() );
 }
 
 // Event.targetName (getter)
 static KJSObject eventGetTargetName( KJSContext *, void *object )
 {
-    const Event *event = reinterpret_cast< Event * >( object );
+    const Event *event = currentEvent( object );
+    if ( !event )
+        return KJSUndefined();
     return KJSString( event->targetName() );
 }
 
 // Event.targetName (setter)
 static void eventSetTargetName( KJSContext *ctx, void *object, KJSObject value )
 {
-    Event *event = reinterpret_cast< Event * >( object );
+    Event *event = currentEvent( object );
+    if ( !event )
+        return;
     event->setTargetName ( value.toString ( ctx ) );
 }
 
 // Event.shift
 static KJSObject eventGetShift( KJSContext *, void *object )
 {
-    const Event *event = reinterpret_cast< Event * >( object );
+    const Event *event = currentEvent( object );
+    if ( !event )
+        return KJSUndefined();
     return KJSBoolean( event->shiftModifier() );
 }
 
 // Event.source
 static KJSObject eventGetSource( KJSContext *ctx, void *object )
 {
-    const Event *event = reinterpret_cast< Event * >( object );
+    const Event *event = currentEvent( object );
+    if ( !event )
+        return KJSUndefined();
     if ( event->eventType() == Event::FieldCalculate )
     {
         FormField *src = event->source();
@@ -72,7 +91,9 @@ static KJSObject eventGetSource( KJSContext *ctx, void *object )
 // Event.target
 static KJSObject eventGetTarget( KJSContext *ctx, void *object )
 {
-    const Event *event = reinterpret_cast< Event * >( object );
+    const Event *event = currentEvent( object );
+    if ( !event )
+        return KJSUndefined();
     switch( event->eventType() )
     {
         case Event::FieldCalculate:
@@ -93,28 +114,36 @@ static KJSObject eventGetTarget( KJSContext *ctx, void *object )
 // Event.value (getter)
 static KJSObject eventGetValue( KJSContext *, void *object )
 {
-    const Event *event = reinterpret_cast< Event * >( object );
+    const Event *event = currentEvent( object );
+    if ( !event )
+        return KJSUndefined();
     return KJSString( event->value().toString() );
 }
 
 // Event.value (setter)
 static void eventSetValue( KJSContext *ctx, void *object, KJSObject value )
 {
-    Event *event = reinterpret_cast< Event * >( object );
+    Event *event = currentEvent( object );
+    if ( !event )
+        return;
     event->setValue ( QVariant( value.toString ( ctx ) ) );
 }
 
 // Event.rc (getter)
 static KJSObject eventGetReturnCode( KJSContext *, void *object )
 {
-    const Event *event = reinterpret_cast< Event * >( object );
+    const Event *event = currentEvent( object );
+    if ( !event )
+        return KJSUndefined();
     return KJSBoolean( event->returnCode() );
 }
 
 // Event.rc (setter)
 static void eventSetReturnCode( KJSContext *ctx, void *object, KJSObject value )
 {
-    Event *event = reinterpret_cast< Event * >( object );
+    Event *event = currentEvent( object );
+    if ( !event )
+        return;
     event->setReturnCode ( value.toBoolean ( ctx ) );
 }
 
@@ -139,7 +168,7 @@ void JSEvent::initType( KJSContext *ctx )
     g_eventProto->defineProperty( ctx, QStringLiteral( "rc" ), eventGetReturnCode, eventSetReturnCode );
 }
 
-KJSObject JSEvent::wrapEvent( KJSContext *ctx, Event *event )
+KJSObject JSEvent::wrapEvent( KJSContext *ctx, Event **event )
 {
     return g_eventProto->constructObject( ctx, event );
 }
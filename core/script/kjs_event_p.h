@@ -21,7 +21,11 @@ class JSEvent
 {
     public:
         static void initType( KJSContext *ctx );
-        static KJSObject wrapEvent( KJSContext *ctx, Event *event );
+        /**
+         * Wraps the event @p event points to. The object reads the pointer
+         * on every access, so it can be reused for all the events.
+         */
+        static KJSObject wrapEvent( KJSContext *ctx, Event **event );
         static void clearCachedFields();
 };
 
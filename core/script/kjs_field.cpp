@@ -11,6 +11,7 @@
 #include "kjs_field_p.h"
 
 #include <kjs/kjsinterpreter.h>
+#include <kjs/kjsobject.h>
 #include <kjs/kjsprototype.h>
 #include <kjs/kjsarguments.h>
 
@@ -29,6 +30,7 @@
 using namespace Okular;
 
 #define OKULAR_NAME QStringLiteral("okular_name")
+#define OKULAR_FIELDS QStringLiteral("okular_fields")
 
 static KJSPrototype *g_fieldProto;
 
@@ -36,6 +38,8 @@ typedef QHash< FormField *, Page * > FormCache;
 Q_GLOBAL_STATIC( FormCache, g_fieldCache )
 typedef QHash< QString, FormField * > ButtonCache;
 Q_GLOBAL_STATIC( ButtonCache, g_buttonCache )
+typedef QHash< QPair< FormField *, int >, KJSObject > WrapperCache;
+Q_GLOBAL_STATIC( WrapperCache, g_wrapperCache )
 
 
 // Helper for modified fields
@@ -329,9 +333,31 @@ void JSField::initType( KJSContext *ctx )
 
 KJSObject JSField::wrapField( KJSContext *ctx, FormField *field, Page *page )
 {
-    // ### cache unique wrapper
+    // getField() returns the same wrapper for a field on a page
+    const QPair< FormField *, int > key( field, page->number() );
+    WrapperCache::const_iterator it = g_wrapperCache->constFind( key );
+    if ( it != g_wrapperCache->constEnd() )
+    {
+        g_fieldCache->insert( field, page );
+        return it.value();
+    }
+
+    // The collector only knows about the objects referenced from scripts,
+    // so the wrappers are also kept in an array of the document. A new array
+    // is made once the wrappers were cleared, the old ones can then go away.
+    KJSObject doc = ctx->interpreter().globalObject();
+    KJSObject wrappers = doc.property( ctx, OKULAR_FIELDS );
+    if ( g_wrapperCache->isEmpty() || !wrappers.isObject() )
+    {
+        wrappers = KJSArray( ctx, 0 );
+        doc.setProperty( ctx, OKULAR_FIELDS, wrappers );
+    }
+
     KJSObject f = g_fieldProto->constructObject( ctx, field );
     f.setProperty( ctx, QStringLiteral("page"), page->number() );
+    wrappers.setProperty( ctx, QString::number( g_wrapperCache->count() ), f );
+    g_wrapperCache->insert( key, f );
+
     g_fieldCache->insert( field, page );
     return f;
 }
@@ -343,4 +369,7 @@ void JSField::clearCachedFields()
 
     if( g_buttonCache.exists() )
         g_buttonCache->clear();
+
+    if ( g_wrapperCache.exists() )
+        g_wrapperCache->clear();
 }
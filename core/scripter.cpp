@@ -77,12 +77,22 @@ void Scripter::execute( ScriptType type, const QString &script )
             if ( !d->m_kjs )
             {
                 d->m_kjs.reset(new ExecutorKJS( d->m_doc ));
+                // the built-in functions stay defined for all the later scripts
+                d->m_kjs->execute( builtInScript, nullptr );
             }
-            d->m_kjs->execute( builtInScript + script, d->m_event );
+            d->m_kjs->execute( script, d->m_event );
         }
 #endif
 }
 
+void Scripter::clearCachedFields()
+{
+#ifdef WITH_KJS
+    if ( d->m_kjs )
+        d->m_kjs->clearCachedFields();
+#endif
+}
+
 void Scripter::setEvent( Event *event )
 {
     d->m_event = event;
@@ -41,6 +41,12 @@ class Scripter
         friend class ScripterPrivate;
         ScripterPrivate* d;
 
+        /**
+         * Forgets what the scripts know about the form fields, because
+         * the pages holding them were replaced.
+         */
+        void clearCachedFields();
+
         Scripter( DocumentPrivate *doc );
 };
 
@@ -0,0 +1,326 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "synctexloader_p.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+#include "debug_p.h"
+
+using namespace Okular;
+
+// bump whenever the layout of the file changes
+static const quint32 IndexVersion = 2;
+static const char IndexMagic[ 8 ] = { 'O', 'K', 'S', 'Y', 'N', 'C', 'T', 'X' };
+
+// the indexes of the documents opened least recently go beyond that
+static const qint64 MaxIndexDirSize = 20 * 1024 * 1024;
+
+// the SyncTeX file synctex looks for next to the document
+static QString synctexFileName( const QString &docFile )
+{
+    const QFileInfo fi( docFile );
+    const QString base = fi.path() + QLatin1Char( '/' ) + fi.completeBaseName();
+    const QString candidates[] = { base + QStringLiteral( ".synctex.gz" ), base + QStringLiteral( ".synctex" ) };
+    for ( const QString &candidate : candidates )
+    {
+        if ( QFileInfo::exists( candidate ) )
+            return QFileInfo( candidate ).canonicalFilePath();
+    }
+    return QString();
+}
+
+static QString indexFileName( const QString &synctexFile )
+{
+    const QString cacheDir = QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation )
+            + QStringLiteral( "/okular/synctex" );
+    if ( !QFileInfo::exists( cacheDir ) )
+        QDir().mkpath( cacheDir );
+    const QByteArray hash = QCryptographicHash::hash( synctexFile.toUtf8(), QCryptographicHash::Sha1 );
+    return cacheDir + QLatin1Char( '/' ) + QString::fromLatin1( hash.toHex() );
+}
+
+// the names of the source files are compared without "./" and the like
+static QString sourceKey( const QString &fileName )
+{
+    return QDir::cleanPath( fileName );
+}
+
+SynctexLoader::SynctexLoader( const QString &docFile, int pageCount, QObject *parent )
+    : QThread( parent ), m_docFile( docFile ), m_synctexFile( synctexFileName( docFile ) ),
+      m_pageCount( pageCount ), m_parsed( false ), m_scanner( nullptr ), m_indexReady( false )
+{
+    m_indexReady = readIndex();
+    start( QThread::LowPriority );
+}
+
+SynctexLoader::~SynctexLoader()
+{
+    wait();
+    if ( m_scanner )
+        synctex_scanner_free( m_scanner );
+}
+
+synctex_scanner_p SynctexLoader::scanner()
+{
+    while ( !m_parsed )
+        m_parsedCondition.wait( &m_mutex );
+    return m_scanner;
+}
+
+QMutex *SynctexLoader::mutex()
+{
+    return &m_mutex;
+}
+
+bool SynctexLoader::findPosition( const QString &fileName, int line, Position *position )
+{
+    {
+        QMutexLocker locker( &m_mutex );
+        if ( !m_indexReady )
+            return false;
+    }
+
+    const QHash< QString, QVector< LinePosition > >::const_iterator it = m_lines.constFind( sourceKey( fileName ) );
+    if ( it == m_lines.constEnd() )
+        return false;
+
+    const QVector< LinePosition > &lines = it.value();
+    const QVector< LinePosition >::const_iterator lineIt = std::lower_bound( lines.constBegin(), lines.constEnd(), line,
+        []( const LinePosition &lp, int l ) { return lp.line < l; } );
+    if ( lineIt == lines.constEnd() || lineIt->line != line )
+        return false;
+
+    *position = lineIt->position;
+    return true;
+}
+
+void SynctexLoader::run()
+{
+    // the queries can use the scanner as soon as it is parsed
+    synctex_scanner_p scanner = synctex_scanner_new_with_output_file( QFile::encodeName( m_docFile ).constData(), nullptr, 1 );
+    {
+        QMutexLocker locker( &m_mutex );
+        m_scanner = scanner;
+        m_parsed = true;
+        m_parsedCondition.wakeAll();
+    }
+
+    // m_indexReady is only set here past the constructor
+    if ( scanner && !m_indexReady )
+    {
+        const QHash< QString, QVector< LinePosition > > lines = buildIndex();
+        {
+            QMutexLocker locker( &m_mutex );
+            m_lines = lines;
+            m_indexReady = true;
+        }
+        writeIndex();
+    }
+
+    removeOldIndexes();
+}
+
+QHash< QString, QVector< SynctexLoader::LinePosition > > SynctexLoader::buildIndex()
+{
+    // the lines of every input file having nodes on the pages; the scanner
+    // is shared with the queries, so it is only held a page or a line at a
+    // time
+    QHash< int, QSet< int > > linesByTag;
+    for ( int page = 1; page <= m_pageCount; ++page )
+    {
+        QMutexLocker locker( &m_mutex );
+        synctex_node_p node = synctex_sheet( m_scanner, page );
+        if ( !node )
+            continue;
+
+        while ( ( node = synctex_node_next( node ) ) )
+        {
+            const int tag = synctex_node_tag( node );
+            const int line = synctex_node_line( node );
+            if ( tag <= 0 || line <= 0 )
+                continue;
+
+            linesByTag[ tag ].insert( line );
+        }
+    }
+
+    // the position of a line is the one Document::metaData() gets from
+    // synctex_display_query(), whose choice among the nodes of the line
+    // (boxes last, then the node with the most friends on the lowest page)
+    // is left to it; looking up a line only walks its bucket of friends
+    QHash< QString, QVector< LinePosition > > index;
+    for ( QHash< int, QSet< int > >::const_iterator it = linesByTag.constBegin(); it != linesByTag.constEnd(); ++it )
+    {
+        QByteArray name;
+        {
+            QMutexLocker locker( &m_mutex );
+            name = synctex_scanner_get_name( m_scanner, it.key() );
+        }
+        if ( name.isEmpty() )
+            continue;
+
+        QList< int > lineNumbers = it.value().values();
+        std::sort( lineNumbers.begin(), lineNumbers.end() );
+
+        QVector< LinePosition > lines;
+        lines.reserve( lineNumbers.count() );
+        for ( int line : qAsConst( lineNumbers ) )
+        {
+            QMutexLocker locker( &m_mutex );
+            if ( synctex_display_query( m_scanner, name.constData(), line, -1, 0 ) <= 0 )
+                continue;
+
+            synctex_node_p node;
+            while ( ( node = synctex_scanner_next_result( m_scanner ) ) )
+            {
+                // TeX pages start at 1
+                if ( synctex_node_page( node ) > 0 )
+                {
+                    lines.append( LinePosition{ line, Position{ synctex_node_page( node ) - 1, synctex_node_visible_h( node ), synctex_node_visible_v( node ) } } );
+                    break;
+                }
+            }
+        }
+        index.insert( sourceKey( QFile::decodeName( name ) ), lines );
+    }
+    return index;
+}
+
+bool SynctexLoader::readIndex()
+{
+    if ( m_synctexFile.isEmpty() )
+        return false;
+
+    QFile file( indexFileName( m_synctexFile ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return false;
+
+    const QFileInfo fi( m_synctexFile );
+    QDataStream stream( &file );
+    stream.setFloatingPointPrecision( QDataStream::SinglePrecision );
+
+    char magic[ sizeof( IndexMagic ) ];
+    quint32 version;
+    QString synctexFile;
+    qint64 size, lastModified;
+    if ( stream.readRawData( magic, sizeof( magic ) ) != sizeof( magic ) || std::memcmp( magic, IndexMagic, sizeof( magic ) ) != 0 )
+        return false;
+    stream >> version >> synctexFile >> size >> lastModified;
+    if ( stream.status() != QDataStream::Ok || version != IndexVersion || synctexFile != m_synctexFile ||
+         size != fi.size() || lastModified != fi.lastModified().toMSecsSinceEpoch() )
+        return false;
+
+    quint32 fileCount;
+    stream >> fileCount;
+    for ( quint32 i = 0; i < fileCount && stream.status() == QDataStream::Ok; ++i )
+    {
+        QString name;
+        quint32 lineCount;
+        stream >> name >> lineCount;
+
+        QVector< LinePosition > lines;
+        lines.reserve( qMin( lineCount, quint32( 1 << 20 ) ) );
+        for ( quint32 j = 0; j < lineCount && stream.status() == QDataStream::Ok; ++j )
+        {
+            qint32 line, page;
+            float h, v;
+            stream >> line >> page >> h >> v;
+            lines.append( LinePosition{ line, Position{ page, h, v } } );
+        }
+        m_lines.insert( name, lines );
+    }
+
+    if ( stream.status() != QDataStream::Ok )
+    {
+        qCWarning(OkularCoreDebug) << "Corrupted SyncTeX index" << file.fileName();
+        m_lines.clear();
+        return false;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    // the modification time tells the least recently used indexes apart
+    file.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+#endif
+    return true;
+}
+
+void SynctexLoader::writeIndex() const
+{
+    if ( m_synctexFile.isEmpty() )
+        return;
+
+    QSaveFile file( indexFileName( m_synctexFile ) );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        return;
+
+    const QFileInfo fi( m_synctexFile );
+    QDataStream stream( &file );
+    stream.setFloatingPointPrecision( QDataStream::SinglePrecision );
+
+    stream.writeRawData( IndexMagic, sizeof( IndexMagic ) );
+    stream << IndexVersion << m_synctexFile << qint64( fi.size() ) << qint64( fi.lastModified().toMSecsSinceEpoch() );
+    stream << quint32( m_lines.count() );
+    for ( QHash< QString, QVector< LinePosition > >::const_iterator it = m_lines.constBegin(); it != m_lines.constEnd(); ++it )
+    {
+        stream << it.key() << quint32( it.value().count() );
+        for ( const LinePosition &lp : it.value() )
+            stream << qint32( lp.line ) << qint32( lp.position.page ) << lp.position.h << lp.position.v;
+    }
+
+    if ( stream.status() != QDataStream::Ok || !file.commit() )
+        qCWarning(OkularCoreDebug) << "Could not write the SyncTeX index" << file.fileName();
+}
+
+void SynctexLoader::removeOldIndexes() const
+{
+    if ( m_synctexFile.isEmpty() )
+        return;
+
+    const QFileInfo current( indexFileName( m_synctexFile ) );
+
+    QFileInfoList indexes;
+    qint64 totalSize = 0;
+    QDirIterator it( current.absolutePath(), QDir::Files );
+    while ( it.hasNext() )
+    {
+        it.next();
+        const QFileInfo fi = it.fileInfo();
+        totalSize += fi.size();
+        if ( fi.fileName() != current.fileName() )
+            indexes.append( fi );
+    }
+
+    if ( totalSize <= MaxIndexDirSize )
+        return;
+
+    std::sort( indexes.begin(), indexes.end(), []( const QFileInfo &a, const QFileInfo &b ) { return a.lastModified() < b.lastModified(); } );
+    for ( const QFileInfo &fi : qAsConst( indexes ) )
+    {
+        if ( totalSize <= MaxIndexDirSize )
+            break;
+        if ( QFile::remove( fi.absoluteFilePath() ) )
+            totalSize -= fi.size();
+    }
+}
+
+#include "moc_synctexloader_p.cpp"
@@ -0,0 +1,111 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_SYNCTEXLOADER_P_H_
+#define _OKULAR_SYNCTEXLOADER_P_H_
+
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "synctex/synctex_parser.h"
+
+namespace Okular {
+
+/**
+ * Loads the SyncTeX data of a document in a thread.
+ *
+ * Parsing the .synctex(.gz) file of a large LaTeX project takes seconds, so
+ * the scanner is created in a thread when the document is opened, and the
+ * queries arriving before it is parsed wait for it.
+ *
+ * The position forward search finds for every source line having nodes,
+ * the first result of synctex_display_query(), is also kept in a compact
+ * index cached on disk and keyed by the path, size and modification time
+ * of the SyncTeX file: reopening an unchanged document answers forward
+ * searches right away. The other lines, for which the query falls back to
+ * the nearest lines, still need the scanner, as do all the lines while the
+ * index is being built. The indexes of the least recently opened documents
+ * are removed once they take too much room.
+ */
+class SynctexLoader : public QThread
+{
+    Q_OBJECT
+
+    public:
+        struct Position
+        {
+            int page;   // 0 based
+            float h;    // TeX points
+            float v;
+        };
+
+        /**
+         * Starts loading the SyncTeX data of @p docFile, which has
+         * @p pageCount pages.
+         */
+        SynctexLoader( const QString &docFile, int pageCount, QObject *parent = nullptr );
+        ~SynctexLoader() override;
+
+        /**
+         * Returns the scanner, waiting for it to be parsed, or nullptr if
+         * the document has no SyncTeX data.
+         *
+         * The index is built from the scanner once it is parsed, so mutex()
+         * must be locked before calling this and while using the scanner.
+         */
+        synctex_scanner_p scanner();
+
+        /**
+         * The mutex guarding the queries to the scanner.
+         */
+        QMutex *mutex();
+
+        /**
+         * Looks for the position of the source @p line of @p fileName in
+         * the index, without waiting for the scanner. Returns false if the
+         * line is not in the index, or if the index is still being built.
+         */
+        bool findPosition( const QString &fileName, int line, Position *position );
+
+    protected:
+        void run() override;
+
+    private:
+        struct LinePosition
+        {
+            int line;
+            Position position;
+        };
+
+        QHash< QString, QVector< LinePosition > > buildIndex();
+        bool readIndex();
+        void writeIndex() const;
+        void removeOldIndexes() const;
+
+        QString m_docFile;
+        QString m_synctexFile;
+        int m_pageCount;
+        QMutex m_mutex;
+        QWaitCondition m_parsedCondition;
+        bool m_parsed;
+        synctex_scanner_p m_scanner;
+        // positions of the lines of every source file, sorted by line, not
+        // changed anymore once m_indexReady is set
+        QHash< QString, QVector< LinePosition > > m_lines;
+        bool m_indexReady;
+
+        Q_DISABLE_COPY( SynctexLoader )
+};
+
+}
+
+#endif
@@ -192,6 +192,29 @@ QList<TextDocumentGeneratorPrivate::LinkInfo> TextDocumentGeneratorPrivate::gene
     return result;
 }
 
+QVector< QLinkedList<Okular::ObjectRect*> > TextDocumentGeneratorPrivate::generateObjectRects() const
+{
+    const QList<LinkInfo> linkInfos = generateLinkInfos();
+
+    QVector< QLinkedList<Okular::ObjectRect*> > objects( mDocument->pageCount() );
+    for ( const LinkInfo &info : linkInfos ) {
+        // in case that the converter report bogus link info data, do not assert here
+        if ( info.page < 0 || info.page >= objects.count() )
+          continue;
+
+        const QRectF rect = info.boundingRect;
+        if ( info.ownsLink ) {
+            objects[ info.page ].append( new Okular::ObjectRect( rect.left(), rect.top(), rect.right(), rect.bottom(), false,
+                                                                 Okular::ObjectRect::Action, info.link ) );
+        } else {
+            objects[ info.page ].append( new Okular::NonOwningObjectRect( rect.left(), rect.top(), rect.right(), rect.bottom(), false,
+                                                                          Okular::ObjectRect::Action, info.link ) );
+        }
+    }
+
+    return objects;
+}
+
 QList<TextDocumentGeneratorPrivate::AnnotationInfo> TextDocumentGeneratorPrivate::generateAnnotationInfos() const
 {
     QList<AnnotationInfo> result;
@@ -324,28 +347,13 @@ Document::OpenResult TextDocumentGenerator::loadDocumentWithPassword( const QStr
     d->mDocument = d->mConverter->document();
 
     d->generateTitleInfos();
-    const QList<TextDocumentGeneratorPrivate::LinkInfo> linkInfos = d->generateLinkInfos();
     const QList<TextDocumentGeneratorPrivate::AnnotationInfo> annotationInfos = d->generateAnnotationInfos();
 
     pagesVector.resize( d->mDocument->pageCount() );
 
     const QSize size = d->mDocument->pageSize().toSize();
 
-    QVector< QLinkedList<Okular::ObjectRect*> > objects( d->mDocument->pageCount() );
-    for ( const TextDocumentGeneratorPrivate::LinkInfo &info : linkInfos ) {
-        // in case that the converter report bogus link info data, do not assert here
-        if ( info.page < 0 || info.page >= objects.count() )
-          continue;
-
-        const QRectF rect = info.boundingRect;
-        if ( info.ownsLink ) {
-            objects[ info.page ].append( new Okular::ObjectRect( rect.left(), rect.top(), rect.right(), rect.bottom(), false,
-                                                                 Okular::ObjectRect::Action, info.link ) );
-        } else {
-            objects[ info.page ].append( new Okular::NonOwningObjectRect( rect.left(), rect.top(), rect.right(), rect.bottom(), false,
-                                                                          Okular::ObjectRect::Action, info.link ) );
-        }
-    }
+    const QVector< QLinkedList<Okular::ObjectRect*> > objects = d->generateObjectRects();
 
     QVector< QLinkedList<Okular::Annotation*> > annots( d->mDocument->pageCount() );
     for ( const TextDocumentGeneratorPrivate::AnnotationInfo &info : annotationInfos ) {
@@ -365,6 +373,10 @@ Document::OpenResult TextDocumentGenerator::loadDocumentWithPassword( const QStr
         }
     }
 
+    d->mLinkCount = d->mLinkPositions.count();
+    d->mAnnotationCount = d->mAnnotationPositions.count();
+    d->mTitleCount = d->mTitlePositions.count();
+
     return openResult;
 }
 
@@ -377,6 +389,9 @@ bool TextDocumentGenerator::doCloseDocument()
     d->mTitlePositions.clear();
     d->mLinkPositions.clear();
     d->mAnnotationPositions.clear();
+    d->mLinkCount = 0;
+    d->mAnnotationCount = 0;
+    d->mTitleCount = 0;
     // do not use clear() for the following two, otherwise they change type
     d->mDocumentInfo = Okular::DocumentInfo();
     d->mDocumentSynopsis = Okular::DocumentSynopsis();
@@ -581,3 +596,63 @@ void TextDocumentGenerator::setTextDocument( QTextDocument *textDocument )
         p->setTextPage( nullptr );
     }
 }
+
+void TextDocumentGenerator::setTextDocument( QTextDocument *textDocument, const QVector<int> &changedPages )
+{
+    Q_D( TextDocumentGenerator );
+
+    if ( d->mDocument == textDocument )
+        return;
+
+    // the converter added the positions of textDocument after the ones of
+    // the old document: the old links are owned by the object rects of the
+    // pages and the annotations of the pages are kept as they are
+    d->mLinkPositions = d->mLinkPositions.mid( d->mLinkCount );
+    d->mTitlePositions = d->mTitlePositions.mid( d->mTitleCount );
+    for ( int i = d->mAnnotationCount; i < d->mAnnotationPositions.count(); ++i )
+        delete d->mAnnotationPositions.at( i ).annotation;
+    d->mAnnotationPositions = d->mAnnotationPositions.mid( 0, d->mAnnotationCount );
+    d->mLinkCount = d->mLinkPositions.count();
+    d->mTitleCount = d->mTitlePositions.count();
+
+    // laying out textDocument must not race with the rendering threads
+    userMutex()->lock();
+    QTextDocument *oldDocument = d->mDocument;
+    d->mDocument = textDocument;
+
+    d->mDocumentSynopsis = Okular::DocumentSynopsis();
+    d->generateTitleInfos();
+    const QVector< QLinkedList<Okular::ObjectRect*> > objects = d->generateObjectRects();
+    userMutex()->unlock();
+
+    delete oldDocument;
+
+    QVector<Page*> pages = d->m_document->m_pagesVector;
+    const int oldPageCount = pages.count();
+    const int pageCount = textDocument->pageCount();
+    const QSize size = textDocument->pageSize().toSize();
+
+    pages.resize( pageCount );
+    for ( int i = oldPageCount; i < pageCount; ++i )
+        pages[ i ] = new Okular::Page( i, size.width(), size.height(), Okular::Rotation0 );
+
+    // the links moved with the text, even on the pages that render the same
+    for ( int i = 0; i < pageCount; ++i )
+        pages[ i ]->setObjectRects( objects.at( i ) );
+
+    // setting the pages up again reloads the synopsis too
+    if ( pageCount != oldPageCount )
+        d->m_document->setPages( pages );
+    else
+        emit d->m_document->m_parent->documentSynopsisChanged();
+
+    for ( int pageNumber : changedPages )
+    {
+        if ( pageNumber >= qMin( pageCount, oldPageCount ) )
+            continue;
+
+        Page *p = pages.at( pageNumber );
+        p->setTextPage( nullptr );
+        d->m_document->refreshPixmaps( pageNumber );
+    }
+}
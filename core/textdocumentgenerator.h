@@ -220,6 +220,19 @@ class OKULARCORE_EXPORT TextDocumentGenerator : public Generator, public Okular:
         /* @since 1.8 */
         void setTextDocument( QTextDocument *textDocument );
 
+        /**
+         * Replaces the text document by @p textDocument, converted again
+         * from the same file, and deletes the current one.
+         *
+         * The converter must have added the links and the titles of
+         * @p textDocument since the current one was set. Pages are added or
+         * removed when the page count changed, only the text and the pixmaps
+         * of the other @p changedPages are regenerated.
+         *
+         * @since 1.10
+         */
+        void setTextDocument( QTextDocument *textDocument, const QVector<int> &changedPages );
+
     private:
         Q_DECLARE_PRIVATE( TextDocumentGenerator )
         Q_DISABLE_COPY( TextDocumentGenerator )
@@ -176,7 +176,7 @@ class TextDocumentGeneratorPrivate : public GeneratorPrivate
 
     public:
         explicit TextDocumentGeneratorPrivate( TextDocumentConverter *converter )
-            : mConverter( converter ), mDocument( nullptr ), mGeneralSettings( nullptr )
+            : mConverter( converter ), mDocument( nullptr ), mLinkCount( 0 ), mAnnotationCount( 0 ), mTitleCount( 0 ), mGeneralSettings( nullptr )
         {
         }
 
@@ -219,6 +219,7 @@ class TextDocumentGeneratorPrivate : public GeneratorPrivate
         void addMetaData( DocumentInfo::Key, const QString &value );
 
         QList<LinkInfo> generateLinkInfos() const;
+        QVector< QLinkedList<Okular::ObjectRect*> > generateObjectRects() const;
         QList<AnnotationInfo> generateAnnotationInfos() const;
         void generateTitleInfos();
 
@@ -252,6 +253,12 @@ class TextDocumentGeneratorPrivate : public GeneratorPrivate
         };
         QList<AnnotationPosition> mAnnotationPositions;
 
+        // how many of the positions above are the ones of mDocument, the
+        // converter adds the ones of the next document after them
+        int mLinkCount;
+        int mAnnotationCount;
+        int mTitleCount;
+
         TextDocumentSettings *mGeneralSettings;
 
         QFont mFont;
@@ -0,0 +1,193 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "textexporter.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QProgressDialog>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <KLocalizedString>
+
+#include "debug_p.h"
+
+using namespace Okular;
+
+class Okular::TextExporterPrivate
+{
+    public:
+        explicit TextExporterPrivate( const TextExporter::ExtractFunction &extract )
+            : m_extract( extract ), m_maxThreadCount( QThread::idealThreadCount() ), m_canceled( false )
+        {
+        }
+
+        bool takePage( int page, QString *text, int timeout );
+
+        TextExporter::ExtractFunction m_extract;
+        int m_maxThreadCount;
+        QString m_pageSeparator;
+        bool m_canceled;
+        QThreadPool m_pool;
+
+        // pages extracted and not written yet
+        QMutex m_mutex;
+        QWaitCondition m_pageExtracted;
+        QHash< int, QString > m_extractedPages;
+        QAtomicInt m_stopped;
+};
+
+namespace {
+
+class ExtractPageRunnable : public QRunnable
+{
+    public:
+        ExtractPageRunnable( TextExporterPrivate *exporter, int page )
+            : m_exporter( exporter ), m_page( page )
+        {
+        }
+
+        void run() override
+        {
+            QString text;
+            if ( !m_exporter->m_stopped.load() )
+                text = m_exporter->m_extract( m_page );
+
+            QMutexLocker locker( &m_exporter->m_mutex );
+            m_exporter->m_extractedPages.insert( m_page, text );
+            m_exporter->m_pageExtracted.wakeAll();
+        }
+
+    private:
+        TextExporterPrivate *m_exporter;
+        int m_page;
+};
+
+}
+
+bool TextExporterPrivate::takePage( int page, QString *text, int timeout )
+{
+    QMutexLocker locker( &m_mutex );
+    if ( !m_extractedPages.contains( page ) )
+        m_pageExtracted.wait( &m_mutex, timeout );
+
+    const QHash< int, QString >::iterator it = m_extractedPages.find( page );
+    if ( it == m_extractedPages.end() )
+        return false;
+
+    *text = it.value();
+    m_extractedPages.erase( it );
+    return true;
+}
+
+TextExporter::TextExporter( const ExtractFunction &extract )
+    : d( new TextExporterPrivate( extract ) )
+{
+}
+
+TextExporter::~TextExporter()
+{
+    delete d;
+}
+
+void TextExporter::setMaxThreadCount( int count )
+{
+    d->m_maxThreadCount = qMax( count, 1 );
+}
+
+int TextExporter::maxThreadCount() const
+{
+    return d->m_maxThreadCount;
+}
+
+void TextExporter::setPageSeparator( const QString &separator )
+{
+    d->m_pageSeparator = separator;
+}
+
+bool TextExporter::exportTo( const QString &fileName, int pageCount )
+{
+    d->m_canceled = false;
+    d->m_stopped.store( 0 );
+    d->m_pool.setMaxThreadCount( d->m_maxThreadCount );
+
+    QSaveFile file( fileName );
+    if ( !file.open( QIODevice::WriteOnly ) )
+        return false;
+
+    QTextStream ts( &file );
+
+    QProgressDialog progress( i18n( "Exporting the text of the document..." ), i18n( "Cancel" ), 0, pageCount, QApplication::activeWindow() );
+    progress.setWindowTitle( i18n( "Exporting" ) );
+    progress.setWindowModality( Qt::WindowModal );
+    progress.setMinimumDuration( 1000 );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // the pages extracted ahead of the one being written, the text of a
+    // page is small but the one of a few thousand pages is not
+    const int maxPagesInFlight = d->m_maxThreadCount * 4;
+    int scheduled = 0;
+    for ( int i = 0; i < pageCount; ++i )
+    {
+        for ( ; scheduled < pageCount && scheduled < i + maxPagesInFlight; ++scheduled )
+            d->m_pool.start( new ExtractPageRunnable( d, scheduled ) );
+
+        QString text;
+        while ( !d->takePage( i, &text, 50 ) && !progress.wasCanceled() )
+        {
+            // once visible the dialog is modal, before that the user must not
+            // act on the document being exported
+            QCoreApplication::processEvents( progress.isVisible() ? QEventLoop::AllEvents : QEventLoop::ExcludeUserInputEvents );
+        }
+
+        if ( progress.wasCanceled() )
+        {
+            d->m_canceled = true;
+            break;
+        }
+
+        ts << text << d->m_pageSeparator;
+
+        progress.setLabelText( i18n( "Exported page %1 of %2", i + 1, pageCount ) );
+        progress.setValue( i + 1 );
+    }
+
+    // drop the pages not extracted yet and wait for the ones being extracted
+    d->m_stopped.store( 1 );
+    d->m_pool.clear();
+    d->m_pool.waitForDone();
+    d->m_extractedPages.clear();
+
+    if ( d->m_canceled )
+    {
+        file.cancelWriting();
+        return true;
+    }
+
+    ts.flush();
+    if ( ts.status() != QTextStream::Ok || !file.commit() )
+        return false;
+
+    qCDebug(OkularCoreDebug) << "Exported the text of" << pageCount << "pages in" << timer.elapsed() << "ms";
+    return true;
+}
+
+bool TextExporter::wasCanceled() const
+{
+    return d->m_canceled;
+}
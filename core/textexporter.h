@@ -0,0 +1,88 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_TEXTEXPORTER_H_
+#define _OKULAR_TEXTEXPORTER_H_
+
+#include <QString>
+
+#include <functional>
+
+#include "okularcore_export.h"
+
+namespace Okular {
+
+class TextExporterPrivate;
+
+/**
+ * Exports the text of the pages of a document to a file.
+ *
+ * The text of the pages is extracted in a pool of threads and written to
+ * the file in page order by the calling thread, which keeps processing
+ * events meanwhile. A progress dialog appears when the export takes a
+ * while, the export can be canceled from it. The generator must not be
+ * closed meanwhile, Document::exportTo() marks the document busy.
+ *
+ * @since 1.10
+ */
+class OKULARCORE_EXPORT TextExporter
+{
+    public:
+        /**
+         * Returns the text of the page @p page (0 based). It is called from
+         * the threads of the pool, at most maxThreadCount() at a time, it
+         * must not use the GUI.
+         */
+        typedef std::function< QString( int page ) > ExtractFunction;
+
+        explicit TextExporter( const ExtractFunction &extract );
+        ~TextExporter();
+
+        /**
+         * Sets the maximum number of pages extracted at the same time,
+         * 1 when the extraction cannot run in parallel. It defaults to the
+         * number of processor cores.
+         */
+        void setMaxThreadCount( int count );
+
+        /**
+         * Returns the maximum number of pages extracted at the same time.
+         */
+        int maxThreadCount() const;
+
+        /**
+         * Sets the text written after the text of every page. It is empty
+         * by default.
+         */
+        void setPageSeparator( const QString &separator );
+
+        /**
+         * Exports the text of the @p pageCount pages of the document to
+         * @p fileName.
+         *
+         * Returns false if the file could not be written. An export canceled
+         * by the user is not a failure, see wasCanceled(), the file is then
+         * left as it was.
+         */
+        bool exportTo( const QString &fileName, int pageCount );
+
+        /**
+         * Returns whether the user canceled the last exportTo().
+         */
+        bool wasCanceled() const;
+
+    private:
+        TextExporterPrivate *const d;
+
+        Q_DISABLE_COPY( TextExporter )
+};
+
+}
+
+#endif
@@ -21,7 +21,7 @@
 #include <cstring>
 
 #include <QtAlgorithms>
-#include <QVarLengthArray>
+#include <QVector>
 
 using namespace Okular;
 
@@ -29,23 +29,23 @@ class SearchPoint
 {
     public:
         SearchPoint()
-            : offset_begin( -1 ), offset_end( -1 )
+            : word_begin( -1 ), word_end( -1 ), offset_begin( -1 ), offset_end( -1 )
         {
         }
 
-        /** The TinyTextEntity containing the first character of the match. */
-        TextList::ConstIterator it_begin;
+        /** The index of the word containing the first character of the match. */
+        int word_begin;
 
-        /** The TinyTextEntity containing the last character of the match. */
-        TextList::ConstIterator it_end;
+        /** The index of the word containing the last character of the match. */
+        int word_end;
 
-        /** The index of the first character of the match in (*it_begin)->text().
-         *  Satisfies 0 <= offset_begin < (*it_begin)->text().length().
+        /** The index of the first character of the match in the text of word_begin.
+         *  Satisfies 0 <= offset_begin < length of the text of word_begin.
          */
         int offset_begin;
 
-        /** One plus the index of the last character of the match in (*it_end)->text().
-         *  Satisfies 0 < offset_end <= (*it_end)->text().length().
+        /** One plus the index of the last character of the match in the text of word_end.
+         *  Satisfies 0 < offset_end <= length of the text of word_end.
          */
         int offset_end;
 };
@@ -214,7 +214,7 @@ NormalizedRect TextEntity::transformedArea(const QTransform &matrix) const
 
 
 TextPagePrivate::TextPagePrivate()
-    : m_page( nullptr )
+    : m_wordOffsets( 1, 0 ), m_textOrderCorrected( false ), m_page( nullptr )
 {
 }
 
@@ -331,7 +331,8 @@ private:
 
 RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
 {
-    if ( d->m_words.isEmpty() )
+    d->compactWords();
+    if ( d->wordCount() == 0 )
         return new RegularAreaRect();
 
 /**
@@ -533,15 +534,15 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
         if(endC.y * scaleY < minY) endC.y = minY/scaleY;
     }
 
-    TextList::ConstIterator it = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
-    TextList::ConstIterator start = it, end = itEnd, tmpIt = it; //, tmpItEnd = itEnd;
+    int it = 0, itEnd = d->wordCount();
+    int start = it, end = itEnd, tmpIt = it; //, tmpItEnd = itEnd;
     const MergeSide side = d->m_page ? (MergeSide)d->m_page->totalOrientation() : MergeRight;
 
     NormalizedRect tmp;
     //case 2(a)
     for ( ; it != itEnd; ++it )
     {
-        tmp = (*it)->area;
+        tmp = d->wordArea(it);
         if(tmp.contains(startC.x,startC.y)){
             start = it;
         }
@@ -557,7 +558,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
         for ( ; it != itEnd; ++it )
         {
             // is there any text rectangle within the start_end rect
-            tmp = (*it)->area;
+            tmp = d->wordArea(it);
             if(start_end.intersects(tmp))
                 break;
         }
@@ -583,7 +584,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
         {
             for ( ; it != itEnd; ++it )
             {
-                rect= (*it)->area;
+                rect= d->wordArea(it);
                 rect.isBottom(startC) ? flagV = false: flagV = true;
 
                 if(flagV && rect.isRight(startC))
@@ -603,7 +604,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
 
             for ( ; it != itEnd; ++it )
             {
-                rect= (*it)->area;
+                rect= d->wordArea(it);
 
                 if(rect.isBottomOrLevel(startC) && rect.isRight(startC))
                 {
@@ -640,7 +641,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
         {
             for ( ; itEnd >= it; itEnd-- )
             {
-                rect= (*itEnd)->area;
+                rect= d->wordArea(itEnd);
                 rect.isTop(endC) ? flagV = false: flagV = true;
 
                 if(flagV && rect.isLeft(endC))
@@ -656,7 +657,7 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
             int distance = scaleX + scaleY + 100;
             for ( ; itEnd >= it; itEnd-- )
             {
-                rect= (*itEnd)->area;
+                rect= d->wordArea(itEnd);
 
                 if(rect.isTopOrLevel(endC) && rect.isLeft(endC))
                 {
@@ -701,11 +702,11 @@ RegularAreaRect * TextPage::textArea ( TextSelection * sel) const
     }
 
     // removes the possibility of crash, in case none of 1 to 3 is true
-    if(end == d->m_words.constEnd()) end--;
+    if(end == d->wordCount()) end--;
 
     for( ;start <= end ; start++)
     {
-        ret->appendShape( (*start)->transformedArea( matrix ), side );
+        ret->appendShape( d->transformedWordArea( start, matrix ), side );
      }
 
 #endif
@@ -718,12 +719,13 @@ RegularAreaRect* TextPage::findText( int searchID, const QString &query, SearchD
                                      Qt::CaseSensitivity caseSensitivity, const RegularAreaRect *area )
 {
     SearchDirection dir=direct;
+    d->compactWords();
     // invalid search request
-    if ( d->m_words.isEmpty() || query.isEmpty() || ( area && area->isNull() ) )
+    if ( d->wordCount() == 0 || query.isEmpty() || ( area && area->isNull() ) )
         return nullptr;
-    TextList::ConstIterator start;
+    int start;
     int start_offset = 0;
-    TextList::ConstIterator end;
+    int end;
     const QMap< int, SearchPoint* >::const_iterator sIt = d->m_searchPoints.constFind( searchID );
     if ( sIt == d->m_searchPoints.constEnd() )
     {
@@ -738,25 +740,25 @@ RegularAreaRect* TextPage::findText( int searchID, const QString &query, SearchD
     switch ( dir )
     {
         case FromTop:
-            start = d->m_words.constBegin();
+            start = 0;
             start_offset = 0;
-            end = d->m_words.constEnd();
+            end = d->wordCount();
             break;
         case FromBottom:
-            start = d->m_words.constEnd();
+            start = d->wordCount();
             start_offset = 0;
-            end = d->m_words.constBegin();
+            end = 0;
             forward = false;
             break;
         case NextResult:
-            start = (*sIt)->it_end;
+            start = (*sIt)->word_end;
             start_offset = (*sIt)->offset_end;
-            end = d->m_words.constEnd();
+            end = d->wordCount();
             break;
         case PreviousResult:
-            start = (*sIt)->it_begin;
+            start = (*sIt)->word_begin;
             start_offset = (*sIt)->offset_begin;
-            end = d->m_words.constBegin();
+            end = 0;
             forward = false;
             break;
     };
@@ -778,7 +780,7 @@ RegularAreaRect* TextPage::findText( int searchID, const QString &query, SearchD
 // we have a '-' just followed by a '\n' character
 // check if the string contains a '-' character
 // if the '-' is the last entry
-static int stringLengthAdaptedWithHyphen(const QString &str, const TextList::ConstIterator &it, const TextList::ConstIterator &textListEnd)
+static int stringLengthAdaptedWithHyphen(const QString &str, const TextPagePrivate *d, int word)
 {
     int len = str.length();
     
@@ -788,11 +790,11 @@ static int stringLengthAdaptedWithHyphen(const QString &str, const TextList::Con
     // if the '-' is the last entry
     if ( str.endsWith( QLatin1Char('-') ) )
     {
-        // validity chek of it + 1
-        if ( ( it + 1 ) != textListEnd )
+        // validity chek of word + 1
+        if ( ( word + 1 ) != d->wordCount() )
         {
             // 1. if the next character is '\n'
-            const QString &lookahedStr = (*(it+1))->text();
+            const QString lookahedStr = d->wordText( word + 1 );
             if (lookahedStr.startsWith(QLatin1Char('\n')))
             {
                 len -= 1;
@@ -800,8 +802,8 @@ static int stringLengthAdaptedWithHyphen(const QString &str, const TextList::Con
             else
             {
                 // 2. if the next word is in a different line or not
-                const NormalizedRect& hyphenArea = (*it)->area;
-                const NormalizedRect& lookaheadArea = (*(it + 1))->area;
+                const NormalizedRect hyphenArea = d->wordArea( word );
+                const NormalizedRect lookaheadArea = d->wordArea( word + 1 );
 
                 // lookahead to check whether both the '-' rect and next character rect overlap
                 if( !doesConsumeY( hyphenArea, lookaheadArea, 70 ) )
@@ -826,14 +828,9 @@ RegularAreaRect* TextPagePrivate::searchPointToArea(const SearchPoint* sp)
     const QTransform matrix = pagePrivate ? pagePrivate->rotationMatrix() : QTransform();
     RegularAreaRect* ret=new RegularAreaRect;
 
-    for (TextList::ConstIterator it = sp->it_begin; ; it++)
+    for (int word = sp->word_begin; word <= sp->word_end; ++word)
     {
-        const TinyTextEntity* curEntity = *it;
-        ret->append( curEntity->transformedArea( matrix ) );
-
-        if (it == sp->it_end) {
-            break;
-        }
+        ret->append( transformedWordArea( word, matrix ) );
     }
 
     ret->simplify();
@@ -842,9 +839,7 @@ RegularAreaRect* TextPagePrivate::searchPointToArea(const SearchPoint* sp)
 
 RegularAreaRect* TextPagePrivate::findTextInternalForward( int searchID, const QString &_query,
                                                              TextComparisonFunction comparer,
-                                                             const TextList::ConstIterator &start,
-                                                             int start_offset,
-                                                             const TextList::ConstIterator &end)
+                                                             int start, int start_offset, int end )
 {
     // normalize query search all unicode (including glyphs)
     const QString query = _query.normalized(QString::NormalizationForm_KC);
@@ -854,17 +849,16 @@ RegularAreaRect* TextPagePrivate::findTextInternalForward( int searchID, const Q
     // queryLeft is the length of the query we have left
     int j=0, queryLeft=query.length();
 
-    TextList::ConstIterator it = start;
+    int it = start;
     int offset = start_offset;
 
-    TextList::ConstIterator it_begin = TextList::ConstIterator();
+    int it_begin = -1;
     int offset_begin = 0; //dummy initial value to suppress compiler warnings
 
     while ( it != end )
     {
-        const TinyTextEntity* curEntity = *it;
-        const QString& str = curEntity->text();
-        int len = stringLengthAdaptedWithHyphen(str, it, m_words.constEnd());
+        const QString str = wordText( it );
+        int len = stringLengthAdaptedWithHyphen(str, this, it);
 
         if (offset >= len)
         {
@@ -873,7 +867,7 @@ RegularAreaRect* TextPagePrivate::findTextInternalForward( int searchID, const Q
             continue;
         }
 
-        if ( it_begin == TextList::ConstIterator() )
+        if ( it_begin == -1 )
         {
             it_begin = it;
             offset_begin = offset;
@@ -900,7 +894,7 @@ RegularAreaRect* TextPagePrivate::findTextInternalForward( int searchID, const Q
                     queryLeft=query.length();
                     it = it_begin;
                     offset = offset_begin+1;
-                    it_begin = TextList::ConstIterator();
+                    it_begin = -1;
             }
             else
             {
@@ -925,8 +919,8 @@ RegularAreaRect* TextPagePrivate::findTextInternalForward( int searchID, const Q
                             sIt = m_searchPoints.insert( searchID, new SearchPoint );
                         }
                         SearchPoint* sp = *sIt;
-                        sp->it_begin = it_begin;
-                        sp->it_end = it;
+                        sp->word_begin = it_begin;
+                        sp->word_end = it;
                         sp->offset_begin = offset_begin;
                         sp->offset_end = offset + min;
                         return searchPointToArea(sp);
@@ -951,9 +945,7 @@ RegularAreaRect* TextPagePrivate::findTextInternalForward( int searchID, const Q
 
 RegularAreaRect* TextPagePrivate::findTextInternalBackward( int searchID, const QString &_query,
                                                             TextComparisonFunction comparer,
-                                                            const TextList::ConstIterator &start,
-                                                            int start_offset,
-                                                            const TextList::ConstIterator &end)
+                                                            int start, int start_offset, int end )
 {
     // normalize query to search all unicode (including glyphs)
     const QString query = _query.normalized(QString::NormalizationForm_KC);
@@ -963,10 +955,10 @@ RegularAreaRect* TextPagePrivate::findTextInternalBackward( int searchID, const
     // queryLeft is the length of the query we have left
     int j=query.length(), queryLeft=query.length();
 
-    TextList::ConstIterator it = start;
+    int it = start;
     int offset = start_offset;
 
-    TextList::ConstIterator it_begin = TextList::ConstIterator();
+    int it_begin = -1;
     int offset_begin = 0; //dummy initial value to suppress compiler warnings
 
     while ( true )
@@ -980,16 +972,15 @@ RegularAreaRect* TextPagePrivate::findTextInternalBackward( int searchID, const
             it--;
         }
 
-        const TinyTextEntity* curEntity = *it;
-        const QString& str = curEntity->text();
-        int len = stringLengthAdaptedWithHyphen(str, it, m_words.constEnd());
+        const QString str = wordText( it );
+        int len = stringLengthAdaptedWithHyphen(str, this, it);
 
         if (offset <= 0)
         {
             offset = len;
         }
 
-        if ( it_begin == TextList::ConstIterator() )
+        if ( it_begin == -1 )
         {
             it_begin = it;
             offset_begin = offset;
@@ -1018,7 +1009,7 @@ RegularAreaRect* TextPagePrivate::findTextInternalBackward( int searchID, const
                     queryLeft = query.length();
                     it = it_begin;
                     offset = offset_begin-1;
-                    it_begin = TextList::ConstIterator();
+                    it_begin = -1;
             }
             else
             {
@@ -1043,8 +1034,8 @@ RegularAreaRect* TextPagePrivate::findTextInternalBackward( int searchID, const
                             sIt = m_searchPoints.insert( searchID, new SearchPoint );
                         }
                         SearchPoint* sp = *sIt;
-                        sp->it_begin = it;
-                        sp->it_end = it_begin;
+                        sp->word_begin = it;
+                        sp->word_end = it_begin;
                         sp->offset_begin = offset - min;
                         sp->offset_end = offset_begin;
                         return searchPointToArea(sp);
@@ -1078,7 +1069,9 @@ QString TextPage::text(const RegularAreaRect *area, TextAreaInclusionBehaviour b
     if ( area && area->isNull() )
         return QString();
 
-    TextList::ConstIterator it = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
+    d->compactWords();
+    int it = 0;
+    const int itEnd = d->wordCount();
     QString ret;
     if ( area )
     {
@@ -1086,25 +1079,25 @@ QString TextPage::text(const RegularAreaRect *area, TextAreaInclusionBehaviour b
         {
             if (b == AnyPixelTextAreaInclusionBehaviour)
             {
-                if ( area->intersects( (*it)->area ) )
+                if ( area->intersects( d->wordArea( it ) ) )
                 {
-                    ret += (*it)->text();
+                    ret += d->wordText( it );
                 }
             }
             else
             {
-                NormalizedPoint center = (*it)->area.center();
+                NormalizedPoint center = d->wordArea( it ).center();
                 if ( area->contains( center.x, center.y ) )
                 {
-                    ret += (*it)->text();
+                    ret += d->wordText( it );
                 }
             }
         }
     }
     else
     {
-        for ( ; it != itEnd; ++it )
-            ret += (*it)->text();
+        // the words are stored one after the other
+        ret = d->m_text;
     }
     return ret;
 }
@@ -1140,20 +1133,17 @@ void TextPagePrivate::setWordList(const TextList &list)
  */
 static void removeSpace(TextList *words)
 {
-    TextList::Iterator it = words->begin();
+    // build a new list instead of erasing in place, erase() is linear
+    TextList withoutSpaces;
+    withoutSpaces.reserve(words->count());
     const QString str(QLatin1Char(' '));
 
-    while ( it != words->end() )
+    for (TinyTextEntity *word : qAsConst(*words))
     {
-        if((*it)->text() == str)
-        {
-            it = words->erase(it);
-        }
-        else
-        {
-            ++it;
-        }
+        if (word->text() != str)
+            withoutSpaces.append(word);
     }
+    *words = withoutSpaces;
 }
 
 /**
@@ -1298,6 +1288,17 @@ QList< QPair<WordsWithCharacters, QRect> > makeAndSortLines(const WordsWithChara
     // Step 1
     std::sort(words.begin(),words.end(), compareTinyTextEntityY);
 
+    /*
+     The words are sorted by their top at a 1000 pixel resolution, so at the
+     page resolution the top of a later word can be at most this much above the
+     top of the current one. A line whose bottom is above the current top by
+     more than that can not take any more words, so we stop looking at it.
+     */
+    const int sortSlack = pageHeight / 1000 + 3;
+
+    // indexes in lines of the lines that can still take words, in creation order
+    QVector<int> openLines;
+
     // Step 2
     QList<WordWithCharacters>::Iterator it = words.begin(), itEnd = words.end();
 
@@ -1307,8 +1308,18 @@ QList< QPair<WordsWithCharacters, QRect> > makeAndSortLines(const WordsWithChara
         const QRect elementArea = (*it).area().roundedGeometry(pageWidth,pageHeight);
         bool found = false;
 
-        for( int i = 0 ; i < lines.length() ; i++)
+        // retire the lines that are fully above the current word
+        int openCount = 0;
+        for( int i = 0 ; i < openLines.count() ; i++ )
         {
+            if ( lines.at(openLines.at(i)).second.bottom() >= elementArea.top() - sortSlack )
+                openLines[openCount++] = openLines.at(i);
+        }
+        openLines.resize(openCount);
+
+        for( int o = 0 ; o < openLines.count() ; o++)
+        {
+            const int i = openLines.at(o);
             /* the line area which will be expanded
                line_rects is only necessary to preserve the topmin and bottommax of all
                the texts in the line, left and right is not necessary at all
@@ -1351,6 +1362,7 @@ QList< QPair<WordsWithCharacters, QRect> > makeAndSortLines(const WordsWithChara
         {
             WordsWithCharacters tmp;
             tmp.append((*it));
+            openLines.append(lines.length());
             lines.append(QPair<WordsWithCharacters, QRect>(tmp, elementArea));
         }
     }
@@ -1420,62 +1432,39 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
     // We would like to use QMap instead of QHash as it will keep the keys sorted
     QMap<int,int> hor_space_stat;
     QMap<int,int> col_space_stat;
-    QList< QList<QRect> > space_rects;
-    QList<QRect> max_hor_space_rects;
 
     // Space in every line
     for(int i = 0 ; i < sortedLines.length() ; i++)
     {
-        const WordsWithCharacters list = sortedLines.at(i).first;
-        QList<QRect> line_space_rects;
-        int maxSpace = 0, minSpace = pageWidth;
+        const WordsWithCharacters &list = sortedLines.at(i).first;
+        int maxSpace = 0;
 
         // for every TinyTextEntity element in the line
         WordsWithCharacters::ConstIterator it = list.begin(), itEnd = list.end();
-        QRect max_area1,max_area2;
-        QString before_max, after_max;
+        if (it == itEnd)
+            continue;
+
+        // every word is compared with the next one, so compute each area once
+        QRect area1 = (*it).area().roundedGeometry(pageWidth,pageHeight);
 
         // for every line
-        for( ; it != itEnd ; it++ )
+        for( ++it ; it != itEnd ; it++ )
         {
-            const QRect area1 = (*it).area().roundedGeometry(pageWidth,pageHeight);
-            if( it+1 == itEnd ) break;
-
-            const QRect area2 = (*(it+1)).area().roundedGeometry(pageWidth,pageHeight);
+            const QRect area2 = (*it).area().roundedGeometry(pageWidth,pageHeight);
             int space = area2.left() - area1.right();
 
             if(space > maxSpace)
-            {
-                max_area1 = area1;
-                max_area2 = area2;
                 maxSpace = space;
-                before_max = (*it).text();
-                after_max = (*(it+1)).text();
-            }
-
-            if(space < minSpace && space != 0) minSpace = space;
 
             //if we found a real space, whose length is not zero and also less than the pageWidth
             if(space != 0 && space != pageWidth)
             {
                 // increase the count of the space amount
-                if(hor_space_stat.contains(space)) hor_space_stat[space]++;
-                else hor_space_stat[space] = 1;
-
-                int left,right,top,bottom;
-
-                left = area1.right();
-                right = area2.left();
-
-                top = area2.top() < area1.top() ? area2.top() : area1.top();
-                bottom = area2.bottom() > area1.bottom() ? area2.bottom() : area1.bottom();
-
-                QRect rect(left,top,right-left,bottom-top);
-                line_space_rects.append(rect);
+                hor_space_stat[space]++;
             }
-        }
 
-        space_rects.append(line_space_rects);
+            area1 = area2;
+        }
 
         if(hor_space_stat.contains(maxSpace))
         {
@@ -1485,23 +1474,7 @@ static void calculateStatisticalInformation(const QList<WordWithCharacters> &wor
         }
 
         if(maxSpace != 0)
-        {
-            if (col_space_stat.contains(maxSpace))
-                col_space_stat[maxSpace]++;
-            else col_space_stat[maxSpace] = 1;
-
-            //store the max rect of each line
-            const int left = max_area1.right();
-                const int right = max_area2.left();
-            const int top = (max_area1.top() > max_area2.top()) ? max_area2.top() :
-                                                                  max_area1.top();
-            const int bottom = (max_area1.bottom() < max_area2.bottom()) ? max_area2.bottom() :
-                                                                           max_area1.bottom();
-
-            const QRect rect(left,top,right-left,bottom-top);
-            max_hor_space_rects.append(rect);
-        }
-        else max_hor_space_rects.append(QRect(0,0,0,0));
+            col_space_stat[maxSpace]++;
     }
 
     // All the between word space counts are in hor_space_stat
@@ -1553,6 +1526,11 @@ static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wor
 
     int i = 0;
 
+    // projection profiles, reused by all the regions; they have one more
+    // slot as they are first filled as difference arrays
+    QVector<int> proj_on_xaxis;
+    QVector<int> proj_on_yaxis;
+
     // while traversing the tree has not been ended
     while(i < tree.length())
     {
@@ -1565,12 +1543,8 @@ static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wor
         // allocate the size of proj profiles and initialize with 0
         int size_proj_y = node.area().height();
         int size_proj_x = node.area().width();
-        //dynamic memory allocation
-        QVarLengthArray<int> proj_on_xaxis(size_proj_x);
-        QVarLengthArray<int> proj_on_yaxis(size_proj_y);
-
-        for( int j = 0 ; j < size_proj_y ; ++j ) proj_on_yaxis[j] = 0;
-        for( int j = 0 ; j < size_proj_x ; ++j ) proj_on_xaxis[j] = 0;
+        proj_on_xaxis.fill(0, qMax(size_proj_x, 0) + 1);
+        proj_on_yaxis.fill(0, qMax(size_proj_y, 0) + 1);
 
         const QList<WordWithCharacters> list = node.text();
 
@@ -1591,21 +1565,30 @@ static RegionTextList XYCutForBoundingBoxes(const QList<WordWithCharacters> &wor
             TinyTextEntity *ent = list.at(j).word;
             const QRect entRect = ent->area.geometry(pageWidth, pageHeight);
 
-            // calculate vertical projection profile proj_on_xaxis1
-            for(int k = entRect.left() ; k <= entRect.left() + entRect.width() ; ++k)
+            // calculate vertical projection profile proj_on_xaxis1, the text
+            // adds its height to the [left, left + width] span of the region
+            const int x1 = qMax(entRect.left() - regionRect.left(), 0);
+            const int x2 = qMin(entRect.left() + entRect.width() - regionRect.left(), size_proj_x - 1);
+            if (x1 <= x2)
             {
-                if( ( k-regionRect.left() ) < size_proj_x && ( k-regionRect.left() ) >= 0 )
-                    proj_on_xaxis[k - regionRect.left()] += entRect.height();
+                proj_on_xaxis[x1] += entRect.height();
+                proj_on_xaxis[x2 + 1] -= entRect.height();
             }
 
             // calculate horizontal projection profile in the same way
-            for(int k = entRect.top() ; k <= entRect.top() + entRect.height() ; ++k)
+            const int y1 = qMax(entRect.top() - regionRect.top(), 0);
+            const int y2 = qMin(entRect.top() + entRect.height() - regionRect.top(), size_proj_y - 1);
+            if (y1 <= y2)
             {
-                if( ( k-regionRect.top() ) < size_proj_y && ( k-regionRect.top() ) >= 0 )
-                    proj_on_yaxis[k - regionRect.top()] += entRect.width();
+                proj_on_yaxis[y1] += entRect.width();
+                proj_on_yaxis[y2 + 1] -= entRect.width();
             }
         }
 
+        // turn the difference arrays into the actual profiles
+        for( int j = 1 ; j < size_proj_x ; ++j ) proj_on_xaxis[j] += proj_on_xaxis[j - 1];
+        for( int j = 1 ; j < size_proj_y ; ++j ) proj_on_yaxis[j] += proj_on_yaxis[j - 1];
+
         for( int j = 0 ; j < size_proj_y ; ++j )
         {
             if (proj_on_yaxis[j] > maxY)
@@ -1822,14 +1805,19 @@ WordsWithCharacters addNecessarySpace(RegionTextList tree, int pageWidth, int pa
         QList< QPair<WordsWithCharacters, QRect> > sortedLines = makeAndSortLines(tmpRegion.text(), pageWidth, pageHeight);
 
         // Step 02
+        // the words and the spaces between them are appended to the region
+        // text as we go, inserting in the middle of the lines is quadratic
+        const QString spaceStr(QStringLiteral(" "));
+        WordsWithCharacters tmpList;
         for(int i = 0 ; i < sortedLines.length() ; i++)
         {
-            WordsWithCharacters &list = sortedLines[i].first;
+            const WordsWithCharacters &list = sortedLines.at(i).first;
             for(int k = 0 ; k < list.length() ; k++ )
             {
-                const QRect area1 = list.at(k).area().roundedGeometry(pageWidth,pageHeight);
+                tmpList.append(list.at(k));
                 if( k+1 >= list.length() ) break;
 
+                const QRect area1 = list.at(k).area().roundedGeometry(pageWidth,pageHeight);
                 const QRect area2 = list.at(k+1).area().roundedGeometry(pageWidth,pageHeight);
                 const int space = area2.left() - area1.right();
 
@@ -1841,26 +1829,14 @@ WordsWithCharacters addNecessarySpace(RegionTextList tree, int pageWidth, int pa
                     const int top = area2.top() < area1.top() ? area2.top() : area1.top();
                     const int bottom = area2.bottom() > area1.bottom() ? area2.bottom() : area1.bottom();
 
-                    const QString spaceStr(QStringLiteral(" "));
                     const QRect rect(QPoint(left,top),QPoint(right,bottom));
                     const NormalizedRect entRect(rect,pageWidth,pageHeight);
                     TinyTextEntity *ent1 = new TinyTextEntity(spaceStr, entRect);
                     TinyTextEntity *ent2 = new TinyTextEntity(spaceStr, entRect);
-                    WordWithCharacters word(ent1, QList<TinyTextEntity*>() << ent2);
-
-                    list.insert(k+1, word);
-
-                    // Skip the space
-                    k++;
+                    tmpList.append(WordWithCharacters(ent1, QList<TinyTextEntity*>() << ent2));
                 }
             }
         }
-
-        WordsWithCharacters tmpList;
-        for(int i = 0 ; i < sortedLines.length() ; i++)
-        {
-            tmpList += sortedLines.at(i).first;
-        }
         tmpRegion.setText(tmpList);
     }
 
@@ -1918,6 +1894,125 @@ void TextPagePrivate::correctTextOrder()
         listOfCharacters.append(word.characters);
     }
     setWordList(listOfCharacters);
+    compactWords();
+    m_textOrderCorrected = true;
+}
+
+void TextPagePrivate::compactWords()
+{
+    if ( m_words.isEmpty() )
+        return;
+
+    int textLength = m_text.length();
+    for ( const TinyTextEntity *word : qAsConst( m_words ) )
+        textLength += word->text().length();
+    const int count = wordCount() + m_words.count();
+    m_text.reserve( textLength );
+    m_wordOffsets.reserve( count + 1 );
+    m_wordLefts.reserve( count );
+    m_wordTops.reserve( count );
+    m_wordRights.reserve( count );
+    m_wordBottoms.reserve( count );
+
+    for ( const TinyTextEntity *word : qAsConst( m_words ) )
+    {
+        m_text += word->text();
+        m_wordOffsets.append( m_text.length() );
+        m_wordLefts.append( word->area.left );
+        m_wordTops.append( word->area.top );
+        m_wordRights.append( word->area.right );
+        m_wordBottoms.append( word->area.bottom );
+    }
+
+    qDeleteAll( m_words );
+    m_words.clear();
+}
+
+QByteArray TextPagePrivate::serializeWords()
+{
+    // record layout: word count, then for every word its rect (4 floats),
+    // its length and its UTF-16 text; everything in host byte order
+    compactWords();
+    QByteArray data;
+    const quint32 count = wordCount();
+    data.append( reinterpret_cast< const char * >( &count ), sizeof( count ) );
+    for ( int i = 0; i < wordCount(); ++i )
+    {
+        const float rect[ 4 ] = { m_wordLefts.at( i ), m_wordTops.at( i ), m_wordRights.at( i ), m_wordBottoms.at( i ) };
+        const quint32 length = m_wordOffsets.at( i + 1 ) - m_wordOffsets.at( i );
+        data.append( reinterpret_cast< const char * >( rect ), sizeof( rect ) );
+        data.append( reinterpret_cast< const char * >( &length ), sizeof( length ) );
+        data.append( reinterpret_cast< const char * >( m_text.constData() + m_wordOffsets.at( i ) ), length * sizeof( QChar ) );
+    }
+    return data;
+}
+
+bool TextPagePrivate::deserializeWords( const char *data, qint64 size )
+{
+    const char *end = data + size;
+    quint32 count;
+    if ( size < (qint64)sizeof( count ) )
+        return false;
+    std::memcpy( &count, data, sizeof( count ) );
+    data += sizeof( count );
+
+    // every word takes at least its rect and its length, generators may
+    // give words without any text, so they are stored as well
+    const qint64 minWordSize = 4 * sizeof( float ) + sizeof( quint32 );
+    if ( count > ( end - data ) / minWordSize )
+        return false;
+
+    // fill the compact storage directly, the record is already laid out
+    QString text;
+    QVector< int > offsets( 1, 0 );
+    QVector< float > lefts, tops, rights, bottoms;
+    offsets.reserve( count + 1 );
+    lefts.reserve( count );
+    tops.reserve( count );
+    rights.reserve( count );
+    bottoms.reserve( count );
+    for ( quint32 i = 0; i < count; ++i )
+    {
+        float rect[ 4 ];
+        quint32 length;
+        if ( end - data < (qint64)( sizeof( rect ) + sizeof( length ) ) )
+            break;
+        std::memcpy( rect, data, sizeof( rect ) );
+        data += sizeof( rect );
+        std::memcpy( &length, data, sizeof( length ) );
+        data += sizeof( length );
+        if ( ( end - data ) / (qint64)sizeof( QChar ) < length )
+            break;
+
+        // the data may be mapped memory, so take a deep copy of the text
+        text.append( reinterpret_cast< const QChar * >( data ), length );
+        data += length * sizeof( QChar );
+        offsets.append( text.length() );
+        lefts.append( rect[ 0 ] );
+        tops.append( rect[ 1 ] );
+        rights.append( rect[ 2 ] );
+        bottoms.append( rect[ 3 ] );
+    }
+
+    if ( (quint32)lefts.count() != count )
+        return false;
+
+    setWordList( TextList() );
+    m_text = text;
+    m_wordOffsets = offsets;
+    m_wordLefts = lefts;
+    m_wordTops = tops;
+    m_wordRights = rights;
+    m_wordBottoms = bottoms;
+    m_textOrderCorrected = true;
+    return true;
+}
+
+// the text entities may outlive the page, so they get a deep copy of the text
+static QString copyOfWordText(const TextPagePrivate *d, int word)
+{
+    const QString text = d->wordText( word );
+    return QString( text.constData(), text.length() );
 }
 
 TextEntity::List TextPage::words(const RegularAreaRect *area, TextAreaInclusionBehaviour b) const
@@ -1925,33 +2020,36 @@ TextEntity::List TextPage::words(const RegularAreaRect *area, TextAreaInclusionB
     if ( area && area->isNull() )
         return TextEntity::List();
 
+    d->compactWords();
+    const int count = d->wordCount();
     TextEntity::List ret;
     if ( area )
     {
-        for (const TinyTextEntity *te : qAsConst(d->m_words))
+        for ( int i = 0; i < count; ++i )
         {
+            const NormalizedRect wordArea = d->wordArea( i );
             if (b == AnyPixelTextAreaInclusionBehaviour)
             {
-                if ( area->intersects( te->area ) )
+                if ( area->intersects( wordArea ) )
                 {
-                    ret.append( new TextEntity( te->text(), new Okular::NormalizedRect( te->area) ) );
+                    ret.append( new TextEntity( copyOfWordText( d, i ), new Okular::NormalizedRect( wordArea ) ) );
                 }
             }
             else
             {
-                const NormalizedPoint center = te->area.center();
+                const NormalizedPoint center = wordArea.center();
                 if ( area->contains( center.x, center.y ) )
                 {
-                    ret.append( new TextEntity( te->text(), new Okular::NormalizedRect( te->area) ) );
+                    ret.append( new TextEntity( copyOfWordText( d, i ), new Okular::NormalizedRect( wordArea ) ) );
                 }
             }
         }
     }
     else
     {
-        for (const TinyTextEntity *te : qAsConst(d->m_words))
+        for ( int i = 0; i < count; ++i )
         {
-            ret.append( new TextEntity( te->text(), new Okular::NormalizedRect( te->area) ) );
+            ret.append( new TextEntity( copyOfWordText( d, i ), new Okular::NormalizedRect( d->wordArea( i ) ) ) );
         }
     }
     return ret;
@@ -1959,12 +2057,13 @@ TextEntity::List TextPage::words(const RegularAreaRect *area, TextAreaInclusionB
 
 RegularAreaRect * TextPage::wordAt( const NormalizedPoint &p, QString *word ) const
 {
-    TextList::ConstIterator itBegin = d->m_words.constBegin(), itEnd = d->m_words.constEnd();
-    TextList::ConstIterator it = itBegin;
-    TextList::ConstIterator posIt = itEnd;
+    d->compactWords();
+    const int itBegin = 0, itEnd = d->wordCount();
+    int it = itBegin;
+    int posIt = itEnd;
     for ( ; it != itEnd; ++it )
     {
-        if ( (*it)->area.contains( p.x, p.y ) )
+        if ( d->wordArea( it ).contains( p.x, p.y ) )
         {
             posIt = it;
             break;
@@ -1973,7 +2072,7 @@ RegularAreaRect * TextPage::wordAt( const NormalizedPoint &p, QString *word ) co
     QString text;
     if ( posIt != itEnd )
     {
-        if ( (*posIt)->text().simplified().isEmpty() )
+        if ( d->wordText( posIt ).simplified().isEmpty() )
         {
             return nullptr;
         }
@@ -1981,7 +2080,7 @@ RegularAreaRect * TextPage::wordAt( const NormalizedPoint &p, QString *word ) co
         while ( posIt != itBegin )
         {
             --posIt;
-            const QString itText = (*posIt)->text();
+            const QString itText = d->wordText( posIt );
             if ( itText.right(1).at(0).isSpace() )
             {
                 if (itText.endsWith(QLatin1String("-\n")))
@@ -1994,7 +2093,7 @@ RegularAreaRect * TextPage::wordAt( const NormalizedPoint &p, QString *word ) co
                 if (itText == QLatin1String("\n") && posIt != itBegin )
                 {
                     --posIt;
-                    if ((*posIt)->text().endsWith(QLatin1String("-"))) {
+                    if (d->wordText( posIt ).endsWith(QLatin1String("-"))) {
                         // Is an hyphenated word
                         // continue searching the start of the word back
                         continue;
@@ -2009,14 +2108,14 @@ RegularAreaRect * TextPage::wordAt( const NormalizedPoint &p, QString *word ) co
         RegularAreaRect *ret = new RegularAreaRect();
         for ( ; posIt != itEnd; ++posIt )
         {
-            const QString itText = (*posIt)->text();
+            const QString itText = d->wordText( posIt );
             if ( itText.simplified().isEmpty() )
             {
                 break;
             }
             
-            ret->appendShape( (*posIt)->area );
-            text += (*posIt)->text();
+            ret->appendShape( d->wordArea( posIt ) );
+            text += d->wordText( posIt );
             if (itText.right(1).at(0).isSpace())
             {
                 if (!text.endsWith(QLatin1String("-\n")))
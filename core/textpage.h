@@ -110,6 +110,7 @@ class OKULARCORE_EXPORT TextPage
     /// @cond PRIVATE
     friend class Page;
     friend class PagePrivate;
+    friend class TextPageCache;
     /// @endcond
 
     public:
@@ -11,18 +11,23 @@
 #ifndef _OKULAR_TEXTPAGE_P_H_
 #define _OKULAR_TEXTPAGE_P_H_
 
+#include <QByteArray>
 #include <QList>
 #include <QMap>
 #include <QPair>
+#include <QString>
 #include <QTransform>
+#include <QVector>
+
+#include "area.h"
 
 class SearchPoint;
 
 /**
  * Memory-optimized storage of a TextEntity. Stores a string and its bounding box.
  *
- * When a generator adds a TextEntity to a TextPage, it is internally stored as TinyTextEntity.
- * TinyTextEntity is also internally used to get the geometry of text selections and highlight areas.
+ * When a generator adds a TextEntity to a TextPage, it is internally stored as TinyTextEntity
+ * until the page is laid out, then the words are moved to the compact storage of TextPagePrivate.
  *
  * @see TextEntity
  */
@@ -54,14 +59,10 @@ class TextPagePrivate
 
         RegularAreaRect * findTextInternalForward( int searchID, const QString &query,
                                                    TextComparisonFunction comparer,
-                                                   const TextList::ConstIterator &start,
-                                                   int start_offset,
-                                                   const TextList::ConstIterator &end);
+                                                   int start, int start_offset, int end );
         RegularAreaRect * findTextInternalBackward( int searchID, const QString &query,
                                                     TextComparisonFunction comparer,
-                                                    const TextList::ConstIterator &start,
-                                                    int start_offset,
-                                                    const TextList::ConstIterator &end );
+                                                    int start, int start_offset, int end );
 
         /**
          * Copy a TextList to m_words, the pointers of list are adopted
@@ -74,8 +75,70 @@ class TextPagePrivate
          */
         void correctTextOrder();
 
+        /**
+         * Moves the words still in m_words to the end of the compact storage
+         */
+        void compactWords();
+
+        /**
+         * Number of words in the compact storage
+         */
+        inline int wordCount() const
+        {
+            return m_wordOffsets.count() - 1;
+        }
+
+        /**
+         * Text of the word @p i of the compact storage, the string does not own its data
+         */
+        inline QString wordText( int i ) const
+        {
+            return QString::fromRawData( m_text.constData() + m_wordOffsets.at( i ),
+                                         m_wordOffsets.at( i + 1 ) - m_wordOffsets.at( i ) );
+        }
+
+        /**
+         * Bounding box of the word @p i of the compact storage
+         */
+        inline NormalizedRect wordArea( int i ) const
+        {
+            return NormalizedRect( m_wordLefts.at( i ), m_wordTops.at( i ), m_wordRights.at( i ), m_wordBottoms.at( i ) );
+        }
+
+        inline NormalizedRect transformedWordArea( int i, const QTransform &matrix ) const
+        {
+            NormalizedRect transformed_area = wordArea( i );
+            transformed_area.transform( matrix );
+            return transformed_area;
+        }
+
+        /**
+         * Serializes the words to a flat binary record, see TextPageCache
+         */
+        QByteArray serializeWords();
+
+        /**
+         * Replaces the words with the ones of a record made by serializeWords(),
+         * returns false if the record is malformed
+         */
+        bool deserializeWords( const char *data, qint64 size );
+
         // variables those can be accessed directly from TextPage
+
+        // words added by the generator, only used until the page is laid out
         TextList m_words;
+
+        // compact storage of the words once laid out: the text of all the words
+        // one after the other, where each word starts in it plus one final offset,
+        // and the bounding boxes as one array per edge
+        QString m_text;
+        QVector< int > m_wordOffsets;
+        QVector< float > m_wordLefts;
+        QVector< float > m_wordTops;
+        QVector< float > m_wordRights;
+        QVector< float > m_wordBottoms;
+
+        bool m_textOrderCorrected;
         QMap< int, SearchPoint* > m_searchPoints;
         Page *m_page;
 
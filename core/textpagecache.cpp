@@ -0,0 +1,276 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "textpagecache_p.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+
+#include "debug_p.h"
+#include "textpage.h"
+#include "textpage_p.h"
+
+using namespace Okular;
+
+// bump whenever the layout of the file or the text order algorithm changes
+static const quint32 CacheVersion = 2;
+static const char CacheMagic[ 8 ] = { 'O', 'K', 'T', 'X', 'T', 'P', 'G', 'S' };
+static const quint32 ByteOrderMark = 0x01020304;
+static const int FingerprintSize = 20; // SHA-1
+
+// magic, version, byte order mark, page count, fingerprint
+static const qint64 HeaderSize = sizeof( CacheMagic ) + 3 * sizeof( quint32 ) + FingerprintSize;
+
+// the caches of the documents opened least recently go beyond that
+static const qint64 MaxCacheDirSize = 100 * 1024 * 1024;
+
+TextPageCache::TextPageCache( const QString &fileName, const QByteArray &fingerprint, int pageCount )
+    : m_file( fileName ), m_fingerprint( fingerprint ), m_pageCount( pageCount ),
+      m_map( nullptr ), m_mapSize( 0 ), m_valid( false )
+{
+    Q_ASSERT( m_fingerprint.size() == FingerprintSize );
+
+    if ( !m_file.open( QIODevice::ReadWrite ) )
+    {
+        qCWarning(OkularCoreDebug) << "Could not open the text cache" << fileName;
+        return;
+    }
+
+    if ( readHeader() )
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+        // the modification time tells the least recently used caches apart
+        m_file.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+#endif
+        m_valid = true;
+    }
+    else
+    {
+        m_valid = reset();
+    }
+
+    removeOldCaches();
+}
+
+TextPageCache::~TextPageCache()
+{
+    if ( m_map )
+        m_file.unmap( m_map );
+}
+
+bool TextPageCache::isValid() const
+{
+    return m_valid;
+}
+
+bool TextPageCache::contains( int pageNumber ) const
+{
+    return m_valid && pageNumber >= 0 && pageNumber < m_pageCount && m_offsets.at( pageNumber ) != 0;
+}
+
+TextPage *TextPageCache::textPage( int pageNumber )
+{
+    if ( !contains( pageNumber ) )
+        return nullptr;
+
+    const quint64 offset = m_offsets.at( pageNumber );
+    if ( (qint64)( offset + sizeof( quint32 ) ) > m_mapSize && !remap() )
+        return nullptr;
+
+    quint32 recordSize;
+    std::memcpy( &recordSize, m_map + offset, sizeof( recordSize ) );
+    if ( (qint64)( offset + sizeof( recordSize ) + recordSize ) > m_mapSize )
+    {
+        qCWarning(OkularCoreDebug) << "Truncated text cache record for page" << pageNumber;
+        invalidate( pageNumber );
+        return nullptr;
+    }
+
+    TextPage *textPage = new TextPage();
+    if ( !textPage->d->deserializeWords( reinterpret_cast< const char * >( m_map + offset + sizeof( recordSize ) ), recordSize ) )
+    {
+        qCWarning(OkularCoreDebug) << "Corrupted text cache record for page" << pageNumber;
+        delete textPage;
+        invalidate( pageNumber );
+        return nullptr;
+    }
+    return textPage;
+}
+
+void TextPageCache::invalidate( int pageNumber )
+{
+    // the record stays in the file, store() appends the next one
+    const quint64 offset = 0;
+    m_offsets[ pageNumber ] = offset;
+    if ( !m_file.seek( HeaderSize + pageNumber * sizeof( quint64 ) ) ||
+         m_file.write( reinterpret_cast< const char * >( &offset ), sizeof( offset ) ) != sizeof( offset ) )
+    {
+        qCWarning(OkularCoreDebug) << "Could not write to the text cache" << m_file.fileName();
+        return;
+    }
+    m_file.flush();
+}
+
+void TextPageCache::store( int pageNumber, const TextPage *textPage )
+{
+    if ( !m_valid || !textPage || pageNumber < 0 || pageNumber >= m_pageCount || m_offsets.at( pageNumber ) != 0 )
+        return;
+
+    const QByteArray record = textPage->d->serializeWords();
+    const quint32 recordSize = record.size();
+    const quint64 offset = m_file.size();
+
+    // append the record first, and only then make the table point to it, so
+    // an interrupted write never leaves a dangling offset behind
+    if ( !m_file.seek( offset ) ||
+         m_file.write( reinterpret_cast< const char * >( &recordSize ), sizeof( recordSize ) ) != sizeof( recordSize ) ||
+         m_file.write( record ) != record.size() ||
+         !m_file.seek( HeaderSize + pageNumber * sizeof( quint64 ) ) ||
+         m_file.write( reinterpret_cast< const char * >( &offset ), sizeof( offset ) ) != sizeof( offset ) )
+    {
+        qCWarning(OkularCoreDebug) << "Could not write to the text cache" << m_file.fileName();
+        return;
+    }
+    m_file.flush();
+
+    m_offsets[ pageNumber ] = offset;
+}
+
+bool TextPageCache::readHeader()
+{
+    const qint64 tableSize = m_pageCount * sizeof( quint64 );
+    if ( m_file.size() < HeaderSize + tableSize || !remap() )
+        return false;
+
+    const uchar *data = m_map;
+    quint32 version, byteOrderMark, pageCount;
+    if ( std::memcmp( data, CacheMagic, sizeof( CacheMagic ) ) != 0 )
+        return false;
+    data += sizeof( CacheMagic );
+    std::memcpy( &version, data, sizeof( version ) );
+    data += sizeof( version );
+    std::memcpy( &byteOrderMark, data, sizeof( byteOrderMark ) );
+    data += sizeof( byteOrderMark );
+    std::memcpy( &pageCount, data, sizeof( pageCount ) );
+    data += sizeof( pageCount );
+    if ( version != CacheVersion || byteOrderMark != ByteOrderMark || (int)pageCount != m_pageCount ||
+         std::memcmp( data, m_fingerprint.constData(), FingerprintSize ) != 0 )
+        return false;
+    data += FingerprintSize;
+
+    m_offsets.resize( m_pageCount );
+    std::memcpy( m_offsets.data(), data, tableSize );
+    for ( quint64 &offset : m_offsets )
+    {
+        if ( (qint64)offset < HeaderSize + tableSize || (qint64)offset >= m_mapSize )
+            offset = 0;
+    }
+    return true;
+}
+
+bool TextPageCache::reset()
+{
+    if ( m_map )
+    {
+        m_file.unmap( m_map );
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+
+    m_offsets.fill( 0, m_pageCount );
+
+    QByteArray header;
+    header.append( CacheMagic, sizeof( CacheMagic ) );
+    header.append( reinterpret_cast< const char * >( &CacheVersion ), sizeof( CacheVersion ) );
+    header.append( reinterpret_cast< const char * >( &ByteOrderMark ), sizeof( ByteOrderMark ) );
+    const quint32 pageCount = m_pageCount;
+    header.append( reinterpret_cast< const char * >( &pageCount ), sizeof( pageCount ) );
+    header.append( m_fingerprint );
+    header.append( reinterpret_cast< const char * >( m_offsets.constData() ), m_pageCount * sizeof( quint64 ) );
+
+    if ( !m_file.resize( 0 ) || !m_file.seek( 0 ) || m_file.write( header ) != header.size() )
+    {
+        qCWarning(OkularCoreDebug) << "Could not initialize the text cache" << m_file.fileName();
+        return false;
+    }
+    m_file.flush();
+    return true;
+}
+
+bool TextPageCache::remap()
+{
+    if ( m_map )
+        m_file.unmap( m_map );
+
+    m_mapSize = m_file.size();
+    m_map = m_file.map( 0, m_mapSize );
+    if ( !m_map )
+    {
+        m_mapSize = 0;
+        return false;
+    }
+    return true;
+}
+
+void TextPageCache::removeOldCaches() const
+{
+    const QFileInfo current( m_file );
+
+    QFileInfoList caches;
+    qint64 totalSize = 0;
+    QDirIterator it( current.absolutePath(), QDir::Files );
+    while ( it.hasNext() )
+    {
+        it.next();
+        const QFileInfo fi = it.fileInfo();
+        totalSize += fi.size();
+        if ( fi.fileName() != current.fileName() )
+            caches.append( fi );
+    }
+
+    if ( totalSize <= MaxCacheDirSize )
+        return;
+
+    std::sort( caches.begin(), caches.end(), []( const QFileInfo &a, const QFileInfo &b ) { return a.lastModified() < b.lastModified(); } );
+    for ( const QFileInfo &fi : qAsConst( caches ) )
+    {
+        if ( totalSize <= MaxCacheDirSize )
+            break;
+        if ( QFile::remove( fi.absoluteFilePath() ) )
+            totalSize -= fi.size();
+    }
+}
+
+QByteArray TextPageCache::fingerprint( const QString &docFile, const QString &generatorName, const QByteArray &configuration )
+{
+    const QFileInfo fi( docFile );
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+    hash.addData( fi.canonicalFilePath().toUtf8() );
+    hash.addData( QByteArray::number( fi.size() ) );
+    hash.addData( QByteArray::number( fi.lastModified().toMSecsSinceEpoch() ) );
+    hash.addData( generatorName.toUtf8() );
+    hash.addData( configuration );
+    return hash.result();
+}
+
+QString TextPageCache::cacheFileName( const QByteArray &fingerprint )
+{
+    const QString cacheDir = QStandardPaths::writableLocation( QStandardPaths::GenericCacheLocation )
+            + QStringLiteral( "/okular/textpages" );
+    if ( !QFileInfo::exists( cacheDir ) )
+        QDir().mkpath( cacheDir );
+    return cacheDir + QLatin1Char( '/' ) + QString::fromLatin1( fingerprint.toHex() );
+}
@@ -0,0 +1,105 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_TEXTPAGECACHE_P_H_
+#define _OKULAR_TEXTPAGECACHE_P_H_
+
+#include <QByteArray>
+#include <QFile>
+#include <QVector>
+
+namespace Okular {
+
+class TextPage;
+
+/**
+ * On-disk cache of the laid out text of the pages of a document.
+ *
+ * Extracting the text of a page and computing its reading order is
+ * expensive, so the final list of words of every TextPage is stored in a
+ * per-document cache file, and read back when the document is reopened
+ * instead of asking the generator again.
+ *
+ * The file starts with a versioned header holding the document fingerprint,
+ * followed by a table with the offset of every page record. Records are
+ * appended as pages get their text. The file is memory-mapped, so reading a
+ * page back only touches its own record.
+ *
+ * The cache files of all the documents take at most 100 MiB, the ones of
+ * the documents opened least recently are removed first. The cache is not
+ * used when the CacheTextPages setting is off.
+ */
+class TextPageCache
+{
+    public:
+        /**
+         * Opens (or creates) the cache for the document with the given
+         * @p fingerprint and @p pageCount. A cache file that does not match
+         * them is discarded.
+         */
+        TextPageCache( const QString &fileName, const QByteArray &fingerprint, int pageCount );
+        ~TextPageCache();
+
+        /**
+         * Whether the cache file could be opened.
+         */
+        bool isValid() const;
+
+        /**
+         * Whether the text of page @p pageNumber is in the cache.
+         */
+        bool contains( int pageNumber ) const;
+
+        /**
+         * Returns a new TextPage for @p pageNumber rebuilt from the cache,
+         * or nullptr if there is none. Its text order is already corrected.
+         *
+         * A record that cannot be read back is dropped, so that the page is
+         * stored again.
+         */
+        TextPage *textPage( int pageNumber );
+
+        /**
+         * Stores the words of @p textPage as the text of page @p pageNumber.
+         */
+        void store( int pageNumber, const TextPage *textPage );
+
+        /**
+         * Returns the fingerprint identifying the document file @p docFile
+         * opened with the generator @p generatorName, whose settings that
+         * affect the text layout are given in @p configuration.
+         */
+        static QByteArray fingerprint( const QString &docFile, const QString &generatorName, const QByteArray &configuration );
+
+        /**
+         * Returns the cache file name for the given @p fingerprint.
+         */
+        static QString cacheFileName( const QByteArray &fingerprint );
+
+    private:
+        bool readHeader();
+        bool reset();
+        bool remap();
+        void invalidate( int pageNumber );
+        void removeOldCaches() const;
+
+        QFile m_file;
+        QByteArray m_fingerprint;
+        int m_pageCount;
+        QVector< quint64 > m_offsets;
+        uchar *m_map;
+        qint64 m_mapSize;
+        bool m_valid;
+
+        Q_DISABLE_COPY( TextPageCache )
+};
+
+}
+
+#endif
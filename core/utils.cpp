@@ -22,6 +22,8 @@
 #include <QWindow>
 #include <QScreen>
 
+#include <algorithm>
+#include <iterator>
 
 
 using namespace Okular;
@@ -73,55 +75,71 @@ QSizeF Utils::realDpi(QWidget* widgetOnScreen)
     return QSizeF(72, 72);
 }
 
-inline static bool isPaperColor( QRgb argb, QRgb paperColor ) {
-    return ( argb & 0xFFFFFF ) == ( paperColor & 0xFFFFFF); // ignore alpha
-}
-
 NormalizedRect Utils::imageBoundingBox( const QImage * image )
 {
     if ( !image )
         return NormalizedRect();
 
+    // the pixels are compared a row at a time, in a format where every
+    // pixel is a QRgb; the pages are usually rendered premultiplied, and
+    // mostly opaque, so those are scanned as they are
+    QImage convertedImage;
+    if ( image->format() != QImage::Format_RGB32 && image->format() != QImage::Format_ARGB32 &&
+         image->format() != QImage::Format_ARGB32_Premultiplied )
+    {
+        convertedImage = image->convertToFormat( QImage::Format_ARGB32 );
+        image = &convertedImage;
+    }
+
     const int width = image->width();
     const int height = image->height();
-    const QRgb paperColor = SettingsCore::paperColor().rgb();
-    int left, top, bottom, right, x, y;
+    const QRgb paperColor = SettingsCore::paperColor().rgb() & 0xFFFFFF;
+    const bool premultiplied = image->format() == QImage::Format_ARGB32_Premultiplied;
+    const auto isInk = [paperColor, premultiplied]( QRgb argb ) {
+        // the color of translucent premultiplied pixels is the one they
+        // would have once converted
+        if ( premultiplied && qAlpha( argb ) != 255 )
+            argb = qUnpremultiply( argb );
+        return ( argb & 0xFFFFFF ) != paperColor; // ignore alpha
+    };
+    const auto scanLine = [image]( int y ) { return reinterpret_cast< const QRgb * >( image->constScanLine( y ) ); };
+    int left = 0, top, bottom, right = 0;
 
 #ifdef BBOX_DEBUG
     QTime time;
     time.start();
 #endif
 
-    // Scan pixels for top non-white
+    // Scan rows for top non-white
     for ( top = 0; top < height; ++top )
-        for ( x = 0; x < width; ++x )
-            if ( !isPaperColor( image->pixel( x, top ), paperColor ) )
-                goto got_top;
-    return NormalizedRect( 0, 0, 0, 0 ); // the image is blank
-got_top:
-    left = right = x;
-
-    // Scan pixels for bottom non-white
-    for ( bottom = height-1; bottom >= top; --bottom )
-        for ( x = width-1; x >= 0; --x )
-            if ( !isPaperColor( image->pixel( x, bottom ), paperColor ) )
-                goto got_bottom;
-    Q_ASSERT( 0 ); // image changed?!
-got_bottom:
-    if ( x < left )
-        left = x;
-    if ( x > right )
-        right = x;
+    {
+        const QRgb *row = scanLine( top );
+        const QRgb *ink = std::find_if( row, row + width, isInk );
+        if ( ink != row + width )
+        {
+            left = right = ink - row;
+            break;
+        }
+    }
+    if ( top == height )
+        return NormalizedRect( 0, 0, 0, 0 ); // the image is blank
+
+    // Scan rows for bottom non-white
+    for ( bottom = height - 1; bottom > top; --bottom )
+    {
+        const QRgb *row = scanLine( bottom );
+        if ( std::any_of( row, row + width, isInk ) )
+            break;
+    }
 
     // Scan for leftmost and rightmost (we already found some bounds on these):
-    for ( y = top; y <= bottom && ( left > 0 || right < width-1 ); ++y )
+    for ( int y = top; y <= bottom && ( left > 0 || right < width - 1 ); ++y )
     {
-        for ( x = 0; x < left; ++x )
-            if ( !isPaperColor( image->pixel( x, y ), paperColor ) )
-                left = x;
-        for ( x = width-1; x > right+1; --x )
-            if ( !isPaperColor( image->pixel( x, y ), paperColor ) )
-                right = x;
+        const QRgb *row = scanLine( y );
+        left = std::find_if( row, row + left, isInk ) - row;
+        const std::reverse_iterator< const QRgb * > rightInk = std::find_if( std::reverse_iterator< const QRgb * >( row + width ),
+                                                                             std::reverse_iterator< const QRgb * >( row + right + 1 ), isInk );
+        right = rightInk.base() - row - 1;
     }
 
     NormalizedRect bbox( QRect( left, top, ( right - left + 1), ( bottom - top + 1 ) ),
@@ -32,6 +32,7 @@ class ChmGeneratorTest
 
 void ChmGeneratorTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("ChmGeneratorTest") );
     m_document = new Okular::Document( 0 );
     const QString testFile = QStringLiteral(KDESRCDIR "autotests/data/test.chm");
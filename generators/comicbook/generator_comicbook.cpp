@@ -9,7 +9,7 @@
 
 #include "generator_comicbook.h"
 
-#include <QPainter>
+#include <QMutex>
 #include <QPrinter>
 
 #include <KAboutData>
@@ -18,6 +18,7 @@
 #include <core/document.h>
 #include <core/page.h>
 #include <core/fileprinter.h>
+#include <core/rasterprinter.h>
 
 #include "debug_comicbook.h"
 
@@ -61,35 +62,36 @@ QImage ComicBookGenerator::image( Okular::PixmapRequest * request )
     int width = request->width();
     int height = request->height();
 
+    userMutex()->lock();
     QImage image = mDocument.pageImage( request->pageNumber() );
+    userMutex()->unlock();
 
     return image.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
 }
 
 bool ComicBookGenerator::print( QPrinter& printer )
 {
-    QPainter p( &printer );
+    const QSize printerSize( printer.width(), printer.height() );
 
-    QList<int> pageList = Okular::FilePrinter::pageList( printer, document()->pages(),
-                                                         document()->currentPage() + 1,
-                                                         document()->bookmarkedPageList() );
-
-    for ( int i = 0; i < pageList.count(); ++i ) {
-
-        QImage image = mDocument.pageImage( pageList[i] - 1 );
+    // the pages are decoded one at a time, but scaled in parallel
+    Okular::RasterPrinter rasterPrinter( [this, printerSize]( int page, QRectF * )
+    {
+        userMutex()->lock();
+        QImage image = mDocument.pageImage( page );
+        userMutex()->unlock();
 
-        if ( ( image.width() > printer.width() ) || ( image.height() > printer.height() ) )
+        if ( ( image.width() > printerSize.width() ) || ( image.height() > printerSize.height() ) )
 
-            image = image.scaled( printer.width(), printer.height(),
-                                  Qt::KeepAspectRatio, Qt::SmoothTransformation );
+            image = image.scaled( printerSize, Qt::KeepAspectRatio, Qt::SmoothTransformation );
 
-        if ( i != 0 )
-            printer.newPage();
+        return image;
+    } );
 
-        p.drawImage( 0, 0, image );
-    }
+    QList<int> pageList = Okular::FilePrinter::pageList( printer, document()->pages(),
+                                                         document()->currentPage() + 1,
+                                                         document()->bookmarkedPageList() );
 
-    return true;
+    return rasterPrinter.print( printer, pageList );
 }
 
 Q_LOGGING_CATEGORY(OkularComicbookDebug, "org.kde.okular.generators.comicbook", QtWarningMsg)
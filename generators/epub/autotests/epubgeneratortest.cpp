@@ -32,6 +32,7 @@ class EpubGeneratorTest
 
 void EpubGeneratorTest::initTestCase()
 {
+    QStandardPaths::setTestModeEnabled( true );
     Okular::SettingsCore::instance( QStringLiteral("EpubGeneratorTest") );
     m_document = new Okular::Document( 0 );
     const QString testFile = QStringLiteral(KDESRCDIR "autotests/data/test.epub");
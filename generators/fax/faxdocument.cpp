@@ -10,8 +10,12 @@
 #include "faxdocument.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtEndian>
 
 #include "faxexpand.h"
 
@@ -56,16 +60,28 @@ static void normalize( pagenode *pn, int revbits, int swapbytes, size_t length )
     }
 }
 
+/* rows of the image for every line of the fax, doubled: fine resolution
+   lines are stretched by 1.5, normal resolution ones by 3 */
+static int stretch( const pagenode *pn )
+{
+    return pn->vres ? 3 : 6;
+}
+
 static bool new_image( pagenode *pn, int width, int height )
 {
-    pn->image = QImage( width, height, QImage::Format_MonoLSB );
+    pn->image = QImage( width, height, QImage::Format_Mono );
+    if ( pn->image.isNull() )
+        return false;
+
     pn->image.setColor( 0, qRgb( 255, 255, 255 ) );
     pn->image.setColor( 1, qRgb( 0, 0, 0 ) );
+    pn->image.fill( 0 );
     pn->bytes_per_line = pn->image.bytesPerLine();
     pn->dpi = FAX_DPI_FINE;
-    pn->imageData = new uchar[ width * height ];
+    /* the expander draws straight into the image */
+    pn->imageData = pn->image.bits();
 
-    return !pn->image.isNull();
+    return true;
 }
 
 /* get compressed data into memory */
@@ -144,7 +160,7 @@ static unsigned char* getstrip( pagenode *pn, int strip )
 
 static void draw_line( pixnum *run, int lineNum, pagenode *pn )
 {
-    t32bits *p, *p1;  /* p - current line, p1 - low-res duplicate */
+    t32bits *p;       /* p - current line */
     pixnum *r;        /* pointer to run-lengths */
     t32bits pix;      /* current pixel value */
     t32bits acc;      /* pixel accumulator */
@@ -156,8 +172,12 @@ static void draw_line( pixnum *run, int lineNum, pagenode *pn )
     if ( lineNum >= pn->size.height() )
         return;
 
-    p = (t32bits *)(pn->imageData + lineNum*(2-pn->vres)*pn->bytes_per_line);
-    p1 =(t32bits *)(pn->vres ? nullptr : p + pn->bytes_per_line/sizeof(*p));
+    /* the pixels are accumulated from the most significant bit, so store the
+       words big endian to get the msb-first bytes of QImage::Format_Mono */
+    const int firstRow = lineNum * stretch( pn ) / 2;
+    const int endRow = ( lineNum + 1 ) * stretch( pn ) / 2;
+    uchar *line = pn->imageData + firstRow * pn->bytes_per_line;
+    p = (t32bits *)line;
 
     r = run;
     acc = 0;
@@ -183,40 +203,37 @@ static void draw_line( pixnum *run, int lineNum, pagenode *pn )
             pix = ~pix;
             continue;
         }
-        *p++ = acc;
-        if ( p1 )
-            *p1++ = acc;
+        *p++ = qToBigEndian( acc );
         n -= 32 - nacc;
         while ( n >= 32 )
         {
             n -= 32;
             *p++ = pix;
-            if ( p1 )
-                *p1++ = pix;
         }
         acc = pix;
         nacc = n;
         pix = ~pix;
     }
     if ( nacc )
-    {
-        *p++ = acc;
-        if ( p1 )
-            *p1++ = acc;
-    }
+        *p++ = qToBigEndian( acc );
+
+    /* the vertical stretch */
+    for ( int row = firstRow + 1; row < endRow; ++row )
+        memcpy( pn->imageData + row * pn->bytes_per_line, line, pn->bytes_per_line );
 }
 
 static bool get_image( pagenode *pn )
 {
-    unsigned char *data = getstrip( pn, 0 );
-    if ( !data )
-        return false;
-
-    if ( !new_image( pn, pn->size.width(), (pn->vres ? 1 : 2) * pn->size.height() ) )
+    if ( !new_image( pn, pn->size.width(), pn->size.height() * stretch( pn ) / 2 ) )
         return false;
 
     (*pn->expander)( pn, draw_line );
 
+    /* the compressed data is not needed any more */
+    delete [] pn->dataOrig;
+    pn->dataOrig = nullptr;
+    pn->data = nullptr;
+
     return true;
 }
 
@@ -224,7 +241,7 @@ class FaxDocument::Private
 {
     public:
         Private( FaxDocument *parent )
-            : mParent( parent )
+            : mParent( parent ), mDecoded( false )
         {
             mPageNode.size = QSize( 1728, 0 );
         }
@@ -232,6 +249,8 @@ class FaxDocument::Private
         FaxDocument *mParent;
         pagenode mPageNode;
         FaxDocument::DocumentType mType;
+        QMutex mMutex;
+        bool mDecoded;
 };
 
 FaxDocument::FaxDocument( const QString &fileName, DocumentType type )
@@ -257,7 +276,6 @@ FaxDocument::FaxDocument( const QString &fileName, DocumentType type )
 FaxDocument::~FaxDocument()
 {
     delete [] d->mPageNode.dataOrig;
-    delete [] d->mPageNode.imageData;
     delete d;
 }
 
@@ -265,46 +283,25 @@ bool FaxDocument::load()
 {
     fax_init_tables();
 
-    bool ok = get_image( &(d->mPageNode) );
-    if ( !ok )
-        return false;
-
-    // byte-swapping the image
-    int height = d->mPageNode.size.height();
-    int bytes_per_line = d->mPageNode.size.width()/8;
-
-    QByteArray bytes( height * bytes_per_line, 0 );
-    for ( int y= height - 1; y >= 0; --y )
-    {
-        quint32 offset  = y * bytes_per_line;
-        quint32 *source = (quint32 *) (d->mPageNode.imageData + offset);
-        quint32 *dest   = (quint32 *) (bytes.data() + offset);
-        for ( int x= (bytes_per_line/4) - 1; x >= 0; --x )
-        {
-            quint32 dv = 0, sv = *source;
-            for ( int bit = 32; bit > 0; --bit )
-            {
-                dv <<= 1;
-                dv |= sv&1;
-                sv >>= 1;
-            }
-            *dest = dv;
-            ++dest;
-            ++source;
-        }
-    }
-
-    // convert it into a QImage
-    QImage img( (uchar*)bytes.data(), d->mPageNode.size.width(), d->mPageNode.size.height(), QImage::Format_MonoLSB );
-    img.setColor( 0, qRgb( 255, 255, 255 ) );
-    img.setColor( 1, qRgb( 0, 0, 0 ) );
-
-    d->mPageNode.image = img.copy().scaled( img.width(), img.height() * 1.5 );
+    // only read the data and count the lines, the page is decoded when first needed
+    return getstrip( &(d->mPageNode), 0 ) != nullptr;
+}
 
-    return true;
+QSize FaxDocument::size() const
+{
+    const pagenode *pn = &(d->mPageNode);
+    return QSize( pn->size.width(), pn->size.height() * stretch( pn ) / 2 );
 }
 
 QImage FaxDocument::image() const
 {
+    QMutexLocker locker( &d->mMutex );
+    if ( !d->mDecoded )
+    {
+        d->mDecoded = true;
+        if ( d->mPageNode.dataOrig )
+            get_image( &(d->mPageNode) );
+    }
+
     return d->mPageNode.image;
 }
@@ -52,7 +52,12 @@ class FaxDocument
     bool load();
 
     /**
-     * Returns the document as an image.
+     * Returns the size of the document image, available once loaded.
+     */
+    QSize size() const;
+
+    /**
+     * Returns the document as a 1-bit image, it is decoded on the first call.
      */
     QImage image() const;
 
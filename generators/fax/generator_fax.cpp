@@ -11,6 +11,7 @@
 
 #include <QPainter>
 #include <QPrinter>
+#include <QVector>
 
 #include <KAboutData>
 #include <KLocalizedString>
@@ -21,15 +22,67 @@
 OKULAR_EXPORT_PLUGIN(FaxGenerator, "libokularGenerator_fax.json")
 
 FaxGenerator::FaxGenerator( QObject *parent, const QVariantList &args )
-    : Generator( parent, args )
+    : Generator( parent, args ), m_document( nullptr )
 {
     setFeature( Threaded );
+    setFeature( TiledRendering );
     setFeature( PrintNative );
     setFeature( PrintToFile );
 }
 
 FaxGenerator::~FaxGenerator()
 {
+    delete m_document;
+}
+
+/**
+ * Scales the @p source part of the 1-bit @p image to @p size without converting
+ * it to 32 bits first. Every pixel gets the gray level of the share of black
+ * pixels in the area of @p source it covers.
+ */
+static QImage scaledMonoImage( const QImage &image, const QRect &source, const QSize &size )
+{
+    QImage result( size, QImage::Format_RGB32 );
+    if ( result.isNull() || source.isEmpty() )
+        return result;
+
+    // the first column of the source covered by every column of the result
+    QVector<int> columns( size.width() + 1 );
+    for ( int x = 0; x <= size.width(); ++x )
+        columns[ x ] = source.left() + (qint64)x * source.width() / size.width();
+
+    QVector<int> blackPixels( size.width() );
+    for ( int y = 0; y < size.height(); ++y )
+    {
+        const int top = source.top() + (qint64)y * source.height() / size.height();
+        // when enlarging a pixel covers less than a source row, take the row it lies in
+        const int bottom = qMax( top + 1, source.top() + (int)( (qint64)( y + 1 ) * source.height() / size.height() ) );
+
+        blackPixels.fill( 0 );
+        for ( int sy = top; sy < bottom; ++sy )
+        {
+            const uchar *line = image.constScanLine( sy );
+            for ( int x = 0; x < size.width(); ++x )
+            {
+                const int right = qMax( columns[ x ] + 1, columns[ x + 1 ] );
+                for ( int sx = columns[ x ]; sx < right; ++sx )
+                {
+                    if ( line[ sx >> 3 ] & ( 0x80 >> ( sx & 7 ) ) )
+                        ++blackPixels[ x ];
+                }
+            }
+        }
+
+        QRgb *dest = reinterpret_cast<QRgb *>( result.scanLine( y ) );
+        for ( int x = 0; x < size.width(); ++x )
+        {
+            const int area = ( bottom - top ) * qMax( 1, columns[ x + 1 ] - columns[ x ] );
+            const int gray = 255 - blackPixels[ x ] * 255 / area;
+            dest[ x ] = qRgb( gray, gray, gray );
+        }
+    }
+
+    return result;
 }
 
 bool FaxGenerator::loadDocument( const QString & fileName, QVector<Okular::Page*> & pagesVector )
@@ -39,19 +92,21 @@ bool FaxGenerator::loadDocument( const QString & fileName, QVector<Okular::Page*
     else
         m_type = FaxDocument::G4;
 
-    FaxDocument faxDocument( fileName, m_type );
+    m_document = new FaxDocument( fileName, m_type );
 
-    if ( !faxDocument.load() )
+    // the page itself is only decoded once it is first rendered
+    if ( !m_document->load() )
     {
+        delete m_document;
+        m_document = nullptr;
         emit error( i18n( "Unable to load document" ), -1 );
         return false;
     }
 
-    m_img = faxDocument.image();
-
     pagesVector.resize( 1 );
 
-    Okular::Page * page = new Okular::Page( 0, m_img.width(), m_img.height(), Okular::Rotation0 );
+    const QSize size = m_document->size();
+    Okular::Page * page = new Okular::Page( 0, size.width(), size.height(), Okular::Rotation0 );
     pagesVector[0] = page;
 
     return true;
@@ -59,20 +114,34 @@ bool FaxGenerator::loadDocument( const QString & fileName, QVector<Okular::Page*
 
 bool FaxGenerator::doCloseDocument()
 {
-    m_img = QImage();
+    delete m_document;
+    m_document = nullptr;
 
     return true;
 }
 
 QImage FaxGenerator::image( Okular::PixmapRequest * request )
 {
-    // perform a smooth scaled generation
-    int width = request->width();
-    int height = request->height();
-    if ( request->page()->rotation() % 2 == 1 )
-        qSwap( width, height );
+    const QImage img = m_document->image();
+    if ( img.isNull() )
+        return QImage();
+
+    if ( request->isTile() )
+    {
+        const QRect srcRect = request->normalizedRect().geometry( img.width(), img.height() ).intersected( img.rect() );
+        const QRect destRect = request->normalizedRect().geometry( request->width(), request->height() );
+
+        return scaledMonoImage( img, srcRect, destRect.size() );
+    }
+    else
+    {
+        int width = request->width();
+        int height = request->height();
+        if ( request->page()->rotation() % 2 == 1 )
+            qSwap( width, height );
 
-    return m_img.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+        return scaledMonoImage( img, img.rect(), QSize( width, height ) );
+    }
 }
 
 Okular::DocumentInfo FaxGenerator::generateDocumentInfo( const QSet<Okular::DocumentInfo::Key> &keys ) const
@@ -92,7 +161,7 @@ bool FaxGenerator::print( QPrinter& printer )
 {
     QPainter p( &printer );
 
-    QImage image( m_img );
+    QImage image( m_document->image() );
 
     if ( ( image.width() > printer.width() ) || ( image.height() > printer.height() ) )
 
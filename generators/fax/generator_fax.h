@@ -36,7 +36,7 @@ class FaxGenerator : public Okular::Generator
         QImage image( Okular::PixmapRequest * request ) override;
 
     private:
-        QImage m_img;
+        FaxDocument *m_document;
         FaxDocument::DocumentType m_type;
 };
 
@@ -31,6 +31,7 @@
 #include <kexiv2/kexiv2.h>
 
 #include <core/page.h>
+#include <core/rasterprinter.h>
 
 OKULAR_EXPORT_PLUGIN(KIMGIOGenerator, "libokularGenerator_kimgio.json")
 
@@ -142,18 +143,20 @@ QImage KIMGIOGenerator::image( Okular::PixmapRequest * request )
 
 bool KIMGIOGenerator::print( QPrinter& printer )
 {
-    QPainter p( &printer );
+    const QSize printerSize( printer.width(), printer.height() );
 
-    QImage image( m_img );
+    Okular::RasterPrinter rasterPrinter( [this, printerSize]( int, QRectF * )
+    {
+        QImage image( m_img );
 
-    if ( ( image.width() > printer.width() ) || ( image.height() > printer.height() ) )
+        if ( ( image.width() > printerSize.width() ) || ( image.height() > printerSize.height() ) )
 
-        image = image.scaled( printer.width(), printer.height(),
-                              Qt::KeepAspectRatio, Qt::SmoothTransformation );
+            image = image.scaled( printerSize, Qt::KeepAspectRatio, Qt::SmoothTransformation );
 
-    p.drawImage( 0, 0, image );
+        return image;
+    } );
 
-    return true;
+    return rasterPrinter.print( printer, QList<int>() << 1 );
 }
 
 Okular::DocumentInfo KIMGIOGenerator::generateDocumentInfo( const QSet<Okular::DocumentInfo::Key> &keys ) const
@@ -0,0 +1,135 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <QTemporaryDir>
+
+#include "core/document.h"
+#include "core/page.h"
+#include "settings_core.h"
+
+class MarkdownGeneratorTest
+: public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void init();
+        void cleanup();
+        void testReloadSamePageCount();
+        void testReloadMorePages();
+        void testReloadFewerPages();
+        void cleanupTestCase();
+
+    private:
+        void writeFile( const QString &firstLine, int paragraphs );
+        QString pageText( int page );
+
+        Okular::Document *m_document;
+        QTemporaryDir m_dir;
+        QString m_fileName;
+};
+
+void MarkdownGeneratorTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled( true );
+    Okular::SettingsCore::instance( QStringLiteral("MarkdownGeneratorTest") );
+    m_document = new Okular::Document( nullptr );
+    QVERIFY( m_dir.isValid() );
+    m_fileName = m_dir.filePath( QStringLiteral("test.md") );
+}
+
+void MarkdownGeneratorTest::cleanupTestCase()
+{
+    delete m_document;
+}
+
+void MarkdownGeneratorTest::init()
+{
+    writeFile( QStringLiteral("First version"), 200 );
+
+    QMimeDatabase db;
+    const QMimeType mime = db.mimeTypeForFile( m_fileName );
+    QCOMPARE( m_document->openDocument( m_fileName, QUrl::fromLocalFile( m_fileName ), mime ), Okular::Document::OpenSuccess );
+    QVERIFY( m_document->pages() > 1 );
+}
+
+void MarkdownGeneratorTest::cleanup()
+{
+    m_document->closeDocument();
+}
+
+void MarkdownGeneratorTest::writeFile( const QString &firstLine, int paragraphs )
+{
+    QFile file( m_fileName );
+    QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+
+    QTextStream out( &file );
+    out << firstLine << "\n\n";
+    for ( int i = 0; i < paragraphs; ++i )
+        out << "Paragraph " << i << " with a [link](https://okular.kde.org/).\n\n";
+}
+
+QString MarkdownGeneratorTest::pageText( int page )
+{
+    m_document->requestTextPage( page );
+    return m_document->page( page )->text();
+}
+
+void MarkdownGeneratorTest::testReloadSamePageCount()
+{
+    const uint pageCount = m_document->pages();
+    const Okular::Page *firstPage = m_document->page( 0 );
+    const Okular::Page *lastPage = m_document->page( pageCount - 1 );
+    QVERIFY( pageText( 0 ).contains( QLatin1String("First version") ) );
+
+    writeFile( QStringLiteral("Second version"), 200 );
+    QVERIFY( m_document->reloadDocumentInPlace() );
+
+    QCOMPARE( m_document->pages(), pageCount );
+    QCOMPARE( m_document->page( 0 ), firstPage );
+    QCOMPARE( m_document->page( pageCount - 1 ), lastPage );
+    QVERIFY( pageText( 0 ).contains( QLatin1String("Second version") ) );
+}
+
+void MarkdownGeneratorTest::testReloadMorePages()
+{
+    const uint pageCount = m_document->pages();
+    const Okular::Page *firstPage = m_document->page( 0 );
+
+    writeFile( QStringLiteral("Longer version"), 600 );
+    QVERIFY( m_document->reloadDocumentInPlace() );
+
+    QVERIFY( m_document->pages() > pageCount );
+    QCOMPARE( m_document->page( 0 ), firstPage );
+    for ( uint i = 0; i < m_document->pages(); ++i )
+        QCOMPARE( m_document->page( i )->number(), int( i ) );
+    QVERIFY( pageText( 0 ).contains( QLatin1String("Longer version") ) );
+    QVERIFY( pageText( m_document->pages() - 1 ).contains( QLatin1String("Paragraph 599") ) );
+}
+
+void MarkdownGeneratorTest::testReloadFewerPages()
+{
+    const Okular::Page *firstPage = m_document->page( 0 );
+    m_document->setViewport( Okular::DocumentViewport( m_document->pages() - 1 ) );
+
+    writeFile( QStringLiteral("Shorter version"), 1 );
+    QVERIFY( m_document->reloadDocumentInPlace() );
+
+    QCOMPARE( m_document->pages(), 1u );
+    QCOMPARE( m_document->page( 0 ), firstPage );
+    QCOMPARE( m_document->currentPage(), 0u );
+    QVERIFY( pageText( 0 ).contains( QLatin1String("Shorter version") ) );
+    QVERIFY( pageText( 0 ).contains( QLatin1String("Paragraph 0") ) );
+}
+
+QTEST_MAIN( MarkdownGeneratorTest )
+#include "markdowngeneratortest.moc"
@@ -13,7 +13,11 @@
 
 #include <KLocalizedString>
 
+#include <QAbstractTextDocumentLayout>
+#include <QDataStream>
 #include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
 #include <QTextDocument>
 #include <QTextStream>
 #include <QTextFrame>
@@ -67,13 +71,88 @@ QTextDocument* Converter::convert( const QString &fileName )
     m_fileDir = QDir( fileName.left( fileName.lastIndexOf( '/' ) ) );
 
     QTextDocument *doc = convertOpenFile();
+    if ( !doc )
+        return nullptr;
+
     extractLinks( doc->rootFrame() );
+    m_pageSignatures = pageSignatures( doc );
     return doc;
 }
 
-void Converter::convertAgain()
+QVector<int> Converter::convertAgain()
+{
+    QTextDocument *doc = convertOpenFile();
+    if ( !doc )
+        return QVector<int>();
+
+    extractLinks( doc->rootFrame() );
+    const QVector<uint> signatures = pageSignatures( doc );
+
+    QVector<int> changedPages;
+    const int pageCount = qMax( signatures.count(), m_pageSignatures.count() );
+    for ( int i = 0; i < pageCount; ++i ) {
+        if ( i >= signatures.count() || i >= m_pageSignatures.count() || signatures[i] != m_pageSignatures[i] )
+            changedPages.append( i );
+    }
+
+    m_pageSignatures = signatures;
+    setDocument( doc );
+
+    return changedPages;
+}
+
+bool Converter::reopenFile( const QString &fileName )
 {
-    setDocument( convertOpenFile() );
+    FILE *markdownFile = fopen( fileName.toLocal8Bit(), "rb" );
+    if ( !markdownFile )
+        return false;
+
+    if ( m_markdownFile )
+        fclose( m_markdownFile );
+    m_markdownFile = markdownFile;
+    m_fileDir = QDir( fileName.left( fileName.lastIndexOf( '/' ) ) );
+
+    return true;
+}
+
+/**
+ * Computes a signature of what ends up on every page: the top level
+ * blocks crossing the page, their position on it, their text and their
+ * formats. Pages with the same signature render the same.
+ */
+QVector<uint> Converter::pageSignatures( QTextDocument *textDocument )
+{
+    const qreal pageHeight = textDocument->pageSize().height();
+    QAbstractTextDocumentLayout *layout = textDocument->documentLayout();
+
+    QVector<QByteArray> pageData( textDocument->pageCount() );
+    for ( QTextBlock block = textDocument->begin(); block.isValid(); block = block.next() ) {
+        const QRectF rect = layout->blockBoundingRect( block );
+
+        QByteArray blockData;
+        QDataStream stream( &blockData, QIODevice::WriteOnly );
+        stream << rect.size() << block.text() << block.blockFormat();
+        for ( QTextBlock::iterator it = block.begin(); !it.atEnd(); ++it ) {
+            const QTextFragment fragment = it.fragment();
+            if ( fragment.isValid() )
+                stream << fragment.length() << fragment.charFormat();
+        }
+
+        const int firstPage = qMax( 0, int( rect.top() / pageHeight ) );
+        const int lastPage = qMin( pageData.count() - 1, int( rect.bottom() / pageHeight ) );
+        for ( int page = firstPage; page <= lastPage; ++page ) {
+            QDataStream pageStream( &pageData[ page ], QIODevice::WriteOnly | QIODevice::Append );
+            pageStream << rect.topLeft() - QPointF( 0, page * pageHeight );
+            pageStream.writeRawData( blockData.constData(), blockData.size() );
+        }
+    }
+
+    QVector<uint> signatures;
+    signatures.reserve( pageData.count() );
+    for ( const QByteArray &data : qAsConst( pageData ) )
+        signatures.append( qHash( data ) );
+
+    return signatures;
 }
 
 QTextDocument *Converter::convertOpenFile()
@@ -169,14 +248,14 @@ void Converter::convertImages(const QTextBlock & parent, const QDir &dir, QTextD
                 QTextImageFormat format;
                 
                 format.setName( QDir::cleanPath( dir.absoluteFilePath( textCharFormat.toImageFormat().name() ) ) );
-                const QImage img = QImage( format.name() );
+                const QSize size = imageSize( format.name() );
                 
-                if ( img.width() > 890 ) {
+                if ( size.width() > 890 ) {
                     format.setWidth( 890 );
-                    format.setHeight( img.height() * 890. / img.width() );
+                    format.setHeight( size.height() * 890. / size.width() );
                 } else {
-                    format.setWidth( img.width() );
-                    format.setHeight( img.height() );
+                    format.setWidth( size.width() );
+                    format.setHeight( size.height() );
                 }
                 
                 QTextCursor cursor( textDocument );
@@ -189,3 +268,23 @@ void Converter::convertImages(const QTextBlock & parent, const QDir &dir, QTextD
         }
     }
 }
+
+QSize Converter::imageSize(const QString &fileName)
+{
+    // converting again happens for every change of the file, only
+    // look at the images that changed since the last time
+    const QDateTime lastModified = QFileInfo( fileName ).lastModified();
+
+    QHash<QString, ImageInfo>::const_iterator it = m_images.constFind( fileName );
+    if ( it != m_images.constEnd() && it->lastModified == lastModified )
+        return it->size;
+
+    QImageReader reader( fileName );
+    QSize size = reader.size();
+    if ( !size.isValid() )
+        size = reader.read().size();
+
+    m_images.insert( fileName, ImageInfo{ lastModified, size } );
+
+    return size;
+}
@@ -12,7 +12,11 @@
 
 #include <core/textdocumentgenerator.h>
 
+#include <QDateTime>
 #include <QDir>
+#include <QHash>
+#include <QSize>
+#include <QVector>
 
 class QTextBlock;
 class QTextFrame;
@@ -29,7 +33,17 @@ class Converter : public Okular::TextDocumentConverter
 
         QTextDocument *convert( const QString &fileName ) override;
 
-        void convertAgain();
+        /**
+         * Converts the open file again and returns the pages whose
+         * content differs from the previous conversion.
+         */
+        QVector<int> convertAgain();
+
+        /**
+         * Opens @p fileName again, which may have been replaced on disk,
+         * for the next convertAgain().
+         */
+        bool reopenFile( const QString &fileName );
 
         QTextDocument *convertOpenFile();
 
@@ -38,9 +52,20 @@ class Converter : public Okular::TextDocumentConverter
         void extractLinks(const QTextBlock& parent);
         void convertImages(QTextFrame *parent, const QDir &dir, QTextDocument *textDocument);
         void convertImages(const QTextBlock& parent, const QDir &dir, QTextDocument *textDocument);
+        QSize imageSize(const QString &fileName);
+
+        static QVector<uint> pageSignatures(QTextDocument *textDocument);
+
+        struct ImageInfo
+        {
+            QDateTime lastModified;
+            QSize size;
+        };
 
         FILE *m_markdownFile;
         QDir m_fileDir;
+        QHash<QString, ImageInfo> m_images;
+        QVector<uint> m_pageSignatures;
 };
 
 }
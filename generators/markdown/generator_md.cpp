@@ -40,16 +40,32 @@ bool MarkdownGenerator::reparseConfig()
     if (s_wasFancyPantsEnabled != s_isFancyPantsEnabled) {
         s_wasFancyPantsEnabled = s_isFancyPantsEnabled;
 
+        // only the pages whose content changed are rendered again, so
+        // the others keep their pixmaps and the view does not flicker
         Markdown::Converter *c = static_cast<Markdown::Converter*>( converter() );
-        c->convertAgain();
-        setTextDocument( c->document() );
-
-        return true;
+        const QVector<int> changedPages = c->convertAgain();
+        if ( c->document() )
+            setTextDocument( c->document(), changedPages );
     }
 
     return textDocumentGeneratorChangedConfig;
 }
 
+bool MarkdownGenerator::reloadDocument( const QString &fileName )
+{
+    Markdown::Converter *c = static_cast<Markdown::Converter*>( converter() );
+    if ( !c->reopenFile( fileName ) )
+        return false;
+
+    QTextDocument *oldDocument = c->document();
+    const QVector<int> changedPages = c->convertAgain();
+    if ( c->document() == oldDocument )
+        return false;
+
+    setTextDocument( c->document(), changedPages );
+    return true;
+}
+
 void MarkdownGenerator::addPages( KConfigDialog* dlg )
 {
     Okular::TextDocumentSettingsWidget *widget = new Okular::TextDocumentSettingsWidget();
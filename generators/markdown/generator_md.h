@@ -11,11 +11,13 @@
 #define _OKULAR_GENERATOR_MD_H_
 
 #include <core/textdocumentgenerator.h>
+#include <interfaces/reloadinterface.h>
 
-class MarkdownGenerator : public Okular::TextDocumentGenerator
+class MarkdownGenerator : public Okular::TextDocumentGenerator, public Okular::ReloadInterface
 {
     Q_OBJECT
     Q_INTERFACES( Okular::Generator )
+    Q_INTERFACES( Okular::ReloadInterface )
 
     public:
         MarkdownGenerator( QObject *parent, const QVariantList &args );
@@ -26,6 +28,9 @@ class MarkdownGenerator : public Okular::TextDocumentGenerator
 
         static bool isFancyPantsEnabled() { return s_isFancyPantsEnabled; }
 
+        // [INHERITED] reload the changed file in place
+        bool reloadDocument( const QString &fileName ) override;
+
     private:
         static bool s_isFancyPantsEnabled;
         static bool s_wasFancyPantsEnabled;
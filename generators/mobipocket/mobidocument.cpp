@@ -11,15 +11,19 @@
 #include <qmobipocket/qfilestream.h>
 #include <QColor>
 #include <QFile>
-#include <QRegExp>
+#include <QMap>
 #include <QDebug>
 #include <QApplication> // Because of the HACK
 #include <QPalette> // Because of the HACK
 
 using namespace Mobi;
 
+// how much memory the decoded images may take, in kilobytes
+static const int ImageCacheSize = 32 * 1024;
+
 MobiDocument::MobiDocument(const QString &fileName) : QTextDocument() 
 {
+  images.setMaxCost(ImageCacheSize);
   file = new Mobipocket::QFileStream(fileName);
   doc = new Mobipocket::Document(file);
   if (doc->isValid()) {
@@ -58,10 +62,17 @@ QVariant MobiDocument::loadResource(int type, const QUrl &name)
   quint16 recnum=name.path().midRef(1).toUShort(&ok);
   if (!ok || recnum>=doc->imageCount()) return QVariant();
    
+  // not added as a resource of the document, which would keep every image
+  // of the book forever, but kept in a bounded cache instead
   QVariant resource;
-  resource.setValue(doc->getImage(recnum-1));
-  addResource(type, name, resource); 
-    
+  if (const QImage *cached = images.object(recnum)) {
+    resource.setValue(*cached);
+    return resource;
+  }
+
+  const QImage image = doc->getImage(recnum-1);
+  images.insert(recnum, new QImage(image), qMax(1, image.bytesPerLine() * image.height() / 1024));
+  resource.setValue(image);
   return resource;
 }
 
@@ -75,42 +86,122 @@ int outsideTag(const QString& data, int pos)
   return pos;
 }
 
-QString MobiDocument::fixMobiMarkup(const QString& data) 
+// matches the start of a link to a file position at 'pos', that is
+// <a(?: href="[^"]*"){0,1}[\s]+filepos=['"]{0,1}([\d]+)["']{0,1}
+// returns the end of the match and the digits in 'filepos', or -1
+static int matchFileposLink(const QString& data, int pos, QString *filepos)
 {
-    QString ret=data;
-    QMap<int,QString> anchorPositions;
-    static QRegExp anchors(QStringLiteral("<a(?: href=\"[^\"]*\"){0,1}[\\s]+filepos=['\"]{0,1}([\\d]+)[\"']{0,1}"), Qt::CaseInsensitive);
-    int pos=0;
+  const int size=data.size();
+  if (data.midRef(pos,2).compare(QLatin1String("<a"),Qt::CaseInsensitive)!=0) return -1;
+  int i=pos+2;
+  if (data.midRef(i,7).compare(QLatin1String(" href=\""),Qt::CaseInsensitive)==0) {
+    const int quote=data.indexOf(QLatin1Char('"'),i+7);
+    if (quote==-1) return -1;
+    i=quote+1;
+  }
+  const int spaces=i;
+  while (i<size && data[i].isSpace()) i++;
+  if (i==spaces) return -1;
+  if (data.midRef(i,8).compare(QLatin1String("filepos="),Qt::CaseInsensitive)!=0) return -1;
+  i+=8;
+  if (i<size && (data[i]==QLatin1Char('\'') || data[i]==QLatin1Char('"'))) i++;
+  const int digits=i;
+  while (i<size && data[i].isDigit()) i++;
+  if (i==digits) return -1;
+  *filepos=data.mid(digits,i-digits);
+  if (i<size && (data[i]==QLatin1Char('\'') || data[i]==QLatin1Char('"'))) i++;
+  return i;
+}
 
+// matches a Mobipocket image tag at 'pos', <img ... recindex="3232" ...> where recindex is
+// the number of the record containing the image; returns the end of the tag and the number
+// in 'recindex', or -1
+static int matchImage(const QString& data, int pos, QString *recindex)
+{
+  if (data.midRef(pos,4).compare(QLatin1String("<img"),Qt::CaseInsensitive)!=0) return -1;
+  const int tagEnd=data.indexOf(QLatin1Char('>'),pos);
+  if (tagEnd==-1) return -1;
+  const int attribute=data.indexOf(QLatin1String("recindex=\""),pos,Qt::CaseInsensitive);
+  if (attribute==-1 || attribute>tagEnd) return -1;
+  const int digits=attribute+10;
+  int i=digits;
+  while (i<tagEnd && data[i].isDigit()) i++;
+  if (data[i]!=QLatin1Char('"')) return -1;
+  *recindex=data.mid(digits,i-digits);
+  return tagEnd+1;
+}
+
+QString MobiDocument::fixMobiMarkup(const QString& data) 
+{
     // find all link destinations
-    while ( (pos=anchors.indexIn( data, pos ))!=-1) {
-	int filepos=anchors.cap( 1 ).toUInt(  );
-	if (filepos) anchorPositions[filepos]=anchors.cap(1);
-	pos+=anchors.matchedLength();
+    QMap<int,QString> anchorPositions;
+    int pos=data.indexOf(QLatin1Char('<'));
+    while (pos!=-1) {
+      QString filepos;
+      const int end=matchFileposLink(data,pos,&filepos);
+      if (end==-1) {
+        pos=data.indexOf(QLatin1Char('<'),pos+1);
+        continue;
+      }
+      const int value=filepos.toUInt();
+      if (value) anchorPositions[value]=filepos;
+      pos=data.indexOf(QLatin1Char('<'),end);
     }
 
-    // put HTML anchors in all link destinations
-    int offset=0;
+    // the HTML anchors to put in front of each position, links pointing outside the document are ignored
+    QMap<int,QString> anchors;
     QMapIterator<int,QString> it(anchorPositions);
     while (it.hasNext()) {
       it.next();
-      // link pointing outside the document, ignore
-      if ( (it.key()+offset) >= ret.size()) continue;
-      int fixedpos=outsideTag(ret, it.key()+offset);
-      ret.insert(fixedpos,QStringLiteral("<a name=\"")+it.value()+QStringLiteral("\">&nbsp;</a>"));
-      // inserting anchor shifts all offsets after the anchor
-      offset+=21+it.value().size();
+      if (it.key()>=data.size()) continue;
+      anchors[outsideTag(data,it.key())]+=QStringLiteral("<a name=\"")+it.value()+QStringLiteral("\">&nbsp;</a>");
+    }
+
+    // copy the text in one sweep, adding the anchors and rewriting the tags on the way:
+    // links referencing filepos become normal internal links, Mobipocket images
+    // get their record as source and page breaks become paragraphs breaking the page
+    QString ret;
+    ret.reserve(data.size()+data.size()/16);
+    QMap<int,QString>::const_iterator nextAnchor=anchors.constBegin();
+    const int size=data.size();
+    pos=0;
+    while (pos<size) {
+      int next=data.indexOf(QLatin1Char('<'),pos);
+      if (next==-1) next=size;
+      if (nextAnchor!=anchors.constEnd() && nextAnchor.key()<=next) {
+        // a rewritten tag may have skipped the position already
+        const int anchorPos=qMax(pos,nextAnchor.key());
+        ret.append(data.midRef(pos,anchorPos-pos));
+        ret.append(nextAnchor.value());
+        pos=anchorPos;
+        ++nextAnchor;
+        continue;
+      }
+      ret.append(data.midRef(pos,next-pos));
+      pos=next;
+      if (pos==size) break;
+
+      QString number;
+      int end=matchFileposLink(data,pos,&number);
+      if (end!=-1) {
+        ret+=QStringLiteral("<a href=\"#")+number+QLatin1Char('"');
+        pos=end;
+        continue;
+      }
+      end=matchImage(data,pos,&number);
+      if (end!=-1) {
+        ret+=QStringLiteral("<img src=\"pdbrec:/")+number+QStringLiteral("\">");
+        pos=end;
+        continue;
+      }
+      if (data.midRef(pos,16)==QLatin1String("<mbp:pagebreak/>")) {
+        ret+=QStringLiteral("<p style=\"page-break-after:always\"></p>");
+        pos+=16;
+        continue;
+      }
+      ret+=QLatin1Char('<');
+      pos++;
     }
 
-    // replace links referencing filepos with normal internal links
-    ret.replace(anchors, QStringLiteral("<a href=\"#\\1\""));
-    // Mobipocket uses strange variang of IMG tags: <img recindex="3232"> where recindex is number of 
-    // record containing image
-    static QRegExp imgs(QStringLiteral("<img.*recindex=\"([\\d]*)\".*>"), Qt::CaseInsensitive);
-    
-    imgs.setMinimal(true);
-    ret.replace(imgs, QStringLiteral("<img src=\"pdbrec:/\\1\">"));
-    ret.replace(QStringLiteral("<mbp:pagebreak/>"), QStringLiteral("<p style=\"page-break-after:always\"></p>"));
-    
     return ret;
 }
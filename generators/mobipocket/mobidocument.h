@@ -9,6 +9,8 @@
 #ifndef MOBI_DOCUMENT_H
 #define MOBI_DOCUMENT_H
 
+#include <QCache>
+#include <QImage>
 #include <QTextDocument>
 #include <QUrl>
 #include <QVariant>
@@ -36,6 +38,8 @@ namespace Mobi {
     QString fixMobiMarkup(const QString& data);
     Mobipocket::Document *doc;
     Mobipocket::QFileStream* file;
+    // decoded images by record, the cost is in kilobytes
+    QCache<quint16, QImage> images;
   };
 
 }
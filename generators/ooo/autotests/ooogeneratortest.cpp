@@ -0,0 +1,163 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include <QtTest>
+
+#include <KZip>
+
+#include "core/document.h"
+#include "core/page.h"
+#include "settings_core.h"
+#include "core/textpage.h"
+
+
+class OooGeneratorTest
+: public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void testDocumentStructure();
+        void testDocumentContent();
+        void benchmarkOpen();
+        void cleanupTestCase();
+
+    private:
+        static bool writeDocument( const QString &fileName, int sections );
+
+        QTemporaryDir m_tempDir;
+        QString m_testFile;
+        QMimeType m_mime;
+        Okular::Document *m_document;
+};
+
+// Writes a text document made of @p sections sections, each one with a
+// heading, styled paragraphs, a list and a table.
+bool OooGeneratorTest::writeDocument( const QString &fileName, int sections )
+{
+    QByteArray content;
+    content += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+               "<office:document-content"
+               " xmlns:office=\"urn:oasis:names:tc:opendocument:xmlns:office:1.0\""
+               " xmlns:style=\"urn:oasis:names:tc:opendocument:xmlns:style:1.0\""
+               " xmlns:text=\"urn:oasis:names:tc:opendocument:xmlns:text:1.0\""
+               " xmlns:table=\"urn:oasis:names:tc:opendocument:xmlns:table:1.0\""
+               " xmlns:fo=\"urn:oasis:names:tc:opendocument:xmlns:xsl-fo-compatible:1.0\""
+               " office:version=\"1.2\">\n"
+               "<office:automatic-styles>\n"
+               "<style:style style:name=\"P1\" style:family=\"paragraph\">"
+               "<style:paragraph-properties fo:text-align=\"justify\"/>"
+               "<style:text-properties fo:font-size=\"11pt\"/></style:style>\n"
+               "<style:style style:name=\"T1\" style:family=\"text\">"
+               "<style:text-properties fo:font-weight=\"bold\"/></style:style>\n"
+               "</office:automatic-styles>\n"
+               "<office:body><office:text>\n";
+
+    for ( int i = 0; i < sections; ++i ) {
+        const QByteArray number = QByteArray::number( i );
+        content += "<text:h text:outline-level=\"1\">Section " + number + "</text:h>\n";
+        for ( int j = 0; j < 4; ++j ) {
+            content += "<text:p text:style-name=\"P1\">Paragraph " + number + " lorem ipsum dolor sit amet, "
+                       "<text:span text:style-name=\"T1\">consectetur</text:span> adipiscing elit,"
+                       "<text:s text:c=\"2\"/>sed do eiusmod tempor incididunt ut labore.</text:p>\n";
+        }
+        content += "<text:list><text:list-item><text:p>First item</text:p></text:list-item>"
+                   "<text:list-item><text:p>Second item</text:p></text:list-item></text:list>\n"
+                   "<table:table><table:table-column table:number-columns-repeated=\"2\"/>"
+                   "<table:table-row><table:table-cell><text:p>A" + number + "</text:p></table:table-cell>"
+                   "<table:table-cell><text:p>B" + number + "</text:p></table:table-cell></table:table-row>"
+                   "</table:table>\n";
+    }
+
+    content += "</office:text></office:body></office:document-content>\n";
+
+    const QByteArray manifest =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<manifest:manifest xmlns:manifest=\"urn:oasis:names:tc:opendocument:xmlns:manifest:1.0\">\n"
+        " <manifest:file-entry manifest:media-type=\"application/vnd.oasis.opendocument.text\" manifest:full-path=\"/\"/>\n"
+        " <manifest:file-entry manifest:media-type=\"text/xml\" manifest:full-path=\"content.xml\"/>\n"
+        "</manifest:manifest>\n";
+
+    KZip zip( fileName );
+    if ( !zip.open( QIODevice::WriteOnly ) )
+        return false;
+
+    zip.setCompression( KZip::NoCompression );
+    bool ok = zip.writeFile( QStringLiteral("mimetype"), QByteArrayLiteral("application/vnd.oasis.opendocument.text") );
+    zip.setCompression( KZip::DeflateCompression );
+    ok = ok && zip.writeFile( QStringLiteral("META-INF/manifest.xml"), manifest );
+    ok = ok && zip.writeFile( QStringLiteral("content.xml"), content );
+
+    return zip.close() && ok;
+}
+
+void OooGeneratorTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled( true );
+    Okular::SettingsCore::instance( QStringLiteral("OooGeneratorTest") );
+
+    QVERIFY( m_tempDir.isValid() );
+    m_testFile = m_tempDir.filePath( QStringLiteral("large.odt") );
+    QVERIFY( writeDocument( m_testFile, 500 ) );
+
+    QMimeDatabase db;
+    m_mime = db.mimeTypeForFile( m_testFile );
+
+    m_document = new Okular::Document( 0 );
+    QCOMPARE( m_document->openDocument(m_testFile, QUrl(), m_mime), Okular::Document::OpenSuccess );
+}
+
+void OooGeneratorTest::cleanupTestCase()
+{
+    m_document->closeDocument();
+    delete m_document;
+}
+
+void OooGeneratorTest::testDocumentStructure()
+{
+    QVERIFY( m_document->pages() > 1 );
+
+    const Okular::DocumentSynopsis *docSyn = m_document->documentSynopsis();
+    QVERIFY( docSyn );
+
+    QDomElement heading = docSyn->documentElement();
+    QCOMPARE( heading.tagName(), QStringLiteral("Section 0") );
+
+    int headings = 0;
+    for ( ; !heading.isNull(); heading = heading.nextSiblingElement() )
+        headings++;
+    QCOMPARE( headings, 500 );
+}
+
+void OooGeneratorTest::testDocumentContent()
+{
+    const Okular::Page *page0 = m_document->page(0);
+    m_document->requestTextPage( page0->number() );
+    QVERIFY( page0->hasTextPage() );
+
+    const QString text = page0->text();
+    QVERIFY( text.contains( QStringLiteral("Section 0") ) );
+    QVERIFY( text.contains( QStringLiteral("consectetur") ) );
+    QVERIFY( text.contains( QStringLiteral("First item") ) );
+    QVERIFY( text.contains( QStringLiteral("A0") ) );
+}
+
+void OooGeneratorTest::benchmarkOpen()
+{
+    Okular::Document document( 0 );
+
+    QBENCHMARK {
+        QCOMPARE( document.openDocument(m_testFile, QUrl(), m_mime), Okular::Document::OpenSuccess );
+        document.closeDocument();
+    }
+}
+
+QTEST_MAIN( OooGeneratorTest )
+#include "ooogeneratortest.moc"
+
+/* kate: replace-tabs on; tab-width 4; */
@@ -18,7 +18,7 @@
 #include <QTextTableCell>
 #include <QDomElement>
 #include <QDomText>
-#include <QXmlSimpleReader>
+#include <QXmlStreamReader>
 
 #include <core/action.h>
 #include <core/annotations.h>
@@ -72,6 +72,47 @@ Converter::~Converter()
 {
 }
 
+/**
+ * Reads the element the reader is positioned on, including all its
+ * children, into a DOM element appended to @p parent.
+ */
+static QDomElement readElement( QXmlStreamReader &reader, QDomDocument &document, QDomNode parent )
+{
+  QDomElement element;
+  QDomNode current = parent;
+  int depth = 0;
+
+  Q_FOREVER {
+    if ( reader.isStartElement() ) {
+      QDomElement child = document.createElementNS( reader.namespaceUri().toString(), reader.qualifiedName().toString() );
+      const QXmlStreamAttributes attributes = reader.attributes();
+      for ( const QXmlStreamAttribute &attribute : attributes )
+        child.setAttributeNS( attribute.namespaceUri().toString(), attribute.qualifiedName().toString(), attribute.value().toString() );
+
+      current.appendChild( child );
+      if ( depth == 0 )
+        element = child;
+
+      current = child;
+      depth++;
+    } else if ( reader.isEndElement() ) {
+      current = current.parentNode();
+      depth--;
+    } else if ( reader.isCharacters() ) {
+      current.appendChild( document.createTextNode( reader.text().toString() ) );
+    }
+
+    if ( depth == 0 )
+      break;
+
+    reader.readNext();
+    if ( reader.atEnd() )
+      break;
+  }
+
+  return element;
+}
+
 Okular::Document::OpenResult Converter::convertWithPassword( const QString &fileName, const QString &password )
 {
   Document oooDocument( fileName );
@@ -85,23 +126,35 @@ Okular::Document::OpenResult Converter::convertWithPassword( const QString &file
   mCursor = new QTextCursor( mTextDocument );
 
   /**
-   * Create the dom of the content
+   * The content is streamed: only the declarations in front of the
+   * body (fonts and automatic styles) are kept as dom, the body
+   * itself is converted block by block while it is read.
    */
-  QXmlSimpleReader reader;
-
-  QXmlInputSource source;
-  source.setData( oooDocument.content() );
+  QXmlStreamReader reader( oooDocument.content() );
 
-  QString errorMsg;
   QDomDocument document;
-  if ( !document.setContent( &source, &reader, &errorMsg ) ) {
+  if ( reader.readNextStartElement() ) {
+    QDomElement documentElement = document.createElementNS( reader.namespaceUri().toString(), reader.qualifiedName().toString() );
+    document.appendChild( documentElement );
+
+    while ( reader.readNextStartElement() ) {
+      if ( reader.name() == QLatin1String( "body" ) )
+        break;
+
+      readElement( reader, document, documentElement );
+    }
+  }
+
+  if ( reader.hasError() ) {
     if ( !oooDocument.anyFileEncrypted() )
-      emit error( i18n( "Invalid XML document: %1", errorMsg ), -1 );
+      emit error( i18n( "Invalid XML document: %1", reader.errorString() ), -1 );
     delete mCursor;
     return oooDocument.anyFileEncrypted() ? Okular::Document::OpenNeedsPassword : Okular::Document::OpenError;
   }
 
   mStyleInformation = new StyleInformation();
+  mBlockFormats.clear();
+  mTextFormats.clear();
 
   /**
    * Read the style properties, so the are available when
@@ -152,20 +205,17 @@ Okular::Document::OpenResult Converter::convertWithPassword( const QString &file
   /**
    * Parse the content of the document
    */
-  const QDomElement documentElement = document.documentElement();
-
-  QDomElement element = documentElement.firstChildElement();
-  while ( !element.isNull() ) {
-    if ( element.tagName() == QLatin1String( "body" ) ) {
-      if ( !convertBody( element ) ) {
-        if ( !oooDocument.anyFileEncrypted() )
+  if ( reader.isStartElement() && reader.name() == QLatin1String( "body" ) ) {
+    if ( !convertBody( reader ) ) {
+      if ( !oooDocument.anyFileEncrypted() ) {
+        if ( reader.hasError() )
+          emit error( i18n( "Invalid XML document: %1", reader.errorString() ), -1 );
+        else
           emit error( i18n( "Unable to convert document content" ), -1 );
-        delete mCursor;
-        return oooDocument.anyFileEncrypted() ? Okular::Document::OpenNeedsPassword : Okular::Document::OpenError;
       }
+      delete mCursor;
+      return oooDocument.anyFileEncrypted() ? Okular::Document::OpenNeedsPassword : Okular::Document::OpenError;
     }
-
-    element = element.nextSiblingElement();
   }
 
   MetaInformation::List metaInformation = mStyleInformation->metaInformation();
@@ -178,30 +228,43 @@ Okular::Document::OpenResult Converter::convertWithPassword( const QString &file
   delete mCursor;
   delete mStyleInformation;
   mStyleInformation = nullptr;
+  mBlockFormats.clear();
+  mTextFormats.clear();
 
   setDocument( mTextDocument );
   return Okular::Document::OpenSuccess;
 }
 
-bool Converter::convertBody( const QDomElement &element )
+bool Converter::convertBody( QXmlStreamReader &reader )
 {
-  QDomElement child = element.firstChildElement();
-  while ( !child.isNull() ) {
-    if ( child.tagName() == QLatin1String( "text" ) ) {
-      if ( !convertText( child ) )
+  while ( reader.readNextStartElement() ) {
+    if ( reader.name() == QLatin1String( "text" ) ) {
+      if ( !convertText( reader ) )
         return false;
+    } else {
+      reader.skipCurrentElement();
     }
-
-    child = child.nextSiblingElement();
   }
 
-  return true;
+  return !reader.hasError();
 }
 
-bool Converter::convertText( const QDomElement &element )
+bool Converter::convertText( QXmlStreamReader &reader )
 {
-  QDomElement child = element.firstChildElement();
-  while ( !child.isNull() ) {
+  while ( reader.readNextStartElement() ) {
+    const QStringRef name = reader.name();
+    if ( name != QLatin1String( "p" ) && name != QLatin1String( "h" ) &&
+         name != QLatin1String( "list" ) && name != QLatin1String( "table" ) ) {
+      reader.skipCurrentElement();
+      continue;
+    }
+
+    // only the block being converted is kept in memory
+    QDomDocument document;
+    const QDomElement child = readElement( reader, document, document );
+    if ( reader.hasError() )
+      return false;
+
     if ( child.tagName() == QLatin1String( "p" ) ) {
       mCursor->insertBlock();
       if ( !convertParagraph( mCursor, child ) )
@@ -217,22 +280,43 @@ bool Converter::convertText( const QDomElement &element )
       if ( !convertTable( child ) )
         return false;
     }
-
-    child = child.nextSiblingElement();
   }
 
-  return true;
+  return !reader.hasError();
+}
+
+QTextBlockFormat Converter::styleBlockFormat( const QString &styleName )
+{
+  QHash<QString, QTextBlockFormat>::const_iterator it = mBlockFormats.constFind( styleName );
+  if ( it != mBlockFormats.constEnd() )
+    return it.value();
+
+  QTextBlockFormat format;
+  mStyleInformation->styleProperty( styleName ).applyBlock( &format );
+  mBlockFormats.insert( styleName, format );
+
+  return format;
+}
+
+QTextCharFormat Converter::styleTextFormat( const QString &styleName )
+{
+  QHash<QString, QTextCharFormat>::const_iterator it = mTextFormats.constFind( styleName );
+  if ( it != mTextFormats.constEnd() )
+    return it.value();
+
+  QTextCharFormat format;
+  mStyleInformation->styleProperty( styleName ).applyText( &format );
+  mTextFormats.insert( styleName, format );
+
+  return format;
 }
 
 bool Converter::convertHeader( QTextCursor *cursor, const QDomElement &element )
 {
   const QString styleName = element.attribute( QStringLiteral("style-name") );
-  const StyleFormatProperty property = mStyleInformation->styleProperty( styleName );
 
-  QTextBlockFormat blockFormat;
-  QTextCharFormat textFormat;
-  property.applyBlock( &blockFormat );
-  property.applyText( &textFormat );
+  const QTextBlockFormat blockFormat = styleBlockFormat( styleName );
+  const QTextCharFormat textFormat = styleTextFormat( styleName );
 
   cursor->setBlockFormat( blockFormat );
 
@@ -261,12 +345,12 @@ bool Converter::convertHeader( QTextCursor *cursor, const QDomElement &element )
 bool Converter::convertParagraph( QTextCursor *cursor, const QDomElement &element, const QTextBlockFormat &parentFormat, bool merge )
 {
   const QString styleName = element.attribute( QStringLiteral("style-name") );
-  const StyleFormatProperty property = mStyleInformation->styleProperty( styleName );
 
+  // the paragraph properties are plain setters, so merging the resolved
+  // style gives the same result as applying it on top of the parent format
   QTextBlockFormat blockFormat( parentFormat );
-  QTextCharFormat textFormat;
-  property.applyBlock( &blockFormat );
-  property.applyText( &textFormat );
+  blockFormat.merge( styleBlockFormat( styleName ) );
+  const QTextCharFormat textFormat = styleTextFormat( styleName );
 
   if ( merge )
     cursor->mergeBlockFormat( blockFormat );
@@ -10,6 +10,8 @@
 #ifndef OOO_CONVERTER_H
 #define OOO_CONVERTER_H
 
+#include <QHash>
+#include <QTextBlockFormat>
 #include <QTextCharFormat>
 #include <QDomDocument>
 
@@ -19,6 +21,7 @@
 
 class QDomElement;
 class QDomText;
+class QXmlStreamReader;
 
 namespace OOO {
 
@@ -33,8 +36,8 @@ class Converter : public Okular::TextDocumentConverter
     Okular::Document::OpenResult convertWithPassword( const QString &fileName, const QString &password ) override;
 
   private:
-    bool convertBody( const QDomElement &element );
-    bool convertText( const QDomElement &element );
+    bool convertBody( QXmlStreamReader &reader );
+    bool convertText( QXmlStreamReader &reader );
     bool convertHeader( QTextCursor *cursor, const QDomElement &element );
     bool convertParagraph( QTextCursor *cursor, const QDomElement &element, const QTextBlockFormat &format = QTextBlockFormat(), bool merge = false );
     bool convertTextNode( QTextCursor *cursor, const QDomText &element, const QTextCharFormat &format );
@@ -45,10 +48,17 @@ class Converter : public Okular::TextDocumentConverter
     bool convertFrame( const QDomElement &element );
     bool convertAnnotation( QTextCursor *cursor, const QDomElement &element );
 
+    QTextBlockFormat styleBlockFormat( const QString &styleName );
+    QTextCharFormat styleTextFormat( const QString &styleName );
+
     QTextDocument *mTextDocument;
     QTextCursor *mCursor;
 
     StyleInformation *mStyleInformation;
+
+    // formats of the named styles, resolved once per conversion
+    QHash<QString, QTextBlockFormat> mBlockFormats;
+    QHash<QString, QTextCharFormat> mTextFormats;
 };
 
 }
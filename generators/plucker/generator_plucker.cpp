@@ -11,6 +11,7 @@
 
 #include <QFile>
 #include <QAbstractTextDocumentLayout>
+#include <QMutex>
 #include <QPainter>
 #include <QPrinter>
 #include <QTextDocument>
@@ -19,6 +20,7 @@
 #include <KLocalizedString>
 
 #include <core/page.h>
+#include <core/textexporter.h>
 
 OKULAR_EXPORT_PLUGIN(PluckerGenerator, "libokularGenerator_plucker.json")
 
@@ -68,6 +70,14 @@ bool PluckerGenerator::loadDocument( const QString & fileName, QVector<Okular::P
     mPages = unpluck.pages();
     mLinks = unpluck.links();
 
+    // group the links by page once, instead of scanning all of them for every page
+    mPageLinks.resize( mPages.count() );
+    for ( int i = 0; i < mLinks.count(); ++i ) {
+        const int page = mLinks[ i ].page;
+        if ( page >= 0 && page < mPageLinks.count() )
+            mPageLinks[ page ].append( i );
+    }
+
     const QMap<QString, QString> infos = unpluck.infos();
     QMapIterator<QString, QString> it( infos );
     while ( it.hasNext() ) {
@@ -99,6 +109,7 @@ bool PluckerGenerator::doCloseDocument()
 {
     mLinkAdded.clear();
     mLinks.clear();
+    mPageLinks.clear();
 
     qDeleteAll( mPages );
     mPages.clear();
@@ -116,6 +127,7 @@ Okular::DocumentInfo PluckerGenerator::generateDocumentInfo( const QSet<Okular::
 
 QImage PluckerGenerator::image( Okular::PixmapRequest *request )
 {
+    QMutexLocker locker( userMutex() );
     const QSizeF size = mPages[ request->pageNumber() ]->size();
 
     QImage image( request->width(), request->height(), QImage::Format_ARGB32_Premultiplied );
@@ -133,16 +145,13 @@ QImage PluckerGenerator::image( Okular::PixmapRequest *request )
 
     if ( !mLinkAdded.contains( request->pageNumber() ) ) {
         QLinkedList<Okular::ObjectRect*> objects;
-        for ( int i = 0; i < mLinks.count(); ++i ) {
-            if ( mLinks[ i ].page == request->pageNumber() ) {
-                QTextDocument *document = mPages[ request->pageNumber() ];
-
-                QRectF rect;
-                calculateBoundingRect( document, mLinks[ i ].start,
-                                       mLinks[ i ].end, rect );
+        QTextDocument *document = mPages[ request->pageNumber() ];
+        for ( const int i : qAsConst( mPageLinks[ request->pageNumber() ] ) ) {
+            QRectF rect;
+            calculateBoundingRect( document, mLinks[ i ].start,
+                                   mLinks[ i ].end, rect );
 
-                objects.append( new Okular::ObjectRect( rect.left(), rect.top(), rect.right(), rect.bottom(), false, Okular::ObjectRect::Action, mLinks[ i ].link ) );
-            }
+            objects.append( new Okular::ObjectRect( rect.left(), rect.top(), rect.right(), rect.bottom(), false, Okular::ObjectRect::Action, mLinks[ i ].link ) );
         }
 
         if ( !objects.isEmpty() )
@@ -166,16 +175,15 @@ Okular::ExportFormat::List PluckerGenerator::exportFormats() const
 bool PluckerGenerator::exportTo( const QString &fileName, const Okular::ExportFormat &format )
 {
     if ( format.mimeType().name() == QLatin1String( "text/plain" ) ) {
-        QFile file( fileName );
-        if ( !file.open( QIODevice::WriteOnly ) )
-            return false;
-
-        QTextStream out( &file );
-        for ( int i = 0; i < mPages.count(); ++i ) {
-            out << mPages[ i ]->toPlainText();
-        }
-
-        return true;
+        // the pages are laid out when rendered, they are extracted one at
+        // a time, but not in the GUI thread
+        Okular::TextExporter exporter( [this]( int page ) {
+            QMutexLocker locker( userMutex() );
+            return mPages[ page ]->toPlainText();
+        } );
+        exporter.setMaxThreadCount( 1 );
+
+        return exporter.exportTo( fileName, mPages.count() );
     }
 
     return false;
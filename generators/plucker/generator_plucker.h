@@ -51,6 +51,8 @@ class PluckerGenerator : public Okular::Generator
       QList<QTextDocument*> mPages;
       QSet<int> mLinkAdded;
       Link::List mLinks;
+      // the indexes in mLinks of the links of every page
+      QVector<QVector<int>> mPageLinks;
       Okular::DocumentInfo mDocumentInfo;
 };
 
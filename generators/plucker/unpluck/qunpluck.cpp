@@ -106,7 +106,7 @@ static Okular::DocumentViewport calculateViewport( QTextDocument *document, cons
 }
 
 QUnpluck::QUnpluck()
-    : mDocument( 0 )
+    : mDocument( 0 ), mNextRecord( 0 )
 {
 }
 
@@ -158,6 +158,8 @@ bool QUnpluck::open( const QString &fileName )
         delete mRecords[ i ];
 
     mRecords.clear();
+    mRecordIndex.clear();
+    mNextRecord = 0;
 
     plkr_CloseDoc( mDocument );
 
@@ -214,36 +216,28 @@ bool QUnpluck::open( const QString &fileName )
 
 int QUnpluck::GetNextRecordNumber()
 {
-    int index = 0;
+    // records are never marked undone again, so the ones before
+    // mNextRecord need not be looked at any more
+    while ( mNextRecord < mRecords.count() && mRecords[ mNextRecord ]->done )
+        ++mNextRecord;
 
-    for ( int pos = 0; pos < mRecords.count(); ++pos ) {
-        if ( !mRecords[ pos ]->done ) {
-            index = mRecords[ pos ]->index;
-            break;
-        }
-    }
+    if ( mNextRecord < mRecords.count() )
+        return mRecords[ mNextRecord ]->index;
 
-    return index;
+    return 0;
 }
 
 int QUnpluck::GetPageID( int index )
 {
-    for ( int pos = 0; pos < mRecords.count(); ++pos ) {
-        if ( mRecords[ pos ]->index == index ) {
-            return mRecords[ pos ]->page_id;
-        }
-    }
+    const RecordNode *node = mRecordIndex.value( index );
 
-    return 0;
+    return node ? node->page_id : 0;
 }
 
 void QUnpluck::AddRecord( int index )
 {
-    for ( int pos = 0; pos < mRecords.count(); ++pos ) {
-        if ( mRecords[ pos ]->index == index ) {
-            return;
-        }
-    }
+    if ( mRecordIndex.contains( index ) )
+        return;
 
     RecordNode *node = new RecordNode;
     node->done = false;
@@ -251,32 +245,19 @@ void QUnpluck::AddRecord( int index )
     node->page_id = index;
 
     mRecords.append( node );
+    mRecordIndex.insert( index, node );
 }
 
 void QUnpluck::MarkRecordDone( int index )
 {
-    for ( int pos = 0; pos < mRecords.count(); ++pos ) {
-        if ( mRecords[ pos ]->index == index ) {
-            mRecords[ pos ]->done = true;
-            return;
-        }
-    }
-
     AddRecord( index );
-    MarkRecordDone( index );
+    mRecordIndex.value( index )->done = true;
 }
 
 void QUnpluck::SetPageID( int index, int page_id )
 {
-    for ( int pos = 0; pos < mRecords.count(); ++pos ) {
-        if ( mRecords[ pos ]->index == index ) {
-            mRecords[ pos ]->page_id = page_id;
-            return;
-        }
-    }
-
     AddRecord( index );
-    SetPageID( index, page_id );
+    mRecordIndex.value( index )->page_id = page_id;
 }
 
 QString QUnpluck::MailtoURLFromBytes( unsigned char* record_data )
@@ -12,6 +12,7 @@
 #ifndef QUNPLUCK_H
 #define QUNPLUCK_H
 
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QImage>
@@ -76,6 +77,8 @@ class QUnpluck
 
         plkr_Document* mDocument;
         QList<RecordNode*> mRecords;
+        QHash<int, RecordNode*> mRecordIndex;
+        int mNextRecord;
 
         QList<Context*> mContext;
         QList<QTextDocument*> mPages;
@@ -46,6 +46,8 @@
 #include <core/movie.h>
 #include <core/pagetransition.h>
 #include <core/printoptionswidget.h>
+#include <core/rasterprinter.h>
+#include <core/textexporter.h>
 #include <core/sound.h>
 #include <core/sourcereference.h>
 #include <core/textpage.h>
@@ -621,6 +623,7 @@ Okular::Document::OpenResult PDFGenerator::loadDocumentWithPassword( const QStri
 #endif
     // create PDFDoc for the given file
     pdfdoc = Poppler::Document::load( filePath, 0, 0 );
+    pdfFilePath = filePath;
     return init(pagesVector, password);
 }
 
@@ -635,6 +638,7 @@ Okular::Document::OpenResult PDFGenerator::loadDocumentFromDataWithPassword( con
 #endif
     // create PDFDoc for the given file
     pdfdoc = Poppler::Document::loadFromData( fileData, 0, 0 );
+    pdfFilePath.clear();
     return init(pagesVector, password);
 }
 
@@ -653,6 +657,7 @@ Okular::Document::OpenResult PDFGenerator::init(QVector<Okular::Page*> & pagesVe
             return Okular::Document::OpenNeedsPassword;
         }
     }
+    pdfPassword = password.toLatin1();
 
     // build Pages (currentPage was set -1 by deletePages)
     int pageCount = pdfdoc->numPages();
@@ -716,6 +721,8 @@ bool PDFGenerator::doCloseDocument()
     delete pdfdoc;
     pdfdoc = nullptr;
     userMutex()->unlock();
+    pdfFilePath.clear();
+    pdfPassword.clear();
     docSynopsisDirty = true;
     docSyn.clear();
     docEmbeddedFilesDirty = true;
@@ -924,10 +931,12 @@ Okular::FontInfo::List PDFGenerator::fontsForPage( int page )
     QList<Poppler::FontInfo> fonts;
     userMutex()->lock();
 
+    // only hold the lock for the fonts of this page, rendering waits on it
     Poppler::FontIterator* it = pdfdoc->newFontIterator(page);
     if (it->hasNext()) {
         fonts = it->next();
     }
+    delete it;
     userMutex()->unlock();
 
     for (const Poppler::FontInfo &font : qAsConst(fonts))
@@ -1307,8 +1316,25 @@ Okular::TextPage* PDFGenerator::textPage( Okular::TextRequest *request )
 
 void PDFGenerator::requestFontData(const Okular::FontInfo &font, QByteArray *data)
 {
-    Poppler::FontInfo fi = font.nativeId().value<Poppler::FontInfo>();
-    *data = pdfdoc->fontData(fi);
+    if ( font.nativeId().isValid() )
+    {
+        Poppler::FontInfo fi = font.nativeId().value<Poppler::FontInfo>();
+        *data = pdfdoc->fontData(fi);
+        return;
+    }
+
+    // the font list was restored from the document data, so look the font up
+    QMutexLocker locker(userMutex());
+    const QList<Poppler::FontInfo> fonts = pdfdoc->fonts();
+    for (const Poppler::FontInfo &fi : fonts)
+    {
+        if (fi.name() == font.name() && fi.file() == font.file() &&
+            embedTypeForPopplerFontInfo(fi) == font.embedType())
+        {
+            *data = pdfdoc->fontData(fi);
+            return;
+        }
+    }
 }
 
 #define DUMMY_QPRINTER_COPY
@@ -1334,59 +1360,59 @@ bool PDFGenerator::print( QPrinter& printer )
 
     if ( forceRasterize )
     {
-        pdfdoc->setRenderHint(Poppler::Document::HideAnnotations, !printAnnots);
-
     if ( pdfOptionsPage )
     {
         // If requested, scale to full page instead of the printable area
         printer.setFullPage( pdfOptionsPage->ignorePrintMargins() );
     }
 
-    QPainter painter;
-    painter.begin(&printer);
+    // Unit is 'QPrinter::DevicePixel'
+    const QRect painterWindow( 0, 0, printer.width(), printer.height() );
+    // Default: no scaling at all, but we need to go from DevicePixel units to 'points'
+    // Warning: We compute the horizontal scaling, and later assume that the vertical scaling will be the same.
+    const double defaultScaling = printer.paperRect(QPrinter::DevicePixel).width() / printer.paperRect(QPrinter::Point).width();
+#ifdef Q_OS_WIN
+    const int dpiX = printer.physicalDpiX();
+    const int dpiY = printer.physicalDpiY();
+#else
+    // UNIX: Same resolution as the postscript rasterizer; see discussion at https://git.reviewboard.kde.org/r/130218/
+    const int dpiX = 300;
+    const int dpiY = 300;
+#endif
 
-    QList<int> pageList = Okular::FilePrinter::pageList( printer, pdfdoc->numPages(),
-                                                         document()->currentPage() + 1,
-                                                         document()->bookmarkedPageList() );
-    for ( int i = 0; i < pageList.count(); ++i )
+    // The pages are rendered in threads while the previous ones are printed
+    Okular::RasterPrinter rasterPrinter( [this, printAnnots, scaleMode, painterWindow, defaultScaling, dpiX, dpiY]( int page, QRectF *targetRect )
     {
-        if ( i != 0 )
-            printer.newPage();
-
-        const int page = pageList.at( i ) - 1;
-        userMutex()->lock();
+        QMutexLocker locker( userMutex() );
         std::unique_ptr<Poppler::Page> pp( pdfdoc->page( page ) );
-        if (pp)
-        {
-                QSizeF pageSize = pp->pageSizeF();        // Unit is 'points' (i.e., 1/72th of an inch)
-                QRect painterWindow = painter.window();   // Unit is 'QPrinter::DevicePixel'
+        if ( !pp )
+            return QImage();
 
-                // Default: no scaling at all, but we need to go from DevicePixel units to 'points'
-                // Warning: We compute the horizontal scaling, and later assume that the vertical scaling will be the same.
-                double scaling = printer.paperRect(QPrinter::DevicePixel).width() / printer.paperRect(QPrinter::Point).width();
+        QSizeF pageSize = pp->pageSizeF();        // Unit is 'points' (i.e., 1/72th of an inch)
+        double scaling = defaultScaling;
+        if ( scaleMode != PDFOptionsPage::None )
+        {
+             // Get the two scaling factors needed to fit the page onto paper horizontally or vertically
+             auto horizontalScaling = painterWindow.width() / pageSize.width();
+             auto verticalScaling   = painterWindow.height() / pageSize.height();
 
-                if ( scaleMode != PDFOptionsPage::None )
-                {
-                     // Get the two scaling factors needed to fit the page onto paper horizontally or vertically
-                     auto horizontalScaling = painterWindow.width() / pageSize.width();
-                     auto verticalScaling   = painterWindow.height() / pageSize.height();
+             // We use the smaller of the two for both directions, to keep the aspect ratio
+             scaling = std::min(horizontalScaling, verticalScaling);
+        }
+        *targetRect = QRectF( QPointF( 0, 0 ), scaling * pageSize );
 
-                     // We use the smaller of the two for both directions, to keep the aspect ratio
-                     scaling = std::min(horizontalScaling, verticalScaling);
-                }
+        // The hint is shared with the on-screen rendering, which goes on while printing
+        const bool hideAnnotations = pdfdoc->renderHints() & Poppler::Document::HideAnnotations;
+        pdfdoc->setRenderHint( Poppler::Document::HideAnnotations, !printAnnots );
+        QImage img = pp->renderToImage( dpiX, dpiY );
+        pdfdoc->setRenderHint( Poppler::Document::HideAnnotations, hideAnnotations );
+        return img;
+    } );
 
-#ifdef Q_OS_WIN
-            QImage img = pp->renderToImage(  printer.physicalDpiX(), printer.physicalDpiY() );
-#else
-            // UNIX: Same resolution as the postscript rasterizer; see discussion at https://git.reviewboard.kde.org/r/130218/
-            QImage img = pp->renderToImage( 300, 300 );
-#endif
-            painter.drawImage( QRectF( QPointF( 0, 0 ), scaling * pp->pageSizeF() ), img );
-        }
-        userMutex()->unlock();
-    }
-    painter.end();
-    return true;
+    QList<int> pageList = Okular::FilePrinter::pageList( printer, pdfdoc->numPages(),
+                                                         document()->currentPage() + 1,
+                                                         document()->bookmarkedPageList() );
+    return rasterPrinter.print( printer, pageList );
     }
 
 #ifdef DUMMY_QPRINTER_COPY
@@ -1646,28 +1672,64 @@ Okular::ExportFormat::List PDFGenerator::exportFormats() const
 bool PDFGenerator::exportTo( const QString &fileName, const Okular::ExportFormat &format )
 {
     if ( format.mimeType().inherits( QStringLiteral( "text/plain" ) ) ) {
-        QFile f( fileName );
-        if ( !f.open( QIODevice::WriteOnly ) )
-            return false;
+        // a poppler document can not be used by several threads at once, so
+        // every thread extracts the text from its own copy of the document
+        // when the file can be reopened, from the document itself otherwise
+        QMutex clonesMutex;
+        QList<Poppler::Document*> clones;
+        QList<Poppler::Document*> freeClones;
+        QAtomicInt cloneFailed( pdfFilePath.isEmpty() ? 1 : 0 );
+        const int pageCount = document()->pages();
+
+        Okular::TextExporter exporter( [&]( int page ) {
+            Poppler::Document *clone = nullptr;
+            {
+                QMutexLocker locker( &clonesMutex );
+                if ( !freeClones.isEmpty() )
+                    clone = freeClones.takeLast();
+            }
+            if ( !clone && !cloneFailed.load() )
+            {
+                clone = Poppler::Document::load( pdfFilePath, pdfPassword, pdfPassword );
+                // the file may have changed since it was opened
+                if ( !clone || clone->isLocked() || clone->numPages() != pageCount )
+                {
+                    delete clone;
+                    clone = nullptr;
+                    cloneFailed.store( 1 );
+                }
+                else
+                {
+                    QMutexLocker locker( &clonesMutex );
+                    clones.append( clone );
+                }
+            }
 
-        QTextStream ts( &f );
-        int num = document()->pages();
-        for ( int i = 0; i < num; ++i )
-        {
             QString text;
-            userMutex()->lock();
-            Poppler::Page *pp = pdfdoc->page(i);
-            if (pp)
+            if ( clone )
             {
-                text = pp->text(QRect()).normalized(QString::NormalizationForm_KC);
+                Poppler::Page *pp = clone->page( page );
+                if ( pp )
+                    text = pp->text( QRect() ).normalized( QString::NormalizationForm_KC );
+                delete pp;
+
+                QMutexLocker locker( &clonesMutex );
+                freeClones.append( clone );
             }
-            userMutex()->unlock();
-            ts << text;
-            delete pp;
-        }
-        f.close();
+            else
+            {
+                QMutexLocker locker( userMutex() );
+                Poppler::Page *pp = pdfdoc->page( page );
+                if ( pp )
+                    text = pp->text( QRect() ).normalized( QString::NormalizationForm_KC );
+                delete pp;
+            }
+            return text;
+        } );
 
-        return true;
+        const bool exported = exporter.exportTo( fileName, pageCount );
+        qDeleteAll( clones );
+        return exported;
     }
 
     return false;
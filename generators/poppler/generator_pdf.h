@@ -127,6 +127,10 @@ class PDFGenerator : public Okular::Generator, public Okular::ConfigInterface, p
 
         // poppler dependent stuff
         Poppler::Document *pdfdoc;
+        // to open copies of the document, the path is empty when the
+        // document was loaded from data
+        QString pdfFilePath;
+        QByteArray pdfPassword;
 
 
         // misc variables for document info and synopsis caching
@@ -15,7 +15,7 @@
 #include <qfileinfo.h>
 #include <qimage.h>
 #include <qlist.h>
-#include <qpainter.h>
+#include <qmutex.h>
 #include <QPrinter>
 
 #include <kaboutdata.h>
@@ -25,6 +25,7 @@
 #include <core/document.h>
 #include <core/page.h>
 #include <core/fileprinter.h>
+#include <core/rasterprinter.h>
 #include <core/utils.h>
 
 #include <tiff.h>
@@ -238,6 +239,8 @@ QImage TIFFGenerator::image( Okular::PixmapRequest * request )
     bool generated = false;
     QImage img;
 
+    // the pixmap thread shares the TIFF handle with print() and the document info
+    userMutex()->lock();
     if ( TIFFSetDirectory( d->tiff, mapPage( request->page()->number() ) ) )
     {
         int rotation = request->page()->rotation();
@@ -254,7 +257,10 @@ QImage TIFFGenerator::image( Okular::PixmapRequest * request )
         uint32 * data = (uint32 *)image.bits();
 
         // read data
-        if ( TIFFReadRGBAImageOriented( d->tiff, width, height, data, orientation ) != 0 )
+        const bool read = TIFFReadRGBAImageOriented( d->tiff, width, height, data, orientation ) != 0;
+        userMutex()->unlock();
+
+        if ( read )
         {
             // an image read by ReadRGBAImage is ABGR, we need ARGB, so swap red and blue
             uint32 size = width * height;
@@ -274,6 +280,10 @@ QImage TIFFGenerator::image( Okular::PixmapRequest * request )
             generated = true;
         }
     }
+    else
+    {
+        userMutex()->unlock();
+    }
 
     if ( !generated )
     {
@@ -370,29 +380,31 @@ void TIFFGenerator::loadPages( QVector<Okular::Page*> & pagesVector )
 
 bool TIFFGenerator::print( QPrinter& printer )
 {
-    uint32 width = 0;
-    uint32 height = 0;
-
-    QPainter p( &printer );
+    const QSize targetSize = printer.pageRect().size();
 
-    QList<int> pageList = Okular::FilePrinter::pageList( printer, document()->pages(),
-                                                         document()->currentPage() + 1,
-                                                         document()->bookmarkedPageList() );
-
-    for ( int i = 0; i < pageList.count(); ++i )
+    // the pages are decoded one at a time, but scaled in parallel
+    Okular::RasterPrinter rasterPrinter( [this, targetSize]( int page, QRectF * )
     {
-        if ( !TIFFSetDirectory( d->tiff, mapPage( pageList[i] - 1 ) ) )
-            continue;
+        uint32 width = 0;
+        uint32 height = 0;
 
-        if ( TIFFGetField( d->tiff, TIFFTAG_IMAGEWIDTH, &width ) != 1 ||
+        userMutex()->lock();
+        if ( !TIFFSetDirectory( d->tiff, mapPage( page ) ) ||
+             TIFFGetField( d->tiff, TIFFTAG_IMAGEWIDTH, &width ) != 1 ||
              TIFFGetField( d->tiff, TIFFTAG_IMAGELENGTH, &height ) != 1 )
-            continue;
+        {
+            userMutex()->unlock();
+            return QImage();
+        }
 
         QImage image( width, height, QImage::Format_RGB32 );
         uint32 * data = (uint32 *)image.bits();
 
         // read data
-        if ( TIFFReadRGBAImageOriented( d->tiff, width, height, data, ORIENTATION_TOPLEFT ) != 0 )
+        const bool read = TIFFReadRGBAImageOriented( d->tiff, width, height, data, ORIENTATION_TOPLEFT ) != 0;
+        userMutex()->unlock();
+
+        if ( read )
         {
             // an image read by ReadRGBAImage is ABGR, we need ARGB, so swap red and blue
             uint32 size = width * height;
@@ -404,22 +416,21 @@ bool TIFFGenerator::print( QPrinter& printer )
             }
         }
 
-        if ( i != 0 )
-            printer.newPage();
-
-        QSize targetSize = printer.pageRect().size();
-
         if ( (image.width() < targetSize.width()) && (image.height() < targetSize.height()) )
         {
             // draw small images at 100% (don't scale up)
-            p.drawImage( 0, 0, image );
-        } else {
-            // fit to page
-            p.drawImage( 0, 0, image.scaled( targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation ) );
+            return image;
         }
-    }
 
-    return true;
+        // fit to page
+        return image.scaled( targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+    } );
+
+    QList<int> pageList = Okular::FilePrinter::pageList( printer, document()->pages(),
+                                                         document()->currentPage() + 1,
+                                                         document()->bookmarkedPageList() );
+
+    return rasterPrinter.print( printer, pageList );
 }
 
 int TIFFGenerator::mapPage( int page ) const
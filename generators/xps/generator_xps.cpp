@@ -35,6 +35,7 @@
 #include <core/page.h>
 #include <core/area.h>
 #include <core/fileprinter.h>
+#include <core/textexporter.h>
 
 OKULAR_EXPORT_PLUGIN(XpsGenerator, "libokularGenerator_xps.json")
 
@@ -2161,22 +2162,19 @@ Okular::ExportFormat::List XpsGenerator::exportFormats() const
 bool XpsGenerator::exportTo( const QString &fileName, const Okular::ExportFormat &format )
 {
     if ( format.mimeType().inherits( QStringLiteral( "text/plain" ) ) ) {
-        QFile f( fileName );
-        if ( !f.open( QIODevice::WriteOnly ) )
-            return false;
-
-        QTextStream ts( &f );
-        for ( int i = 0; i < m_xpsFile->numPages(); ++i )
-        {
-            Okular::TextPage* textPage = m_xpsFile->page(i)->textPage();
-            QString text = textPage->text();
-            ts << text;
-            ts << QLatin1Char('\n');
+        // the pages share the archive of the document, they are extracted
+        // one at a time, but not in the GUI thread
+        Okular::TextExporter exporter( [this]( int page ) {
+            QMutexLocker lock( userMutex() );
+            Okular::TextPage* textPage = m_xpsFile->page( page )->textPage();
+            const QString text = textPage->text();
             delete textPage;
-        }
-        f.close();
+            return text;
+        } );
+        exporter.setMaxThreadCount( 1 );
+        exporter.setPageSeparator( QStringLiteral( "\n" ) );
 
-        return true;
+        return exporter.exportTo( fileName, m_xpsFile->numPages() );
     }
 
     return false;
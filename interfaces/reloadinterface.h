@@ -0,0 +1,62 @@
+/***************************************************************************
+ *   Copyright (C) 2020 by Okular developers                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef _OKULAR_RELOADINTERFACE_H_
+#define _OKULAR_RELOADINTERFACE_H_
+
+#include "../core/okularcore_export.h"
+
+#include <QObject>
+
+namespace Okular {
+
+/**
+ * @short Abstract interface for reloading a changed file in place
+ *
+ * This interface defines a way to read the document file again once it
+ * changed on disk, without closing the document: the pages, the observers
+ * and the pixmaps of the pages that did not change are kept.
+ *
+ * How to use it in a custom Generator:
+ * @code
+    class MyGenerator : public Okular::Generator, public Okular::ReloadInterface
+    {
+        Q_OBJECT
+        Q_INTERFACES( Okular::ReloadInterface )
+
+        ...
+    };
+ * @endcode
+ * and - of course - implementing its methods.
+ *
+ * @since 1.10
+ */
+class OKULARCORE_EXPORT ReloadInterface
+{
+    public:
+        /**
+         * Destroys the reload interface.
+         */
+        virtual ~ReloadInterface() {}
+
+        /**
+         * Reads @p fileName, the file of the open document, again.
+         *
+         * The pending pixmap requests are already cleared. Returns false if
+         * the file could not be read, the document is then closed and opened
+         * again.
+         */
+        virtual bool reloadDocument( const QString &fileName ) = 0;
+};
+
+}
+
+Q_DECLARE_INTERFACE( Okular::ReloadInterface, "org.kde.okular.ReloadInterface/0.1" )
+
+#endif
@@ -1793,6 +1793,13 @@ bool Part::openUrl( const QUrl &_url, bool swapInsteadOfOpening )
 
 bool Part::queryClose()
 {
+    // the generator is using the document, it can be closed once it is done
+    if ( m_document->isBusy() )
+    {
+        m_pageView->displayMessage( i18n( "The document cannot be closed while it is being printed or exported." ), QString(), PageViewMessage::Warning );
+        return false;
+    }
+
     if ( !isReadWrite() || !isModified() )
         return true;
 
@@ -1841,6 +1848,12 @@ bool Part::queryClose()
 
 bool Part::closeUrl(bool promptToSave)
 {
+    if ( m_document->isBusy() )
+    {
+        m_pageView->displayMessage( i18n( "The document cannot be closed while it is being printed or exported." ), QString(), PageViewMessage::Warning );
+        return false;
+    }
+
     if ( promptToSave && !queryClose() )
         return false;
 
@@ -2020,8 +2033,28 @@ bool Part::slotAttemptReload( bool oneShot, const QUrl &newUrl )
     if ( m_isReloading ) {
         return false;
     }
+
+    // Retry once the document is no longer printed or exported
+    if ( m_document->isBusy() ) {
+        if ( !oneShot )
+            m_dirtyHandler->start( 750 );
+        return false;
+    }
     QScopedValueRollback<bool> rollback(m_isReloading, true);
 
+    // some generators reload the changed file in place, this keeps the
+    // view, the sidebar and the pixmaps of the pages that did not change
+    if ( newUrl.isEmpty() && m_viewportDirty.pageNumber == -1 && !isModified() && url().isLocalFile() && m_document->reloadDocumentInPlace() )
+    {
+        m_fileLastModified = QFileInfo( localFilePath() ).lastModified();
+        m_fileWasRemoved = false;
+
+        // the file may have been replaced by a new one
+        unsetFileToWatch();
+        setFileToWatch( localFilePath() );
+        return true;
+    }
+
     bool tocReloadPrepared = false;
 
     // do the following the first time the file is reloaded
@@ -63,6 +63,7 @@ static const char *shouldShowToolBarComingFromFullScreen = "shouldShowToolBarCom
 
 static const char* const SESSION_URL_KEY = "Urls";
 static const char* const SESSION_TAB_KEY = "ActiveTab";
+static const char* const SESSION_PAGE_COUNT_KEY = "PageCounts";
 
 Shell::Shell( const QString &serializedOptions )
   : KParts::MainWindow(), m_menuBarWasShown(true), m_toolBarWasShown(true)
@@ -390,12 +391,25 @@ void Shell::saveProperties(KConfigGroup &group)
 
     // Gather lists of settings to preserve
     QStringList urls;
+    QList<int> pageCounts;
     for( int i = 0; i < m_tabs.size(); ++i )
     {
-        urls.append( m_tabs[i].part->url().url() );
+        const TabState &tab = m_tabs[i];
+        if( !tab.pendingUrl.isEmpty() )
+        {
+            urls.append( tab.pendingUrl.url() );
+            pageCounts.append( tab.pendingPageCount );
+            continue;
+        }
+
+        uint pageCount = 0;
+        QMetaObject::invokeMethod( tab.part, "pages", Q_RETURN_ARG( uint, pageCount ) );
+        urls.append( tab.part->url().url() );
+        pageCounts.append( pageCount );
     }
     group.writePathEntry( SESSION_URL_KEY, urls );
     group.writeEntry( SESSION_TAB_KEY, m_tabWidget->currentIndex() );
+    group.writeEntry( SESSION_PAGE_COUNT_KEY, pageCounts );
 }
 
 void Shell::readProperties(const KConfigGroup &group)
@@ -404,15 +418,41 @@ void Shell::readProperties(const KConfigGroup &group)
     QStringList urls = group.readPathEntry( SESSION_URL_KEY, QStringList() );
     int desiredTab = group.readEntry<int>( SESSION_TAB_KEY, 0 );
 
-    while( !urls.isEmpty() )
+    const bool openInTabs = m_tabs.size() == 1 && m_tabs[0].part->url().isEmpty()
+            && dynamic_cast<Okular::ViewerInterface*>(m_tabs[0].part)->openNewFilesInTabs();
+    if( !openInTabs || urls.size() < 2 )
     {
-        openUrl( QUrl(urls.takeFirst()) );
+        while( !urls.isEmpty() )
+        {
+            openUrl( QUrl(urls.takeFirst()) );
+        }
+
+        if( desiredTab < m_tabs.size() )
+        {
+            setActiveTab( desiredTab );
+        }
+        return;
     }
 
-    if( desiredTab < m_tabs.size() )
+    // Only the document of the active tab is opened now, the other tabs get
+    // their document when they are activated
+    const QList<int> pageCounts = group.readEntry( SESSION_PAGE_COUNT_KEY, QList<int>() );
+    for( int i = 0; i < urls.size(); ++i )
     {
-        setActiveTab( desiredTab );
+        const QUrl url( urls.at( i ) );
+        const int tab = i == 0 ? 0 : createTab( url.fileName() );
+        m_tabWidget->setTabText( tab, url.fileName() );
+        m_tabs[tab].pendingUrl = url;
+        m_tabs[tab].pendingPageCount = qMax( pageCounts.value( i ), 0 );
+
+        const QString location = url.toDisplayString( QUrl::PreferLocalFile );
+        if( m_tabs[tab].pendingPageCount > 0 )
+            m_tabWidget->setTabToolTip( tab, i18np( "%2\n1 page", "%2\n%1 pages", m_tabs[tab].pendingPageCount, location ) );
+        else
+            m_tabWidget->setTabToolTip( tab, location );
     }
+
+    setActiveTab( desiredTab >= 0 && desiredTab < m_tabs.size() ? desiredTab : 0 );
 }
 
 QStringList Shell::fileFormats() const
@@ -641,12 +681,27 @@ void Shell::setActiveTab( int tab )
     createGUI( m_tabs[tab].part );
     m_printAction->setEnabled( m_tabs[tab].printEnabled );
     m_closeAction->setEnabled( m_tabs[tab].closeEnabled );
+    openPendingUrl( tab );
+}
+
+void Shell::openPendingUrl( int tab )
+{
+    const QUrl url = m_tabs[tab].pendingUrl;
+    if( url.isEmpty() )
+        return;
+
+    m_tabs[tab].pendingUrl = QUrl();
+    m_tabs[tab].pendingPageCount = 0;
+    m_tabWidget->setTabToolTip( tab, QString() );
+
+    if( m_tabs[tab].part->openUrl( url ) )
+        m_recent->addUrl( url );
 }
 
 void Shell::closeTab( int tab )
 {
     KParts::ReadWritePart* const part = m_tabs[tab].part;
-    QUrl url = part->url();
+    QUrl url = m_tabs[tab].pendingUrl.isEmpty() ? part->url() : m_tabs[tab].pendingUrl;
     if( part->closeUrl() && m_tabs.count() > 1 )
     {
         if( part->factory() )
@@ -668,7 +723,7 @@ void Shell::closeTab( int tab )
 
 }
 
-void Shell::openNewTab( const QUrl& url, const QString &serializedOptions )
+int Shell::createTab( const QString &title )
 {
     // Tabs are hidden when there's only one, so show it
     if( m_tabs.size() == 1 )
@@ -685,8 +740,15 @@ void Shell::openNewTab( const QUrl& url, const QString &serializedOptions )
     connectPart( m_tabs[newIndex].part );
 
     // Update GUI
+    m_tabWidget->addTab( m_tabs[newIndex].part->widget(), title );
+
+    return newIndex;
+}
+
+void Shell::openNewTab( const QUrl& url, const QString &serializedOptions )
+{
+    const int newIndex = createTab( url.fileName() );
     KParts::ReadWritePart* const part = m_tabs[newIndex].part;
-    m_tabWidget->addTab( part->widget(), url.fileName() );
 
     applyOptionsToPart(part, serializedOptions);
 
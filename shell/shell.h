@@ -138,6 +138,8 @@ private:
   void setupActions();
   QStringList fileFormats() const;
   void openNewTab( const QUrl& url, const QString &serializedOptions );
+  int  createTab( const QString &title );
+  void openPendingUrl( int tab );
   void applyOptionsToPart( QObject* part, const QString &serializedOptions );
   void connectPart( QObject* part );
   int  findTabIndex( QObject* sender );
@@ -163,11 +165,15 @@ private:
     TabState( KParts::ReadWritePart* p )
       : part(p),
         printEnabled(false),
-        closeEnabled(false)
+        closeEnabled(false),
+        pendingPageCount(0)
     {}
     KParts::ReadWritePart* part;
     bool printEnabled;
     bool closeEnabled;
+    // document of a restored tab, opened once the tab gets activated
+    QUrl pendingUrl;
+    uint pendingPageCount;
   };
   QList<TabState> m_tabs;
   QList<QUrl> m_closedTabUrls;
@@ -12,9 +12,11 @@
 
 #include "annotationmodel.h"
 
+#include <qhash.h>
 #include <qlinkedlist.h>
 #include <qlist.h>
 #include <qpointer.h>
+#include <qset.h>
 
 #include <QIcon>
 #include <KLocalizedString>
@@ -25,6 +27,8 @@
 #include "core/page.h"
 #include "ui/guiutils.h"
 
+#include <algorithm>
+
 struct AnnItem
 {
     AnnItem();
@@ -69,10 +73,15 @@ public:
     QModelIndex indexForItem( AnnItem *item ) const;
     void rebuildTree( const QVector< Okular::Page * > &pages );
     AnnItem* findItem( int page, int *index ) const;
+    int branchRow( int page ) const;
+    void removeBranch( int row );
 
     AnnotationModel *q;
     AnnItem *root;
     QPointer< Okular::Document > document;
+    // the branches of the pages with annotations, and the items of the annotations
+    QHash< int, AnnItem* > pageItems;
+    QHash< Okular::Annotation*, AnnItem* > annotationItems;
 };
 
 
@@ -111,16 +120,18 @@ AnnotationModelPrivate::~AnnotationModelPrivate()
     delete root;
 }
 
-static void updateAnnotationPointer( AnnItem *item, const QVector< Okular::Page * > &pages )
+static void updateAnnotationPointer( AnnItem *item, const QVector< Okular::Page * > &pages, QHash< Okular::Annotation*, AnnItem* > *annotationItems )
 {
     if ( item->annotation ) {
         item->annotation = pages[ item->page ]->annotation( item->annotation->uniqueName() );
-        if ( !item->annotation )
+        if ( item->annotation )
+            annotationItems->insert( item->annotation, item );
+        else
             qWarning() << "Lost annotation on document save, something went wrong";
     }
 
     for ( AnnItem *child : qAsConst(item->children) ) {
-        updateAnnotationPointer( child, pages );
+        updateAnnotationPointer( child, pages, annotationItems );
     }
 }
 
@@ -134,7 +145,8 @@ void AnnotationModelPrivate::notifySetup( const QVector< Okular::Page * > &pages
             // need to update all the Annotation* otherwise
             // they still point to the old document ones, luckily the old ones are still
             // around so we can look for the new ones using unique ids, etc
-            updateAnnotationPointer( root, pages );
+            annotationItems.clear();
+            updateAnnotationPointer( root, pages, &annotationItems );
         }
         return;
     }
@@ -142,6 +154,8 @@ void AnnotationModelPrivate::notifySetup( const QVector< Okular::Page * > &pages
     q->beginResetModel();
     qDeleteAll( root->children );
     root->children.clear();
+    pageItems.clear();
+    annotationItems.clear();
 
     rebuildTree( pages );
     q->endResetModel();
@@ -163,98 +177,91 @@ void AnnotationModelPrivate::notifyPageChanged( int page, int flags )
         if ( annItem )
         {
             q->beginRemoveRows( indexForItem( root ), annItemIndex, annItemIndex );
-            delete root->children.at( annItemIndex );
-            root->children.removeAt( annItemIndex );
+            removeBranch( annItemIndex );
             q->endRemoveRows();
         }
         return;
     }
     // case 2: no existing branch
-    //         => add a new branch, and add the annotations for the page
+    //         => add a new branch with all the annotations of the page at once
     if ( !annItem )
     {
-        int i = 0;
-        while ( i < root->children.count() && root->children.at( i )->page < page ) ++i;
+        const int i = branchRow( page );
 
-        AnnItem *annItem = new AnnItem();
+        q->beginInsertRows( indexForItem( root ), i, i );
+        annItem = new AnnItem();
         annItem->page = page;
         annItem->parent = root;
-        q->beginInsertRows( indexForItem( root ), i, i );
-        annItem->parent->children.insert( i, annItem );
+        root->children.insert( i, annItem );
+        pageItems.insert( page, annItem );
+        for ( Okular::Annotation *annotation : annots )
+            annotationItems.insert( annotation, new AnnItem( annItem, annotation ) );
         q->endInsertRows();
-        QLinkedList< Okular::Annotation* >::ConstIterator it = annots.begin(), itEnd = annots.end();
-        int newid = 0;
-        for ( ; it != itEnd; ++it, ++newid )
-        {
-            q->beginInsertRows( indexForItem( annItem ), newid, newid );
-            new AnnItem( annItem, *it );
-            q->endInsertRows();
-        }
         return;
     }
-    // case 3: existing branch, less annotations than items
-    //         => lookup and remove the annotations
-    if ( annItem->children.count() > annots.count() )
+
+    const QModelIndex annItemModelIndex = indexForItem( annItem );
+    QSet< Okular::Annotation* > pageAnnotations;
+    pageAnnotations.reserve( annots.count() );
+    for ( Okular::Annotation *annotation : annots )
+        pageAnnotations.insert( annotation );
+
+    // case 3: existing branch, items of annotations not in the page anymore
+    //         => remove them, a run of adjacent items at a time
+    bool changed = false;
+    for ( int last = annItem->children.count() - 1; last >= 0; --last )
     {
-        for ( int i = annItem->children.count(); i > 0; --i )
+        if ( pageAnnotations.contains( annItem->children.at( last )->annotation ) )
+            continue;
+
+        int first = last;
+        while ( first > 0 && !pageAnnotations.contains( annItem->children.at( first - 1 )->annotation ) )
+            --first;
+
+        q->beginRemoveRows( annItemModelIndex, first, last );
+        for ( int i = last; i >= first; --i )
         {
-            Okular::Annotation *ref = annItem->children.at( i - 1 )->annotation;
-            bool found = false;
-            QLinkedList< Okular::Annotation* >::ConstIterator it = annots.begin(), itEnd = annots.end();
-            for ( ; !found && it != itEnd; ++it )
-            {
-                if ( ( *it ) == ref )
-                    found = true;
-            }
-            if ( !found )
-            {
-                q->beginRemoveRows( indexForItem( annItem ), i - 1, i - 1 );
-                delete annItem->children.at( i - 1 );
-                annItem->children.removeAt( i - 1 );
-                q->endRemoveRows();
-            }
+            AnnItem *item = annItem->children.takeAt( i );
+            annotationItems.remove( item->annotation );
+            delete item;
         }
-        return;
+        q->endRemoveRows();
+
+        last = first;
+        changed = true;
     }
-    // case 4: existing branch, less items than annotations
-    //         => lookup and add annotations if not in the branch
-    if ( annots.count() > annItem->children.count() )
+    // case 4: existing branch, annotations without an item
+    //         => append them at once
+    QList< Okular::Annotation* > added;
+    for ( Okular::Annotation *annotation : annots )
     {
-        QLinkedList< Okular::Annotation* >::ConstIterator it = annots.begin(), itEnd = annots.end();
-        for ( ; it != itEnd; ++it )
-        {
-            Okular::Annotation *ref = *it;
-            bool found = false;
-            int count = annItem->children.count();
-            for ( int i = 0; !found && i < count; ++i )
-            {
-                if ( ref == annItem->children.at( i )->annotation )
-                    found = true;
-            }
-            if ( !found )
-            {
-                q->beginInsertRows( indexForItem( annItem ), count, count );
-                new AnnItem( annItem, ref );
-                q->endInsertRows();
-            }
-        }
-        return;
+        const AnnItem *item = annotationItems.value( annotation );
+        if ( !item || item->parent != annItem )
+            added.append( annotation );
+    }
+    if ( !added.isEmpty() )
+    {
+        const int count = annItem->children.count();
+        q->beginInsertRows( annItemModelIndex, count, count + added.count() - 1 );
+        for ( Okular::Annotation *annotation : qAsConst( added ) )
+            annotationItems.insert( annotation, new AnnItem( annItem, annotation ) );
+        q->endInsertRows();
+        changed = true;
     }
+    if ( changed )
+        return;
     // case 5: the data of some annotation changed
     // TODO: what do we do in this case?
     // FIXME: for now, update ALL the annotations for that page
-    for ( int i = 0; i < annItem->children.count(); ++i )
-    {
-        QModelIndex index = indexForItem( annItem->children.at( i ) );
-        emit q->dataChanged( index, index );
-    }
+    emit q->dataChanged( indexForItem( annItem->children.first() ), indexForItem( annItem->children.last() ) );
 }
 
 QModelIndex AnnotationModelPrivate::indexForItem( AnnItem *item ) const
 {
     if ( item->parent )
     {
-        int id = item->parent->children.indexOf( item );
+        // the branches are sorted by page
+        const int id = item->parent == root ? branchRow( item->page ) : item->parent->children.indexOf( item );
         if ( id >= 0 && id < item->parent->children.count() )
            return q->createIndex( id, 0, item );
     }
@@ -274,10 +281,11 @@ void AnnotationModelPrivate::rebuildTree( const QVector< Okular::Page * > &pages
             continue;
 
         AnnItem *annItem = new AnnItem( root, i );
+        pageItems.insert( i, annItem );
         QLinkedList< Okular::Annotation* >::ConstIterator it = annots.begin(), itEnd = annots.end();
         for ( ; it != itEnd; ++it )
         {
-            new AnnItem( annItem, *it );
+            annotationItems.insert( *it, new AnnItem( annItem, *it ) );
         }
     }
     emit q->layoutChanged();
@@ -285,19 +293,29 @@ void AnnotationModelPrivate::rebuildTree( const QVector< Okular::Page * > &pages
 
 AnnItem* AnnotationModelPrivate::findItem( int page, int *index ) const
 {
-    for ( int i = 0; i < root->children.count(); ++i )
-    {
-        AnnItem *tmp = root->children.at( i );
-        if ( tmp->page == page )
-        {
-            if ( index )
-                *index = i;
-            return tmp;
-        }
-    }
+    AnnItem *item = pageItems.value( page );
     if ( index )
-        *index = -1;
-    return nullptr;
+        *index = item ? branchRow( page ) : -1;
+    return item;
+}
+
+static bool pageLessThan( const AnnItem *item, int page )
+{
+    return item->page < page;
+}
+
+int AnnotationModelPrivate::branchRow( int page ) const
+{
+    return std::lower_bound( root->children.constBegin(), root->children.constEnd(), page, pageLessThan ) - root->children.constBegin();
+}
+
+void AnnotationModelPrivate::removeBranch( int row )
+{
+    AnnItem *annItem = root->children.takeAt( row );
+    for ( const AnnItem *item : qAsConst( annItem->children ) )
+        annotationItems.remove( item->annotation );
+    pageItems.remove( annItem->page );
+    delete annItem;
 }
 
 
@@ -337,6 +355,8 @@ QVariant AnnotationModel::data( const QModelIndex &index, int role ) const
           return QIcon::fromTheme( QStringLiteral("text-plain") );
         else if ( role == PageRole )
           return item->page;
+        else if ( role == AnnotationRole )
+          return QVariant::fromValue< Okular::Annotation* >( nullptr );
 
         return QVariant();
     }
@@ -357,6 +377,9 @@ QVariant AnnotationModel::data( const QModelIndex &index, int role ) const
         case PageRole:
             return item->page;
             break;
+        case AnnotationRole:
+            return QVariant::fromValue( item->annotation );
+            break;
     }
     return QVariant();
 }
@@ -12,8 +12,9 @@
 
 #include <qabstractitemmodel.h>
 
+#include "core/annotations.h"
+
 namespace Okular {
-class Annotation;
 class Document;
 }
 
@@ -26,7 +27,8 @@ class AnnotationModel : public QAbstractItemModel
     public:
         enum {
             AuthorRole = Qt::UserRole + 1000,
-            PageRole
+            PageRole,
+            AnnotationRole  // the Okular::Annotation*, null for the pages
         };
 
         explicit AnnotationModel( Okular::Document *document, QObject *parent = nullptr );
@@ -50,6 +52,6 @@ class AnnotationModel : public QAbstractItemModel
         AnnotationModelPrivate *const d;
 };
 
-
+Q_DECLARE_METATYPE( Okular::Annotation* )
 
 #endif
@@ -9,18 +9,18 @@
 
 #include "annotationproxymodels.h"
 
+#include <QHash>
 #include <QList>
 #include <QItemSelection>
+#include <QPair>
+#include <QStringList>
 
 #include <QIcon>
 
 #include "annotationmodel.h"
 #include "debug_ui.h"
 
-static quint32 mixIndex( int row, int column )
-{
-    return ( row << 4 ) | column;
-}
+#include <algorithm>
 
 PageFilterProxyModel::PageFilterProxyModel( QObject *parent )
   : QSortFilterProxyModel( parent ),
@@ -68,7 +68,8 @@ bool PageFilterProxyModel::filterAcceptsRow( int row, const QModelIndex &sourceP
 
 PageGroupProxyModel::PageGroupProxyModel( QObject *parent )
   : QAbstractProxyModel( parent ),
-    mGroupByPage( false )
+    mGroupByPage( false ),
+    mRemovingRows( false )
 {
 }
 
@@ -101,14 +102,14 @@ int PageGroupProxyModel::rowCount( const QModelIndex &parentIndex ) const
       if ( parentIndex.parent().isValid() )
         return 0;
       else {
-        return mTreeIndexes[ parentIndex.row() ].second.count(); // second-level
+        return mPages[ parentIndex.row() ].count; // second-level
       }
     } else {
-      return mTreeIndexes.count(); // top-level
+      return mPages.count(); // top-level
     }
   } else {
     if ( !parentIndex.isValid() ) // top-level
-      return mIndexes.count();
+      return mPages.isEmpty() ? 0 : mPages.last().offset + mPages.last().count;
     else
       return 0;
   }
@@ -121,20 +122,22 @@ QModelIndex PageGroupProxyModel::index( int row, int column, const QModelIndex &
 
   if ( mGroupByPage ) {
     if ( parentIndex.isValid() ) {
-      if ( parentIndex.row() >= 0 && parentIndex.row() < mTreeIndexes.count()
-           && row < mTreeIndexes[ parentIndex.row() ].second.count() )
-        return createIndex( row, column, qint32( parentIndex.row() + 1 ) );
+      // the annotations know the number of their page, which unlike its
+      // row does not change when other pages are inserted or removed
+      if ( parentIndex.row() >= 0 && parentIndex.row() < mPages.count()
+           && row < mPages[ parentIndex.row() ].count )
+        return createIndex( row, column, quintptr( mPages[ parentIndex.row() ].page + 1 ) );
       else
         return QModelIndex();
     } else {
-      if ( row < mTreeIndexes.count() )
+      if ( row < mPages.count() )
         return createIndex( row, column );
       else
         return QModelIndex();
     }
   } else {
-    if ( row < mIndexes.count() )
-      return createIndex( row, column, mixIndex( parentIndex.row(), parentIndex.column() ) );
+    if ( row < rowCount( QModelIndex() ) )
+      return createIndex( row, column );
     else
       return QModelIndex();
   }
@@ -146,7 +149,7 @@ QModelIndex PageGroupProxyModel::parent( const QModelIndex &idx ) const
     if ( idx.internalId() == 0 ) // top-level
       return QModelIndex();
     else
-      return index( idx.internalId() - 1, idx.column() );
+      return index( rowForPage( idx.internalId() - 1 ), idx.column() );
   } else {
     // We have only top-level items
     return QModelIndex();
@@ -155,19 +158,22 @@ QModelIndex PageGroupProxyModel::parent( const QModelIndex &idx ) const
 
 QModelIndex PageGroupProxyModel::mapFromSource( const QModelIndex &sourceIndex ) const
 {
+  if ( !sourceIndex.isValid() )
+    return QModelIndex();
+
+  const QModelIndex sourceParent = sourceIndex.parent();
   if ( mGroupByPage ) {
-    if ( sourceIndex.parent().isValid() ) {
-      return index( sourceIndex.row(), sourceIndex.column(), sourceIndex.parent() );
+    if ( sourceParent.isValid() ) {
+      return index( sourceIndex.row(), sourceIndex.column(), index( sourceParent.row(), 0 ) );
     } else {
       return index( sourceIndex.row(), sourceIndex.column() );
     }
   } else {
-    for ( int i = 0; i < mIndexes.count(); ++i ) {
-      if ( mIndexes[ i ] == sourceIndex )
-        return index( i, 0 );
-    }
+    // only the annotations are in the list
+    if ( !sourceParent.isValid() || sourceParent.row() >= mPages.count() )
+      return QModelIndex();
 
-    return QModelIndex();
+    return index( mPages[ sourceParent.row() ].offset + sourceIndex.row(), 0 );
   }
 }
 
@@ -179,22 +185,23 @@ QModelIndex PageGroupProxyModel::mapToSource( const QModelIndex &proxyIndex ) co
   if ( mGroupByPage ) {
     if ( proxyIndex.internalId() == 0 ) {
 
-      if ( proxyIndex.row() >= mTreeIndexes.count() || proxyIndex.row() < 0 )
+      if ( proxyIndex.row() >= mPages.count() || proxyIndex.row() < 0 )
         return QModelIndex();
 
-      return mTreeIndexes[ proxyIndex.row() ].first;
+      return sourceModel()->index( proxyIndex.row(), 0 );
     } else {
-      if ( qint32(proxyIndex.internalId()) - 1 >= mTreeIndexes.count() ||
-           proxyIndex.row() >= mTreeIndexes[ proxyIndex.internalId() - 1 ].second.count() )
+      const int pageRow = rowForPage( proxyIndex.internalId() - 1 );
+      if ( pageRow < 0 || proxyIndex.row() >= mPages[ pageRow ].count )
         return QModelIndex();
 
-      return mTreeIndexes[ proxyIndex.internalId() - 1 ].second[ proxyIndex.row() ];
+      return sourceModel()->index( proxyIndex.row(), 0, sourceModel()->index( pageRow, 0 ) );
     }
   } else {
-    if ( proxyIndex.column() > 0 || proxyIndex.row() >= mIndexes.count() )
+    if ( proxyIndex.column() > 0 || proxyIndex.row() >= rowCount( QModelIndex() ) )
       return QModelIndex();
     else {
-      return mIndexes[ proxyIndex.row() ];
+      const int pageRow = rowForOffset( proxyIndex.row() );
+      return sourceModel()->index( proxyIndex.row() - mPages[ pageRow ].offset, 0, sourceModel()->index( pageRow, 0 ) );
     }
   }
 }
@@ -204,8 +211,9 @@ void PageGroupProxyModel::setSourceModel( QAbstractItemModel *model )
   if ( sourceModel() ) {
     disconnect( sourceModel(), &QAbstractItemModel::layoutChanged, this, &PageGroupProxyModel::rebuildIndexes );
     disconnect( sourceModel(), &QAbstractItemModel::modelReset, this, &PageGroupProxyModel::rebuildIndexes );
-    disconnect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &PageGroupProxyModel::rebuildIndexes );
-    disconnect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &PageGroupProxyModel::rebuildIndexes );
+    disconnect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &PageGroupProxyModel::sourceRowsInserted );
+    disconnect( sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &PageGroupProxyModel::sourceRowsAboutToBeRemoved );
+    disconnect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &PageGroupProxyModel::sourceRowsRemoved );
     disconnect( sourceModel(), &QAbstractItemModel::dataChanged, this, &PageGroupProxyModel::sourceDataChanged );
   }
 
@@ -213,8 +221,9 @@ void PageGroupProxyModel::setSourceModel( QAbstractItemModel *model )
 
   connect( sourceModel(), &QAbstractItemModel::layoutChanged, this, &PageGroupProxyModel::rebuildIndexes );
   connect( sourceModel(), &QAbstractItemModel::modelReset, this, &PageGroupProxyModel::rebuildIndexes );
-  connect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &PageGroupProxyModel::rebuildIndexes );
-  connect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &PageGroupProxyModel::rebuildIndexes );
+  connect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &PageGroupProxyModel::sourceRowsInserted );
+  connect( sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &PageGroupProxyModel::sourceRowsAboutToBeRemoved );
+  connect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &PageGroupProxyModel::sourceRowsRemoved );
   connect( sourceModel(), &QAbstractItemModel::dataChanged, this, &PageGroupProxyModel::sourceDataChanged );
 
   rebuildIndexes();
@@ -224,31 +233,137 @@ void PageGroupProxyModel::rebuildIndexes()
 {
   beginResetModel();
 
-  if ( mGroupByPage ) {
-    mTreeIndexes.clear();
+  // both the tree and the list are made of the pages of the source model
+  const int pageCount = sourceModel()->rowCount();
+  mPages.clear();
+  mPages.reserve( pageCount );
+  for ( int row = 0; row < pageCount; ++row ) {
+    mPages.append( pageRows( row ) );
+  }
+  updateOffsets( 0 );
 
-    for ( int row = 0; row < sourceModel()->rowCount(); ++row ) {
-      const QModelIndex pageIndex = sourceModel()->index( row, 0 );
+  endResetModel();
+}
 
-      QList<QModelIndex> itemIndexes;
-      for ( int subRow = 0; subRow < sourceModel()->rowCount( pageIndex ); ++subRow ) {
-        itemIndexes.append( sourceModel()->index( subRow, 0, pageIndex ) );
-      }
+PageGroupProxyModel::PageRows PageGroupProxyModel::pageRows( int sourceRow ) const
+{
+  const QModelIndex pageIndex = sourceModel()->index( sourceRow, 0 );
+
+  PageRows rows;
+  rows.page = sourceModel()->data( pageIndex, AnnotationModel::PageRole ).toInt();
+  rows.count = sourceModel()->rowCount( pageIndex );
+  rows.offset = 0;
+  return rows;
+}
+
+int PageGroupProxyModel::rowForPage( int page ) const
+{
+  const auto pageLessThan = []( const PageRows &rows, int value ) { return rows.page < value; };
+  const QVector<PageRows>::const_iterator it = std::lower_bound( mPages.constBegin(), mPages.constEnd(), page, pageLessThan );
+  if ( it == mPages.constEnd() || it->page != page )
+    return -1;
+
+  return it - mPages.constBegin();
+}
 
-      mTreeIndexes.append( QPair<QModelIndex, QList<QModelIndex> >( pageIndex, itemIndexes ) );
+int PageGroupProxyModel::rowForOffset( int row ) const
+{
+  // the last page starting at or before the row, pages without annotations
+  // share the offset of the next one
+  const auto offsetLessThan = []( int value, const PageRows &rows ) { return value < rows.offset; };
+  return std::upper_bound( mPages.constBegin(), mPages.constEnd(), row, offsetLessThan ) - mPages.constBegin() - 1;
+}
+
+void PageGroupProxyModel::updateOffsets( int from )
+{
+  int offset = from > 0 ? mPages[ from - 1 ].offset + mPages[ from - 1 ].count : 0;
+  for ( int i = from; i < mPages.count(); ++i ) {
+    mPages[ i ].offset = offset;
+    offset += mPages[ i ].count;
+  }
+}
+
+void PageGroupProxyModel::sourceRowsInserted( const QModelIndex &sourceParent, int first, int last )
+{
+  if ( !sourceParent.isValid() ) {
+    // new pages, together with their annotations
+    QVector<PageRows> pages;
+    int count = 0;
+    for ( int row = first; row <= last; ++row ) {
+      pages.append( pageRows( row ) );
+      count += pages.last().count;
     }
-  } else {
-    mIndexes.clear();
 
-    for ( int row = 0; row < sourceModel()->rowCount(); ++row ) {
-      const QModelIndex pageIndex = sourceModel()->index( row, 0 );
-      for ( int subRow = 0; subRow < sourceModel()->rowCount( pageIndex ); ++subRow ) {
-        mIndexes.append( sourceModel()->index( subRow, 0, pageIndex ) );
+    const bool insertRows = mGroupByPage || count > 0;
+    if ( mGroupByPage ) {
+      beginInsertRows( QModelIndex(), first, last );
+    } else if ( count > 0 ) {
+      const int offset = first > 0 ? mPages[ first - 1 ].offset + mPages[ first - 1 ].count : 0;
+      beginInsertRows( QModelIndex(), offset, offset + count - 1 );
+    }
+
+    for ( int i = 0; i < pages.count(); ++i ) {
+      mPages.insert( first + i, pages.at( i ) );
+    }
+    updateOffsets( first );
+
+    if ( insertRows )
+      endInsertRows();
+  } else if ( !sourceParent.parent().isValid() ) {
+    // new annotations of a page
+    const int pageRow = sourceParent.row();
+    if ( mGroupByPage )
+      beginInsertRows( index( pageRow, 0 ), first, last );
+    else
+      beginInsertRows( QModelIndex(), mPages[ pageRow ].offset + first, mPages[ pageRow ].offset + last );
+
+    mPages[ pageRow ].count += last - first + 1;
+    updateOffsets( pageRow + 1 );
+
+    endInsertRows();
+  }
+}
+
+void PageGroupProxyModel::sourceRowsAboutToBeRemoved( const QModelIndex &sourceParent, int first, int last )
+{
+  mRemovingRows = false;
+
+  if ( !sourceParent.isValid() ) {
+    if ( mGroupByPage ) {
+      beginRemoveRows( QModelIndex(), first, last );
+      mRemovingRows = true;
+    } else {
+      const int offset = mPages[ first ].offset;
+      const int count = mPages[ last ].offset + mPages[ last ].count - offset;
+      if ( count > 0 ) {
+        beginRemoveRows( QModelIndex(), offset, offset + count - 1 );
+        mRemovingRows = true;
       }
     }
+  } else if ( !sourceParent.parent().isValid() ) {
+    const int pageRow = sourceParent.row();
+    if ( mGroupByPage )
+      beginRemoveRows( index( pageRow, 0 ), first, last );
+    else
+      beginRemoveRows( QModelIndex(), mPages[ pageRow ].offset + first, mPages[ pageRow ].offset + last );
+    mRemovingRows = true;
+  }
+}
+
+void PageGroupProxyModel::sourceRowsRemoved( const QModelIndex &sourceParent, int first, int last )
+{
+  if ( !sourceParent.isValid() ) {
+    mPages.remove( first, last - first + 1 );
+    updateOffsets( first );
+  } else if ( !sourceParent.parent().isValid() ) {
+    mPages[ sourceParent.row() ].count -= last - first + 1;
+    updateOffsets( sourceParent.row() + 1 );
   }
 
-  endResetModel();
+  if ( mRemovingRows ) {
+    mRemovingRows = false;
+    endRemoveRows();
+  }
 }
 
 void PageGroupProxyModel::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
@@ -267,6 +382,10 @@ void PageGroupProxyModel::groupByPage( bool value )
 }
 
 
+// The page and the annotation of a source index, null for the pages. Unlike
+// the source index it does not change when rows are inserted or removed before it.
+typedef QPair<int, Okular::Annotation*> AuthorGroupKey;
+
 class AuthorGroupItem
 {
     public:
@@ -277,8 +396,8 @@ class AuthorGroupItem
             Annotation
         };
 
-        AuthorGroupItem( AuthorGroupItem *parent, Type type = Page, const QModelIndex &index = QModelIndex() )
-            : mParent( parent ), mType( type ), mIndex( index )
+        AuthorGroupItem( AuthorGroupItem *parent, Type type = Page, const QModelIndex &index = QModelIndex(), const AuthorGroupKey &key = AuthorGroupKey() )
+            : mParent( parent ), mType( type ), mIndex( index ), mKey( key )
         {
         }
 
@@ -291,6 +410,8 @@ class AuthorGroupItem
         AuthorGroupItem &operator=(const AuthorGroupItem &) = delete;
 
         void appendChild( AuthorGroupItem *child ) { mChilds.append( child ); }
+        void insertChild( int row, AuthorGroupItem *child ) { mChilds.insert( row, child ); }
+        AuthorGroupItem* takeChild( int row ) { return mChilds.takeAt( row ); }
         AuthorGroupItem* parent() const { return mParent; }
         AuthorGroupItem* child( int row ) const { return mChilds.value( row ); }
         int childCount() const { return mChilds.count(); }
@@ -306,18 +427,14 @@ class AuthorGroupItem
                 mChilds[ i ]->dump( level + 2 );
         }
 
-        const AuthorGroupItem* findIndex( const QModelIndex &index ) const
+        /**
+         * Returns the row where the annotation of the given source row goes,
+         * the annotations are kept in the order of the source model.
+         */
+        int insertionRow( int sourceRow ) const
         {
-            if ( index == mIndex )
-                return this;
-
-            for ( int i = 0; i < mChilds.count(); ++i ) {
-                const AuthorGroupItem *item = mChilds[ i ]->findIndex( index );
-                if ( item )
-                    return item;
-            }
-
-            return nullptr;
+            const auto rowLessThan = []( const AuthorGroupItem *item, int row ) { return item->mIndex.row() < row; };
+            return std::lower_bound( mChilds.constBegin(), mChilds.constEnd(), sourceRow, rowLessThan ) - mChilds.constBegin();
         }
 
         int row() const
@@ -327,6 +444,7 @@ class AuthorGroupItem
 
         Type type() const { return mType; }
         QModelIndex index() const { return mIndex; }
+        AuthorGroupKey key() const { return mKey; }
 
         void setAuthor( const QString &author ) { mAuthor = author; }
         QString author() const { return mAuthor; }
@@ -334,7 +452,9 @@ class AuthorGroupItem
     private:
         AuthorGroupItem *mParent;
         Type mType;
-        QModelIndex mIndex;
+        // persistent, so that it follows the rows inserted and removed before it
+        QPersistentModelIndex mIndex;
+        AuthorGroupKey mKey;
         QList<AuthorGroupItem*> mChilds;
         QString mAuthor;
 };
@@ -352,11 +472,104 @@ class AuthorGroupProxyModel::Private
             delete mRoot;
         }
 
+        AuthorGroupKey keyForIndex( const QModelIndex &index ) const;
+        AuthorGroupItem *itemForIndex( const QModelIndex &index ) const;
+        AuthorGroupItem *createItem( AuthorGroupItem *parent, AuthorGroupItem::Type type, const QModelIndex &index = QModelIndex() );
+        void forgetItem( AuthorGroupItem *item );
+        AuthorGroupItem *authorItem( AuthorGroupItem *parent, const QString &author ) const;
+        void appendAnnotations( AuthorGroupItem *pageItem );
+        void appendAuthorGroups( AuthorGroupItem *pageItem );
+
         AuthorGroupProxyModel *mParent;
         AuthorGroupItem *mRoot;
         bool mGroupByAuthor;
+        // the items of the source indexes, by page and annotation: the hash
+        // of a QPersistentModelIndex is the one of its row when inserted
+        QHash<AuthorGroupKey, AuthorGroupItem*> mItems;
 };
 
+AuthorGroupKey AuthorGroupProxyModel::Private::keyForIndex( const QModelIndex &index ) const
+{
+    const QAbstractItemModel *model = mParent->sourceModel();
+    return qMakePair( model->data( index, AnnotationModel::PageRole ).toInt(),
+                      model->data( index, AnnotationModel::AnnotationRole ).value<Okular::Annotation*>() );
+}
+
+AuthorGroupItem *AuthorGroupProxyModel::Private::itemForIndex( const QModelIndex &index ) const
+{
+    return index.isValid() ? mItems.value( keyForIndex( index ) ) : nullptr;
+}
+
+AuthorGroupItem *AuthorGroupProxyModel::Private::createItem( AuthorGroupItem *parent, AuthorGroupItem::Type type, const QModelIndex &index )
+{
+    if ( !index.isValid() )
+        return new AuthorGroupItem( parent, type );
+
+    AuthorGroupItem *item = new AuthorGroupItem( parent, type, index, keyForIndex( index ) );
+    mItems.insert( item->key(), item );
+
+    return item;
+}
+
+void AuthorGroupProxyModel::Private::forgetItem( AuthorGroupItem *item )
+{
+    if ( item->index().isValid() )
+        mItems.remove( item->key() );
+
+    for ( int i = 0; i < item->childCount(); ++i )
+        forgetItem( item->child( i ) );
+}
+
+AuthorGroupItem *AuthorGroupProxyModel::Private::authorItem( AuthorGroupItem *parent, const QString &author ) const
+{
+    for ( int i = 0; i < parent->childCount(); ++i ) {
+        AuthorGroupItem *item = parent->child( i );
+        if ( item->type() == AuthorGroupItem::Author && item->author() == author )
+            return item;
+    }
+
+    return nullptr;
+}
+
+void AuthorGroupProxyModel::Private::appendAnnotations( AuthorGroupItem *pageItem )
+{
+    const QAbstractItemModel *model = mParent->sourceModel();
+    const QModelIndex idx = pageItem->index();
+
+    // Append all annotations as second-level
+    for ( int subRow = 0; subRow < model->rowCount( idx ); ++subRow ) {
+        const QModelIndex subIdx = model->index( subRow, 0, idx );
+        pageItem->appendChild( createItem( pageItem, AuthorGroupItem::Annotation, subIdx ) );
+    }
+}
+
+void AuthorGroupProxyModel::Private::appendAuthorGroups( AuthorGroupItem *pageItem )
+{
+    const QAbstractItemModel *model = mParent->sourceModel();
+    const QModelIndex idx = pageItem->index();
+
+    // First collect all authors...
+    QMap<QString, AuthorGroupItem*> pageAuthorMap;
+    for ( int subRow = 0; subRow < model->rowCount( idx ); ++subRow ) {
+        const QModelIndex annIdx = model->index( subRow, 0, idx );
+        const QString author = model->data( annIdx, AnnotationModel::AuthorRole ).toString();
+
+        AuthorGroupItem *authorItem = pageAuthorMap.value( author, 0 );
+        if ( !authorItem ) {
+            authorItem = createItem( pageItem, AuthorGroupItem::Author );
+            authorItem->setAuthor( author );
+
+            // Add item to tree
+            pageItem->appendChild( authorItem );
+
+            // Insert to lookup list
+            pageAuthorMap.insert( author, authorItem );
+        }
+
+        authorItem->appendChild( createItem( authorItem, AuthorGroupItem::Annotation, annIdx ) );
+    }
+}
+
 AuthorGroupProxyModel::AuthorGroupProxyModel( QObject *parent )
     : QAbstractProxyModel( parent ),
       d( new Private( this ) )
@@ -421,11 +634,11 @@ QModelIndex AuthorGroupProxyModel::mapFromSource( const QModelIndex &sourceIndex
     if ( !sourceIndex.isValid() )
         return QModelIndex();
 
-    const AuthorGroupItem *item = d->mRoot->findIndex( sourceIndex );
+    AuthorGroupItem *item = d->itemForIndex( sourceIndex );
     if ( !item )
         return QModelIndex();
 
-    return createIndex( item->row(), 0, const_cast<AuthorGroupItem*>( item ) );
+    return createIndex( item->row(), 0, item );
 }
 
 QModelIndex AuthorGroupProxyModel::mapToSource( const QModelIndex &proxyIndex ) const
@@ -443,8 +656,8 @@ void AuthorGroupProxyModel::setSourceModel( QAbstractItemModel *model )
     if ( sourceModel() ) {
         disconnect( sourceModel(), &QAbstractItemModel::layoutChanged, this, &AuthorGroupProxyModel::rebuildIndexes );
         disconnect( sourceModel(), &QAbstractItemModel::modelReset, this, &AuthorGroupProxyModel::rebuildIndexes );
-        disconnect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &AuthorGroupProxyModel::rebuildIndexes );
-        disconnect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &AuthorGroupProxyModel::rebuildIndexes );
+        disconnect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &AuthorGroupProxyModel::sourceRowsInserted );
+        disconnect( sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &AuthorGroupProxyModel::sourceRowsAboutToBeRemoved );
         disconnect( sourceModel(), &QAbstractItemModel::dataChanged, this, &AuthorGroupProxyModel::sourceDataChanged );
     }
 
@@ -452,8 +665,8 @@ void AuthorGroupProxyModel::setSourceModel( QAbstractItemModel *model )
 
     connect( sourceModel(), &QAbstractItemModel::layoutChanged, this, &AuthorGroupProxyModel::rebuildIndexes );
     connect( sourceModel(), &QAbstractItemModel::modelReset, this, &AuthorGroupProxyModel::rebuildIndexes );
-    connect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &AuthorGroupProxyModel::rebuildIndexes );
-    connect( sourceModel(), &QAbstractItemModel::rowsRemoved, this, &AuthorGroupProxyModel::rebuildIndexes );
+    connect( sourceModel(), &QAbstractItemModel::rowsInserted, this, &AuthorGroupProxyModel::sourceRowsInserted );
+    connect( sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &AuthorGroupProxyModel::sourceRowsAboutToBeRemoved );
     connect( sourceModel(), &QAbstractItemModel::dataChanged, this, &AuthorGroupProxyModel::sourceDataChanged );
 
     rebuildIndexes();
@@ -532,6 +745,7 @@ void AuthorGroupProxyModel::groupByAuthor( bool value )
 void AuthorGroupProxyModel::rebuildIndexes()
 {
     beginResetModel();
+    d->mItems.clear();
     delete d->mRoot;
     d->mRoot = new AuthorGroupItem( nullptr );
 
@@ -546,7 +760,7 @@ void AuthorGroupProxyModel::rebuildIndexes()
                 // top-levels and append the annotations
                 AuthorGroupItem *authorItem = authorMap.value( author, 0 );
                 if ( !authorItem ) {
-                    authorItem = new AuthorGroupItem( d->mRoot, AuthorGroupItem::Author );
+                    authorItem = d->createItem( d->mRoot, AuthorGroupItem::Author );
                     authorItem->setAuthor( author );
 
                     // Add item to tree
@@ -556,35 +770,13 @@ void AuthorGroupProxyModel::rebuildIndexes()
                     authorMap.insert( author, authorItem );
                 }
 
-                AuthorGroupItem *item = new AuthorGroupItem( authorItem, AuthorGroupItem::Annotation, idx );
-                authorItem->appendChild( item );
+                authorItem->appendChild( d->createItem( authorItem, AuthorGroupItem::Annotation, idx ) );
             } else {
                 // We have the pages as top-level, so we use them as top-level, append the
                 // authors for all annotations of the page, and then the annotations themself
-                AuthorGroupItem *pageItem = new AuthorGroupItem( d->mRoot, AuthorGroupItem::Page, idx );
+                AuthorGroupItem *pageItem = d->createItem( d->mRoot, AuthorGroupItem::Page, idx );
                 d->mRoot->appendChild( pageItem );
-
-                // First collect all authors...
-                QMap<QString, AuthorGroupItem*> pageAuthorMap;
-                for ( int subRow = 0; subRow < sourceModel()->rowCount( idx ); ++subRow ) {
-                    const QModelIndex annIdx = sourceModel()->index( subRow, 0, idx );
-                    const QString author = sourceModel()->data( annIdx, AnnotationModel::AuthorRole ).toString();
-
-                    AuthorGroupItem *authorItem = pageAuthorMap.value( author, 0 );
-                    if ( !authorItem ) {
-                        authorItem = new AuthorGroupItem( pageItem, AuthorGroupItem::Author );
-                        authorItem->setAuthor( author );
-
-                        // Add item to tree
-                        pageItem->appendChild( authorItem );
-
-                        // Insert to lookup list
-                        pageAuthorMap.insert( author, authorItem );
-                    }
-
-                    AuthorGroupItem *item = new AuthorGroupItem( authorItem, AuthorGroupItem::Annotation, annIdx );
-                    authorItem->appendChild( item );
-                }
+                d->appendAuthorGroups( pageItem );
             }
         }
     } else {
@@ -593,19 +785,12 @@ void AuthorGroupProxyModel::rebuildIndexes()
             const QString author = sourceModel()->data( idx, AnnotationModel::AuthorRole ).toString();
             if ( !author.isEmpty() ) {
                 // We have the annotations as top-level items
-                AuthorGroupItem *item = new AuthorGroupItem( d->mRoot, AuthorGroupItem::Annotation, idx );
-                d->mRoot->appendChild( item );
+                d->mRoot->appendChild( d->createItem( d->mRoot, AuthorGroupItem::Annotation, idx ) );
             } else {
                 // We have the pages as top-level items
-                AuthorGroupItem *pageItem = new AuthorGroupItem( d->mRoot, AuthorGroupItem::Page, idx );
+                AuthorGroupItem *pageItem = d->createItem( d->mRoot, AuthorGroupItem::Page, idx );
                 d->mRoot->appendChild( pageItem );
-
-                // Append all annotations as second-level
-                for ( int subRow = 0; subRow < sourceModel()->rowCount( idx ); ++subRow ) {
-                    const QModelIndex subIdx = sourceModel()->index( subRow, 0, idx );
-                    AuthorGroupItem *item = new AuthorGroupItem( pageItem, AuthorGroupItem::Annotation, subIdx );
-                    pageItem->appendChild( item );
-                }
+                d->appendAnnotations( pageItem );
             }
         }
     }
@@ -613,9 +798,178 @@ void AuthorGroupProxyModel::rebuildIndexes()
     endResetModel();
 }
 
+QModelIndex AuthorGroupProxyModel::indexForItem( AuthorGroupItem *item ) const
+{
+    if ( !item || item == d->mRoot )
+        return QModelIndex();
+
+    return createIndex( item->row(), 0, item );
+}
+
+void AuthorGroupProxyModel::insertIntoAuthorGroups( AuthorGroupItem *parentItem, const QModelIndex &sourceParent, int first, int last )
+{
+    // The new rows follow each other in the source model, and so they do
+    // among the annotations of each author
+    QStringList authors;
+    QHash<QString, QList<QModelIndex> > authorIndexes;
+    for ( int row = first; row <= last; ++row ) {
+        const QModelIndex idx = sourceModel()->index( row, 0, sourceParent );
+        const QString author = sourceModel()->data( idx, AnnotationModel::AuthorRole ).toString();
+        if ( !authorIndexes.contains( author ) )
+            authors.append( author );
+        authorIndexes[ author ].append( idx );
+    }
+
+    for ( const QString &author : qAsConst( authors ) ) {
+        const QList<QModelIndex> indexes = authorIndexes.value( author );
+        AuthorGroupItem *authorItem = d->authorItem( parentItem, author );
+        if ( !authorItem ) {
+            const int row = parentItem->childCount();
+            beginInsertRows( indexForItem( parentItem ), row, row );
+            authorItem = d->createItem( parentItem, AuthorGroupItem::Author );
+            authorItem->setAuthor( author );
+            for ( const QModelIndex &idx : indexes )
+                authorItem->appendChild( d->createItem( authorItem, AuthorGroupItem::Annotation, idx ) );
+            parentItem->appendChild( authorItem );
+            endInsertRows();
+        } else {
+            const int row = authorItem->insertionRow( first );
+            beginInsertRows( indexForItem( authorItem ), row, row + indexes.count() - 1 );
+            for ( int i = 0; i < indexes.count(); ++i )
+                authorItem->insertChild( row + i, d->createItem( authorItem, AuthorGroupItem::Annotation, indexes.at( i ) ) );
+            endInsertRows();
+        }
+    }
+}
+
+void AuthorGroupProxyModel::sourceRowsInserted( const QModelIndex &sourceParent, int first, int last )
+{
+    AuthorGroupItem *parentItem = sourceParent.isValid() ? d->itemForIndex( sourceParent ) : d->mRoot;
+    if ( !parentItem ) {
+        rebuildIndexes();
+        return;
+    }
+
+    if ( parentItem != d->mRoot ) {
+        // new annotations of a page
+        if ( d->mGroupByAuthor ) {
+            insertIntoAuthorGroups( parentItem, sourceParent, first, last );
+        } else {
+            beginInsertRows( indexForItem( parentItem ), first, last );
+            for ( int row = first; row <= last; ++row ) {
+                const QModelIndex idx = sourceModel()->index( row, 0, sourceParent );
+                parentItem->insertChild( row, d->createItem( parentItem, AuthorGroupItem::Annotation, idx ) );
+            }
+            endInsertRows();
+        }
+        return;
+    }
+
+    // Top-level rows with an author are annotations, the others are pages
+    int pageCount = 0;
+    for ( int row = first; row <= last; ++row ) {
+        const QModelIndex idx = sourceModel()->index( row, 0 );
+        if ( sourceModel()->data( idx, AnnotationModel::AuthorRole ).toString().isEmpty() )
+            pageCount++;
+    }
+
+    if ( d->mGroupByAuthor ) {
+        bool rootHasPages = false;
+        bool rootHasAuthors = false;
+        for ( int i = 0; i < d->mRoot->childCount(); ++i ) {
+            if ( d->mRoot->child( i )->type() == AuthorGroupItem::Page )
+                rootHasPages = true;
+            else
+                rootHasAuthors = true;
+        }
+
+        if ( pageCount == 0 && !rootHasPages ) {
+            insertIntoAuthorGroups( d->mRoot, QModelIndex(), first, last );
+            return;
+        }
+
+        // the pages are the only top-level items, in the order of the source model
+        if ( pageCount != last - first + 1 || rootHasAuthors ) {
+            rebuildIndexes();
+            return;
+        }
+    }
+
+    beginInsertRows( QModelIndex(), first, last );
+    for ( int row = first; row <= last; ++row ) {
+        const QModelIndex idx = sourceModel()->index( row, 0 );
+        if ( !sourceModel()->data( idx, AnnotationModel::AuthorRole ).toString().isEmpty() ) {
+            d->mRoot->insertChild( row, d->createItem( d->mRoot, AuthorGroupItem::Annotation, idx ) );
+        } else {
+            AuthorGroupItem *pageItem = d->createItem( d->mRoot, AuthorGroupItem::Page, idx );
+            d->mRoot->insertChild( row, pageItem );
+            if ( d->mGroupByAuthor )
+                d->appendAuthorGroups( pageItem );
+            else
+                d->appendAnnotations( pageItem );
+        }
+    }
+    endInsertRows();
+}
+
+void AuthorGroupProxyModel::sourceRowsAboutToBeRemoved( const QModelIndex &sourceParent, int first, int last )
+{
+    // Collect the rows of the items to remove for each parent item
+    QList<AuthorGroupItem*> parentItems;
+    QHash<AuthorGroupItem*, QList<int> > itemRows;
+    for ( int row = first; row <= last; ++row ) {
+        const AuthorGroupItem *item = d->itemForIndex( sourceModel()->index( row, 0, sourceParent ) );
+        if ( !item )
+            continue;
+
+        AuthorGroupItem *parentItem = item->parent();
+        if ( !itemRows.contains( parentItem ) )
+            parentItems.append( parentItem );
+        itemRows[ parentItem ].append( item->row() );
+    }
+
+    for ( AuthorGroupItem *parentItem : qAsConst( parentItems ) ) {
+        QList<int> rows = itemRows.value( parentItem );
+
+        // An author without annotations left goes away with them
+        if ( parentItem->type() == AuthorGroupItem::Author && rows.count() == parentItem->childCount() ) {
+            rows = QList<int>() << parentItem->row();
+            parentItem = parentItem->parent();
+        }
+
+        // Remove each run of adjacent rows at once, the last one first
+        std::sort( rows.begin(), rows.end() );
+        while ( !rows.isEmpty() ) {
+            const int lastRow = rows.takeLast();
+            int firstRow = lastRow;
+            while ( !rows.isEmpty() && rows.last() == firstRow - 1 )
+                firstRow = rows.takeLast();
+
+            beginRemoveRows( indexForItem( parentItem ), firstRow, lastRow );
+            for ( int row = lastRow; row >= firstRow; --row ) {
+                AuthorGroupItem *item = parentItem->takeChild( row );
+                d->forgetItem( item );
+                delete item;
+            }
+            endRemoveRows();
+        }
+    }
+}
+
 void AuthorGroupProxyModel::sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
 {
-    emit dataChanged(mapFromSource(topLeft), mapFromSource(bottomRight), roles);
+    const QModelIndex first = mapFromSource(topLeft);
+    const QModelIndex last = mapFromSource(bottomRight);
+    if ( first.parent() == last.parent() ) {
+        emit dataChanged(first, last, roles);
+        return;
+    }
+
+    // The annotations are in different author groups
+    for ( int row = topLeft.row(); row <= bottomRight.row(); ++row ) {
+        const QModelIndex idx = mapFromSource( topLeft.sibling( row, 0 ) );
+        emit dataChanged(idx, idx, roles);
+    }
 }
 
 #include "moc_annotationproxymodels.cpp"
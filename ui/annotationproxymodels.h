@@ -11,7 +11,7 @@
 #define ANNOTATIONPROXYMODEL_H
 
 #include <QSortFilterProxyModel>
-#include <QPair>
+#include <QVector>
 
 /**
  * A proxy model, which filters out all pages except the
@@ -88,13 +88,32 @@ class PageGroupProxyModel : public QAbstractProxyModel
   private Q_SLOTS:
     void rebuildIndexes();
     void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+    void sourceRowsInserted( const QModelIndex &sourceParent, int first, int last );
+    void sourceRowsAboutToBeRemoved( const QModelIndex &sourceParent, int first, int last );
+    void sourceRowsRemoved( const QModelIndex &sourceParent, int first, int last );
 
   private:
+    struct PageRows
+    {
+      int page;
+      int count;
+      // row of the first annotation of the page in the list
+      int offset;
+    };
+
+    PageRows pageRows( int sourceRow ) const;
+    int rowForPage( int page ) const;
+    int rowForOffset( int row ) const;
+    void updateOffsets( int from );
+
     bool mGroupByPage;
-    QList<QModelIndex> mIndexes;
-    QList<QPair< QModelIndex, QList<QModelIndex> > > mTreeIndexes;
+    // the pages of the source model, in the same order
+    QVector<PageRows> mPages;
+    bool mRemovingRows;
 };
 
+class AuthorGroupItem;
+
 /**
  * A proxy model which groups the annotations by author.
  */
@@ -138,8 +157,13 @@ class AuthorGroupProxyModel : public QAbstractProxyModel
     private Q_SLOTS:
         void rebuildIndexes();
         void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+        void sourceRowsInserted( const QModelIndex &sourceParent, int first, int last );
+        void sourceRowsAboutToBeRemoved( const QModelIndex &sourceParent, int first, int last );
 
     private:
+        QModelIndex indexForItem( AuthorGroupItem *item ) const;
+        void insertIntoAuthorGroups( AuthorGroupItem *parentItem, const QModelIndex &sourceParent, int first, int last );
+
         class Private;
         Private* const d;
 };
@@ -13,7 +13,9 @@
 #include <qcolor.h>
 #include <qcursor.h>
 #include <qevent.h>
+#include <qmath.h>
 #include <qpainter.h>
+#include <qvector.h>
 
 // local includes
 #include "core/annotations.h"
@@ -89,7 +91,8 @@ SmoothPath::SmoothPath( const QLinkedList<Okular::NormalizedPoint> &points, cons
 
 /** SmoothPathEngine */
 SmoothPathEngine::SmoothPathEngine( const QDomElement & engineElement )
-    : AnnotatorEngine( engineElement ), compositionMode( QPainter::CompositionMode_SourceOver )
+    : AnnotatorEngine( engineElement ), compositionMode( QPainter::CompositionMode_SourceOver ),
+      lastXScale( 1.0 ), lastYScale( 1.0 ), overlayXScale( 0.0 ), overlayYScale( 0.0 )
 {
     // parse engine specific attributes
     if ( engineElement.attribute( QStringLiteral("compositionMode"), QStringLiteral("sourceOver") ) == QLatin1String("clear") )
@@ -102,9 +105,13 @@ QRect SmoothPathEngine::event( EventType type, Button button, double nX, double
     if ( button != Left )
         return QRect();
 
+    lastXScale = xScale;
+    lastYScale = yScale;
+
     // start operation
     if ( type == Press && points.isEmpty() )
     {
+        overlay = QImage();
         lastPoint.x = nX;
         lastPoint.y = nY;
         totalRect.left = totalRect.right = lastPoint.x;
@@ -141,7 +148,10 @@ QRect SmoothPathEngine::event( EventType type, Button button, double nX, double
     else if ( type == Release && points.count() > 0 )
     {
         if ( points.count() < 2 )
+        {
             points.clear();
+            overlay = QImage();
+        }
         else
             m_creationCompleted = true;
         return totalRect.geometry( (int)xScale, (int)yScale );
@@ -154,11 +164,74 @@ void SmoothPathEngine::paint( QPainter * painter, double xScale, double yScale,
     const double penWidth = m_annotElement.attribute( QStringLiteral("width"), QStringLiteral("1") ).toInt();
     const qreal opacity = m_annotElement.attribute( QStringLiteral("opacity"), QStringLiteral("1.0") ).toDouble();
 
-    // use engine's color for painting
-    const SmoothPath path( points, QPen( m_engineColor, penWidth ), opacity, compositionMode );
+    // erasing works on what is below the path, draw it as a whole
+    if ( compositionMode != QPainter::CompositionMode_SourceOver || points.count() < 2 )
+    {
+        // use engine's color for painting
+        const SmoothPath path( points, QPen( m_engineColor, penWidth ), opacity, compositionMode );
+
+        // draw the path
+        path.paint( painter, xScale, yScale );
+        return;
+    }
+
+    // the overlay is in device pixels, start over if the zoom changed
+    const qreal dpr = qMax( painter->deviceTransform().m11(), qreal(1.0) );
+    if ( overlay.isNull() || xScale != overlayXScale || yScale != overlayYScale || dpr != overlay.devicePixelRatioF() )
+    {
+        overlay = QImage();
+        overlayRect = QRect();
+        overlayXScale = xScale;
+        overlayYScale = yScale;
+        lastRasterizedPoint = points.constBegin();
+    }
+
+    // grow the overlay to the path, with room for the next points
+    const int penMargin = qCeil( penWidth ) + 1;
+    const QRect pathRect = totalRect.geometry( (int)xScale, (int)yScale ).adjusted( -penMargin, -penMargin, penMargin, penMargin );
+    if ( !overlayRect.contains( pathRect ) )
+    {
+        const int growMargin = 128;
+        const QRect rect = pathRect.united( overlayRect ).adjusted( -growMargin, -growMargin, growMargin, growMargin );
+        QImage image( QSize( qCeil( rect.width() * dpr ), qCeil( rect.height() * dpr ) ), QImage::Format_ARGB32_Premultiplied );
+        image.setDevicePixelRatio( dpr );
+        image.fill( Qt::transparent );
+        if ( !overlay.isNull() )
+        {
+            QPainter imagePainter( &image );
+            imagePainter.setCompositionMode( QPainter::CompositionMode_Source );
+            imagePainter.drawImage( overlayRect.topLeft() - rect.topLeft(), overlay );
+        }
+        overlay = image;
+        overlayRect = rect;
+    }
+
+    // stroke the new segments with the caps and joins of the finished ink
+    // annotation, opaque: the opacity applies to the path as a whole when
+    // compositing the overlay. The last segment already there is stroked
+    // again, so that it is joined to the new ones as in the whole path.
+    QLinkedList<Okular::NormalizedPoint>::const_iterator pIt = lastRasterizedPoint, pEnd = points.constEnd();
+    if ( pIt + 1 != pEnd )
+    {
+        if ( pIt != points.constBegin() )
+            --pIt;
+        QPolygonF polyline;
+        for ( ; pIt != pEnd; ++pIt )
+        {
+            polyline.append( QPointF( pIt->x * xScale, pIt->y * yScale ) );
+            lastRasterizedPoint = pIt;
+        }
+
+        QPainter overlayPainter( &overlay );
+        overlayPainter.setRenderHints( painter->renderHints() );
+        overlayPainter.translate( -overlayRect.topLeft() );
+        overlayPainter.setPen( QPen( m_engineColor, penWidth, Qt::SolidLine, Qt::SquareCap, Qt::MiterJoin ) );
+        overlayPainter.drawPolyline( polyline );
+    }
 
-    // draw the path
-    path.paint( painter, xScale, yScale );
+    painter->setCompositionMode( QPainter::CompositionMode_SourceOver );
+    painter->setOpacity( opacity );
+    painter->drawImage( QRectF( overlayRect ), overlay );
 }
 
 void SmoothPath::paint( QPainter * painter, double xScale, double yScale ) const
@@ -203,7 +276,7 @@ QList< Okular::Annotation* > SmoothPathEngine::end()
             ann->style().setWidth( m_annotElement.attribute( QStringLiteral("width") ).toDouble() );
         // fill points
         QList< QLinkedList<Okular::NormalizedPoint> > list = ia->inkPaths();
-        list.append( points );
+        list.append( simplifiedPoints() );
         ia->setInkPaths( list );
         // set boundaries
         ia->setBoundingRectangle( totalRect );
@@ -233,7 +306,72 @@ SmoothPath SmoothPathEngine::endSmoothPath()
     const int width = m_annotElement.attribute( QStringLiteral("width"), QStringLiteral("2") ).toInt();
     const qreal opacity = m_annotElement.attribute( QStringLiteral("opacity"), QStringLiteral("1.0") ).toDouble();
 
-    return SmoothPath( points, QPen(color, width), opacity, compositionMode );
+    return SmoothPath( simplifiedPoints(), QPen(color, width), opacity, compositionMode );
+}
+
+// distance of p from the segment from a to b
+static double segmentDistance( const QPointF &p, const QPointF &a, const QPointF &b )
+{
+    const QPointF ab = b - a;
+    const double length2 = QPointF::dotProduct( ab, ab );
+    const double t = length2 > 0 ? qBound( 0.0, QPointF::dotProduct( p - a, ab ) / length2, 1.0 ) : 0.0;
+    const QPointF d = p - ( a + t * ab );
+    return hypot( d.x(), d.y() );
+}
+
+QLinkedList<Okular::NormalizedPoint> SmoothPathEngine::simplifiedPoints() const
+{
+    if ( points.count() < 3 )
+        return points;
+
+    // Douglas-Peucker in the pixels of the zoom the path was drawn at: the
+    // mouse and tablet report many points along straight strokes, and the
+    // ones that don't move the path by half a pixel are not worth saving
+    const double tolerance = 0.5;
+
+    QVector<QPointF> path;
+    path.reserve( points.count() );
+    for ( const Okular::NormalizedPoint &point : points )
+        path.append( QPointF( point.x * lastXScale, point.y * lastYScale ) );
+
+    QVector<bool> keep( path.count(), false );
+    keep.first() = true;
+    keep.last() = true;
+
+    QVector< QPair<int, int> > ranges;
+    ranges.append( qMakePair( 0, path.count() - 1 ) );
+    while ( !ranges.isEmpty() )
+    {
+        const QPair<int, int> range = ranges.takeLast();
+
+        int farthest = -1;
+        double maxDistance = tolerance;
+        for ( int i = range.first + 1; i < range.second; ++i )
+        {
+            const double distance = segmentDistance( path[ i ], path[ range.first ], path[ range.second ] );
+            if ( distance > maxDistance )
+            {
+                farthest = i;
+                maxDistance = distance;
+            }
+        }
+
+        if ( farthest != -1 )
+        {
+            keep[ farthest ] = true;
+            ranges.append( qMakePair( range.first, farthest ) );
+            ranges.append( qMakePair( farthest, range.second ) );
+        }
+    }
+
+    QLinkedList<Okular::NormalizedPoint> simplified;
+    int i = 0;
+    for ( const Okular::NormalizedPoint &point : points )
+    {
+        if ( keep[ i++ ] )
+            simplified.append( point );
+    }
+    return simplified;
 }
 
 /* kate: replace-tabs on; indent-width 4; */
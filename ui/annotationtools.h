@@ -11,6 +11,7 @@
 #define _OKULAR_ANNOTATIONTOOLS_H_
 
 #include <qdom.h>
+#include <qimage.h>
 #include <qlinkedlist.h>
 #include <qpainter.h>
 #include <qpen.h>
@@ -98,11 +99,24 @@ class SmoothPathEngine
         SmoothPath endSmoothPath();
 
     private:
+        QLinkedList<Okular::NormalizedPoint> simplifiedPoints() const;
+
         // data
         QLinkedList<Okular::NormalizedPoint> points;
         Okular::NormalizedRect totalRect;
         Okular::NormalizedPoint lastPoint;
         QPainter::CompositionMode compositionMode;
+        // scale of the last event, the points are simplified to a fraction
+        // of pixel at the zoom the path was drawn
+        double lastXScale;
+        double lastYScale;
+        // the path rasterized so far: every paint only strokes the segments
+        // added since the previous one
+        QImage overlay;
+        QRect overlayRect;
+        double overlayXScale;
+        double overlayYScale;
+        QLinkedList<Okular::NormalizedPoint>::const_iterator lastRasterizedPoint;
 };
 
 #endif
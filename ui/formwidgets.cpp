@@ -31,6 +31,7 @@
 #include "core/action.h"
 #include "core/form.h"
 #include "core/document.h"
+#include "core/page.h"
 #include "debug_ui.h"
 
 FormWidgetsController::FormWidgetsController( Okular::Document *doc )
@@ -61,7 +62,7 @@ FormWidgetsController::FormWidgetsController( Okular::Document *doc )
              this, &FormWidgetsController::formComboChangedByUndoRedo );
 
     connect( this, &FormWidgetsController::formButtonsChangedByWidget,
-             doc, &Okular::Document::editFormButtons );
+             doc, &Okular::Document::editFormButtonsOnPages );
     connect( doc, &Okular::Document::formButtonsChangedByUndoRedo,
              this, &FormWidgetsController::slotFormButtonsChangedByUndoRedo );
 
@@ -169,6 +170,7 @@ void FormWidgetsController::dropRadioButtons()
     }
     m_radios.clear();
     m_buttons.clear();
+    m_formButtons.clear();
 }
 
 bool FormWidgetsController::canUndo()
@@ -212,16 +214,42 @@ void FormWidgetsController::slotButtonClicked( QAbstractButton *button )
     QList< bool > checked;
     QList< bool > prevChecked;
     QList< Okular::FormFieldButton*> formButtons;
+    QList< int > buttonPageNumbers;
 
     for ( QAbstractButton* button : buttons )
     {
         checked.append( button->isChecked() );
-        Okular::FormFieldButton *formButton = static_cast<Okular::FormFieldButton *>( dynamic_cast<FormWidgetIface*>(button)->formField() );
+        FormWidgetIface *widget = dynamic_cast<FormWidgetIface*>(button);
+        Okular::FormFieldButton *formButton = static_cast<Okular::FormFieldButton *>( widget->formField() );
         formButtons.append( formButton );
         prevChecked.append( formButton->state() );
+        buttonPageNumbers.append( widget->pageItem()->pageNumber() );
+    }
+
+    // radio buttons of the group on pages away from the viewport have no
+    // widget, their fields still have to be unchecked
+    if ( button->group()->exclusive() && button->isChecked() )
+    {
+        const Okular::FormFieldButton *clicked = static_cast<Okular::FormFieldButton *>( dynamic_cast<FormWidgetIface*>(button)->formField() );
+        const QList< int > siblings = clicked->siblings();
+        for ( int id : siblings )
+        {
+            if ( m_buttons.value( id ) )
+                continue;
+
+            int siblingPageNumber = -1;
+            Okular::FormFieldButton *sibling = findFormButton( id, &siblingPageNumber );
+            if ( sibling && sibling->state() )
+            {
+                checked.append( false );
+                formButtons.append( sibling );
+                prevChecked.append( true );
+                buttonPageNumbers.append( siblingPageNumber );
+            }
+        }
     }
     if (checked != prevChecked)
-        emit formButtonsChangedByWidget( pageNumber, formButtons, checked );
+        emit formButtonsChangedByWidget( pageNumber, buttonPageNumbers, formButtons, checked );
     if ( check )
     {
         // The formButtonsChangedByWidget signal changes the value of the underlying
@@ -231,12 +259,35 @@ void FormWidgetsController::slotButtonClicked( QAbstractButton *button )
     }
 }
 
+Okular::FormFieldButton *FormWidgetsController::findFormButton( int id, int *pageNumber )
+{
+    if ( m_formButtons.isEmpty() )
+    {
+        for ( uint i = 0; i < m_doc->pages(); ++i )
+        {
+            const QLinkedList< Okular::FormField * > fields = m_doc->page( i )->formFields();
+            for ( Okular::FormField *field : fields )
+            {
+                if ( field->type() == Okular::FormField::FormButton )
+                    m_formButtons.insert( field->id(), qMakePair( static_cast< Okular::FormFieldButton * >( field ), int( i ) ) );
+            }
+        }
+    }
+
+    const QPair< Okular::FormFieldButton *, int > formButton = m_formButtons.value( id, qMakePair( static_cast< Okular::FormFieldButton * >( nullptr ), -1 ) );
+    *pageNumber = formButton.second;
+    return formButton.first;
+}
+
 void FormWidgetsController::slotFormButtonsChangedByUndoRedo( int pageNumber, const QList< Okular::FormFieldButton* > & formButtons)
 {
     for ( const Okular::FormFieldButton* formButton : formButtons )
     {
         int id = formButton->id();
-        QAbstractButton* button = m_buttons[id];
+        QAbstractButton* button = m_buttons.value( id );
+        // no widget for the page, it will show the new state when created
+        if ( !button )
+            continue;
         CheckBoxEdit *check = qobject_cast< CheckBoxEdit * >( button );
         if ( check )
         {
@@ -327,6 +378,30 @@ FormWidgetIface * FormWidgetFactory::createWidget( Okular::FormField * ff, QWidg
 }
 
 
+bool FormWidgetFactory::hasWidget( const Okular::FormField * ff )
+{
+    switch ( ff->type() )
+    {
+        case Okular::FormField::FormButton:
+        {
+            const Okular::FormFieldButton::ButtonType buttonType = static_cast< const Okular::FormFieldButton * >( ff )->buttonType();
+            return buttonType == Okular::FormFieldButton::Push || buttonType == Okular::FormFieldButton::CheckBox ||
+                   buttonType == Okular::FormFieldButton::Radio;
+        }
+        case Okular::FormField::FormText:
+        case Okular::FormField::FormChoice:
+            return true;
+        case Okular::FormField::FormSignature:
+        {
+            const Okular::FormFieldSignature * ffs = static_cast< const Okular::FormFieldSignature * >( ff );
+            return ffs->isVisible() && ffs->signatureType() != Okular::FormFieldSignature::UnknownType;
+        }
+        default: ;
+    }
+    return false;
+}
+
+
 FormWidgetIface::FormWidgetIface( QWidget * w, Okular::FormField * ff )
     : m_controller( nullptr ), m_ff( ff ), m_widget( w ), m_pageItem( nullptr )
 {
@@ -20,6 +20,7 @@
 #include <qcombobox.h>
 #include <qlineedit.h>
 #include <qlistwidget.h>
+#include <qpointer.h>
 #include <qpushbutton.h>
 #include <qradiobutton.h>
 #include <ktextedit.h>
@@ -113,6 +114,7 @@ class FormWidgetsController : public QObject
                                        );
 
         void formButtonsChangedByWidget( int pageNumber,
+                                         const QList< int > & buttonPageNumbers,
                                          const QList< Okular::FormFieldButton* > & formButtons,
                                          const QList< bool > & newButtonStates );
 
@@ -135,6 +137,8 @@ class FormWidgetsController : public QObject
                                                const QList< Okular::FormFieldButton* > & formButtons );
 
     private:
+        Okular::FormFieldButton *findFormButton( int id, int *pageNumber );
+
         friend class TextAreaEdit;
         friend class FormLineEdit;
         friend class FileEdit;
@@ -143,7 +147,11 @@ class FormWidgetsController : public QObject
         friend class SignatureEdit;
 
         QList< RadioData > m_radios;
-        QHash< int, QAbstractButton* > m_buttons;
+        // the widgets of the pages away from the viewport are deleted
+        QHash< int, QPointer< QAbstractButton > > m_buttons;
+        // the button fields of the document and their pages by id, built
+        // on the first lookup
+        QHash< int, QPair< Okular::FormFieldButton *, int > > m_formButtons;
         Okular::Document* m_doc;
 };
 
@@ -152,6 +160,9 @@ class FormWidgetFactory
 {
     public:
         static FormWidgetIface * createWidget( Okular::FormField * ff, QWidget * parent = nullptr );
+
+        // whether createWidget() creates a widget for the field
+        static bool hasWidget( const Okular::FormField * ff );
 };
 
 
@@ -132,6 +132,9 @@ void KTreeViewSearchLine::Private::slotRegularExpression()
 bool KTreeViewSearchLine::Private::checkItemParentsVisible( QTreeView *treeView, const QModelIndex &index )
 {
   bool childMatch = false;
+  // look into the children of lazily populated models too
+  if ( !search.isEmpty() && treeView->model()->canFetchMore( index ) )
+    treeView->model()->fetchMore( index );
   const int rowcount = treeView->model()->rowCount( index );
   for ( int i = 0; i < rowcount; ++i )
     childMatch |= checkItemParentsVisible( treeView, treeView->model()->index( i, 0, index ) );
@@ -10,6 +10,7 @@
 #include "pagepainter.h"
 
 // qt / kde includes
+#include <qcache.h>
 #include <qrect.h>
 #include <qpainter.h>
 #include <qpalette.h>
@@ -53,6 +54,19 @@ inline QPen buildPen( const Okular::Annotation *ann, double width, const QColor
     return p;
 }
 
+// The ink annotations of the recently painted pages, rasterized over the
+// whole cropped page: stroking long ink paths is slow, and a page is painted
+// again piece by piece on every scroll step and on every stroke being drawn.
+// A page has a layer for every size it is painted at (e.g. in the view and
+// in the thumbnails), in device pixels. The cost is in KiB.
+struct InkLayer
+{
+    uint key;
+    QImage image;
+};
+typedef QCache< QPair< const Okular::Page *, QPair< int, int > >, InkLayer > InkLayerCache;
+Q_GLOBAL_STATIC_WITH_ARGS( InkLayerCache, inkLayerCache, ( 64 * 1024 ) )
+
 void PagePainter::paintPageOnPainter( QPainter * destPainter, const Okular::Page * page,
     Okular::DocumentObserver *observer, int flags, int scaledWidth, int scaledHeight, const QRect &limits )
 {
@@ -435,6 +449,11 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
                    yOffset = (double)limits.top() / (double)scaledHeight + crop.top,
                    yScale = (double)scaledHeight / (double)limits.height();
 
+            // the ink annotations are blitted at once from the cached layer
+            // of the page, in place of the first one
+            const QImage * inks = nullptr;
+            bool inkLayerChecked = false;
+
             // paint all buffered annotations in the page
             QList< Okular::Annotation * >::const_iterator aIt = bufferedAnnotations->constBegin(), aEnd = bufferedAnnotations->constEnd();
             for ( ; aIt != aEnd; ++aIt )
@@ -516,33 +535,18 @@ void PagePainter::paintCroppedPageOnPainter( QPainter * destPainter, const Okula
                 // draw InkAnnotation MISSING:invar width, PENTRACER
                 else if ( type == Okular::Annotation::AInk )
                 {
-                    // get the annotation
-                    Okular::InkAnnotation * ia = (Okular::InkAnnotation *) a;
-
-                    // draw each ink path
-                    const QList< QLinkedList<Okular::NormalizedPoint> > transformedInkPaths = ia->transformedInkPaths();
-
-                    const QPen inkPen = buildPen( a, a->style().width(), acolor );
-
-                    int paths = transformedInkPaths.size();
-                    for ( int p = 0; p < paths; p++ )
+                    if ( !inkLayerChecked )
                     {
-                        NormalizedPath path;
-                        const QLinkedList<Okular::NormalizedPoint> & inkPath = transformedInkPaths[ p ];
-
-                        // normalize page point to image
-                        QLinkedList<Okular::NormalizedPoint>::const_iterator pIt = inkPath.constBegin(), pEnd = inkPath.constEnd();
-                        for ( ; pIt != pEnd; ++pIt )
+                        inkLayerChecked = true;
+                        inks = inkLayer( page, scaledWidth, scaledHeight, crop, dpr );
+                        if ( inks )
                         {
-                            const Okular::NormalizedPoint & inkPoint = *pIt;
-                            Okular::NormalizedPoint point;
-                            point.x = (inkPoint.x - xOffset) * xScale;
-                            point.y = (inkPoint.y - yOffset) * yScale;
-                            path.append( point );
+                            QPainter painter( &backImage );
+                            painter.drawImage( QRectF( 0, 0, dLimits.width() / dpr, dLimits.height() / dpr ), *inks, dLimits );
                         }
-                        // draw the normalized path into image
-                        drawShapeOnImage( backImage, path, false, inkPen, QBrush(), pageScale );
                     }
+                    if ( !inks )
+                        drawInkOnImage( backImage, (Okular::InkAnnotation *) a, acolor, xOffset, xScale, yOffset, yScale, pageScale );
                 }
             } // end current annotation drawing
         }
@@ -871,6 +875,119 @@ void PagePainter::changeImageAlpha( QImage & image, unsigned int destAlpha )
     }
 }
 
+void PagePainter::drawInkOnImage( QImage & image, const Okular::InkAnnotation * ia, const QColor & color,
+    double xOffset, double xScale, double yOffset, double yScale, double pageScale )
+{
+    // draw each ink path
+    const QList< QLinkedList<Okular::NormalizedPoint> > transformedInkPaths = ia->transformedInkPaths();
+
+    const QPen inkPen = buildPen( ia, ia->style().width(), color );
+
+    int paths = transformedInkPaths.size();
+    for ( int p = 0; p < paths; p++ )
+    {
+        NormalizedPath path;
+        const QLinkedList<Okular::NormalizedPoint> & inkPath = transformedInkPaths[ p ];
+
+        // normalize page point to image
+        QLinkedList<Okular::NormalizedPoint>::const_iterator pIt = inkPath.constBegin(), pEnd = inkPath.constEnd();
+        for ( ; pIt != pEnd; ++pIt )
+        {
+            const Okular::NormalizedPoint & inkPoint = *pIt;
+            Okular::NormalizedPoint point;
+            point.x = (inkPoint.x - xOffset) * xScale;
+            point.y = (inkPoint.y - yOffset) * yScale;
+            path.append( point );
+        }
+        // draw the normalized path into image
+        drawShapeOnImage( image, path, false, inkPen, QBrush(), pageScale );
+    }
+}
+
+const QImage * PagePainter::inkLayer( const Okular::Page * page, int scaledWidth, int scaledHeight,
+    const Okular::NormalizedRect & crop, qreal dpr )
+{
+    const int dScaledWidth = ceil( scaledWidth * dpr );
+    const int dScaledHeight = ceil( scaledHeight * dpr );
+    const QRect scaledCrop = crop.geometry( scaledWidth, scaledHeight );
+    const QRect dScaledCrop = QRectF( scaledCrop.x() * dpr, scaledCrop.y() * dpr, scaledCrop.width() * dpr, scaledCrop.height() * dpr ).toAlignedRect();
+    const qint64 cost = qMax( (qint64)dScaledCrop.width() * dScaledCrop.height() * 4 / 1024, (qint64)1 );
+    if ( dScaledCrop.isEmpty() || cost > inkLayerCache()->maxCost() )
+        return nullptr;
+
+    // the layer is valid as long as the crop and the look of the ink
+    // annotations of the page do not change
+    QList< const Okular::InkAnnotation * > inkAnnotations;
+    bool otherAfterInks = false;
+    uint key = qHash( crop.left );
+    key = qHash( crop.top, key );
+    key = qHash( crop.right, key );
+    key = qHash( crop.bottom, key );
+    for ( const Okular::Annotation * ann : page->m_annotations )
+    {
+        if ( ann->flags() & ( Okular::Annotation::Hidden | Okular::Annotation::ExternallyDrawn ) )
+            continue;
+
+        // the layer takes the place of the first ink annotation, so the
+        // other composited annotations must not be drawn between two inks
+        const Okular::Annotation::SubType type = ann->subType();
+        if ( type == Okular::Annotation::ALine || type == Okular::Annotation::AHighlight )
+        {
+            otherAfterInks = !inkAnnotations.isEmpty();
+            continue;
+        }
+        if ( type != Okular::Annotation::AInk )
+            continue;
+        if ( otherAfterInks )
+            return nullptr;
+
+        const Okular::NormalizedRect rect = ann->transformedBoundingRectangle();
+        key = qHash( ann, key );
+        key = qHash( rect.left, key );
+        key = qHash( rect.top, key );
+        key = qHash( rect.right, key );
+        key = qHash( rect.bottom, key );
+        key = qHash( ann->style().color().rgba(), key );
+        key = qHash( ann->style().opacity(), key );
+        key = qHash( ann->style().width(), key );
+        key = qHash( (int)ann->style().lineStyle(), key );
+        key = qHash( static_cast< const Okular::InkAnnotation * >( ann )->inkPaths().count(), key );
+        inkAnnotations.append( static_cast< const Okular::InkAnnotation * >( ann ) );
+    }
+
+    const QPair< const Okular::Page *, QPair< int, int > > cacheKey( page, qMakePair( dScaledWidth, dScaledHeight ) );
+    InkLayer * layer = inkLayerCache()->object( cacheKey );
+    if ( layer && layer->key == key )
+        return &layer->image;
+
+    layer = new InkLayer;
+    layer->key = key;
+    layer->image = QImage( dScaledCrop.size(), QImage::Format_ARGB32_Premultiplied );
+    layer->image.setDevicePixelRatio( dpr );
+    layer->image.fill( Qt::transparent );
+
+    // the same geometry as when the annotations are drawn one by one
+    const double pageScale = (double)scaledCrop.width() / page->width();
+    const double xScale = (double)scaledWidth / scaledCrop.width(),
+                 yScale = (double)scaledHeight / scaledCrop.height();
+    for ( const Okular::InkAnnotation * ia : qAsConst( inkAnnotations ) )
+    {
+        QColor acolor = ia->style().color();
+        if ( !acolor.isValid() )
+            acolor = Qt::yellow;
+        acolor.setAlphaF( ia->style().opacity() );
+        drawInkOnImage( layer->image, ia, acolor, crop.left, xScale, crop.top, yScale, pageScale );
+    }
+
+    inkLayerCache()->insert( cacheKey, layer, cost );
+    return &layer->image;
+}
+
+void PagePainter::clearInkLayers()
+{
+    inkLayerCache()->clear();
+}
+
 void PagePainter::drawShapeOnImage(
     QImage & image,
     const NormalizedPath & normPath,
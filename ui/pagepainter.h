@@ -53,6 +53,10 @@ class Q_DECL_EXPORT PagePainter
             int flags, int scaledWidth, int scaledHeight, const QRect & pageLimits,
             const Okular::NormalizedRect & crop, Okular::NormalizedPoint *viewPortPoint );
 
+        // forget the cached ink annotations of the pages, e.g. because
+        // they are going away
+        static void clearInkLayers();
+
     private:
         static void cropPixmapOnImage( QImage & dest, const QPixmap * src, const QRect & r );
         static void recolor(QImage *image, const QColor &foreground, const QColor &background);
@@ -63,6 +67,13 @@ class Q_DECL_EXPORT PagePainter
         // my pretty dear raster function
         typedef QList< Okular::NormalizedPoint > NormalizedPath;
         enum RasterOperation { Normal, Multiply };
+        static void drawInkOnImage( QImage & image, const Okular::InkAnnotation * ia, const QColor & color,
+            double xOffset, double xScale, double yOffset, double yScale, double pageScale );
+        // the ink annotations of 'page' rasterized over the cropped page in
+        // device pixels, or nullptr if the layer would not fit in the cache or
+        // if other composited annotations are drawn between them
+        static const QImage * inkLayer( const Okular::Page * page, int scaledWidth, int scaledHeight,
+            const Okular::NormalizedRect & crop, qreal dpr );
         static void drawShapeOnImage(
             QImage & image,
             const NormalizedPath & normPath,
@@ -61,6 +61,7 @@
 #include <krun.h>
 
 // system includes
+#include <algorithm>
 #include <math.h>
 #include <stdlib.h>
 
@@ -129,6 +130,28 @@ TableSelectionPart::TableSelectionPart(  PageViewItem * item_p, const Okular::No
 {
 }
 
+// what is compared to tell whether the pixmap requests changed
+struct PixmapRequestKey {
+    int pageNumber;
+    int width;
+    int height;
+    Okular::NormalizedRect rect;
+    bool tile;
+    bool preload;
+
+    explicit PixmapRequestKey( const Okular::PixmapRequest *request )
+        : pageNumber( request->pageNumber() ), width( request->width() ), height( request->height() ),
+          rect( request->normalizedRect() ), tile( request->isTile() ), preload( request->preload() )
+    {
+    }
+
+    bool operator==( const PixmapRequestKey &other ) const
+    {
+        return pageNumber == other.pageNumber && width == other.width && height == other.height &&
+               rect == other.rect && tile == other.tile && preload == other.preload;
+    }
+};
+
 // structure used internally by PageView for data storage
 class PageViewPrivate
 {
@@ -148,6 +171,21 @@ public:
     QLinkedList< PageViewItem * > visibleItems;
     MagnifierView *magnifierView;
 
+    // the shown items in layout order, with the top of their row and the
+    // lowest bottom of the items up to them: both grow along the list, so
+    // the items intersecting an area are found by binary search
+    QVector< PageViewItem * > layoutItems;
+    QVector< int > layoutRowTops;
+    QVector< int > layoutMaxBottoms;
+    void layoutItemRange( const QRect &rect, int *first, int *last ) const;
+    // the items having form widgets and video widgets, which follow the
+    // viewport when scrolling
+    QSet< PageViewItem * > formWidgetItems;
+    QSet< PageViewItem * > videoWidgetItems;
+    // the pixmap requests of the visible and preloaded items sent and not
+    // answered yet, by page: they are not sent again while they do not change
+    QHash< int, PixmapRequestKey > pendingPixmapRequests;
+
     // view layout (columns and continuous in Settings), zoom and mouse
     PageView::ZoomMode zoomMode;
     float zoomFactor;
@@ -254,6 +292,12 @@ public:
     QScroller * scroller;
 };
 
+void PageViewPrivate::layoutItemRange( const QRect &rect, int *first, int *last ) const
+{
+    *first = std::lower_bound( layoutMaxBottoms.constBegin(), layoutMaxBottoms.constEnd(), rect.top() ) - layoutMaxBottoms.constBegin();
+    *last = std::upper_bound( layoutRowTops.constBegin(), layoutRowTops.constEnd(), rect.bottom() ) - layoutRowTops.constBegin();
+}
+
 PageViewPrivate::PageViewPrivate( PageView *qq )
     : q( qq )
 #ifdef HAVE_SPEECH
@@ -997,6 +1041,42 @@ void PageView::selectAll()
     }
 }
 
+void PageView::createFormWidgets( PageViewItem *item )
+{
+    if ( item->hasFormWidgetsCreated() )
+        return;
+
+    item->setFormWidgetsCreated();
+    d->formWidgetItems.insert( item );
+
+    const bool allowfillforms = d->document->isAllowed( Okular::AllowFillForms );
+    const QRect viewportRect( horizontalScrollBar()->value(), verticalScrollBar()->value(),
+                              viewport()->width(), viewport()->height() );
+    const QLinkedList< Okular::FormField * > pageFields = item->page()->formFields();
+    for ( Okular::FormField * ff : pageFields )
+    {
+        FormWidgetIface * w = FormWidgetFactory::createWidget( ff, viewport() );
+        if ( !w )
+            continue;
+
+        w->setPageItem( item );
+        w->setFormWidgetsController( d->formWidgetsController() );
+        w->setVisibility( false );
+        w->setCanBeFilled( allowfillforms );
+
+        const Okular::NormalizedRect r = w->rect();
+        w->setWidthHeight(
+            qRound( fabs( r.right - r.left ) * item->uncroppedWidth() ),
+            qRound( fabs( r.bottom - r.top ) * item->uncroppedHeight() ) );
+        w->moveTo(
+            qRound( item->uncroppedGeometry().left() + item->uncroppedWidth() * r.left ) + 1 - viewportRect.left(),
+            qRound( item->uncroppedGeometry().top() + item->uncroppedHeight() * r.top ) + 1 - viewportRect.top() );
+        item->formWidgets().insert( w );
+    }
+
+    item->setFormWidgetsVisible( d->m_formsVisible );
+}
+
 void PageView::createAnnotationsVideoWidgets(PageViewItem *item, const QLinkedList< Okular::Annotation * > &annotations)
 {
     qDeleteAll( item->videoWidgets() );
@@ -1030,12 +1110,20 @@ void PageView::createAnnotationsVideoWidgets(PageViewItem *item, const QLinkedLi
             }
         }
     }
+
+    if ( item->videoWidgets().isEmpty() )
+        d->videoWidgetItems.remove( item );
+    else
+        d->videoWidgetItems.insert( item );
 }
 
 //BEGIN DocumentObserver inherited methods
 void PageView::notifySetup( const QVector< Okular::Page * > & pageSet, int setupFlags )
 {
     bool documentChanged = setupFlags & Okular::DocumentObserver::DocumentChanged;
+    // the cached ink layers are keyed by the pages going away
+    if ( documentChanged )
+        PagePainter::clearInkLayers();
     const bool allownotes = d->document->isAllowed( Okular::AllowNotes );
     const bool allowfillforms = d->document->isAllowed( Okular::AllowFillForms );
 
@@ -1132,6 +1220,12 @@ void PageView::notifySetup( const QVector< Okular::Page * > & pageSet, int setup
     qDeleteAll( d->items );
     d->items.clear();
     d->visibleItems.clear();
+    d->layoutItems.clear();
+    d->layoutRowTops.clear();
+    d->layoutMaxBottoms.clear();
+    d->formWidgetItems.clear();
+    d->videoWidgetItems.clear();
+    d->pendingPixmapRequests.clear();
     d->pagesWithTextSelection.clear();
     toggleFormWidgets( false );
     if ( d->formsWidgetController )
@@ -1147,19 +1241,11 @@ void PageView::notifySetup( const QVector< Okular::Page * > & pageSet, int setup
 #ifdef PAGEVIEW_DEBUG
         qCDebug(OkularUiDebug).nospace() << "cropped geom for " << d->items.last()->pageNumber() << " is " << d->items.last()->croppedGeometry();
 #endif
-        const QLinkedList< Okular::FormField * > pageFields = page->formFields();
-        for ( Okular::FormField * ff : pageFields )
+        // the form widgets are created once the page gets close to the viewport
+        if ( !hasformwidgets )
         {
-            FormWidgetIface * w = FormWidgetFactory::createWidget( ff, viewport() );
-            if ( w )
-            {
-                w->setPageItem( item );
-                w->setFormWidgetsController( d->formWidgetsController() );
-                w->setVisibility( false );
-                w->setCanBeFilled( allowfillforms );
-                item->formWidgets().insert( w );
-                hasformwidgets = true;
-            }
+            const QLinkedList< Okular::FormField * > pageFields = page->formFields();
+            hasformwidgets = std::any_of( pageFields.begin(), pageFields.end(), FormWidgetFactory::hasWidget );
         }
 
         createAnnotationsVideoWidgets( item, page->annotations() );
@@ -1403,6 +1489,10 @@ void PageView::notifyPageChanged( int pageNumber, int changedFlags )
     if ( changedFlags & DocumentObserver::Bookmark )
         return;
 
+    // the pixmap asked for arrived, the page is requested again if needed
+    if ( changedFlags & DocumentObserver::Pixmap )
+        d->pendingPixmapRequests.remove( pageNumber );
+
     if ( changedFlags & DocumentObserver::Annotations )
     {
         const QLinkedList< Okular::Annotation * > annots = d->document->page( pageNumber )->annotations();
@@ -1469,7 +1559,10 @@ void PageView::notifyContentsCleared( int changedFlags )
 {
     // if pixmaps were cleared, re-ask them
     if ( changedFlags & DocumentObserver::Pixmap )
+    {
+        d->pendingPixmapRequests.clear();
         QMetaObject::invokeMethod(this, "slotRequestVisiblePixmaps", Qt::QueuedConnection);
+    }
 }
 
 void PageView::notifyZoom( int factor )
@@ -4468,6 +4561,9 @@ void PageView::toggleFormWidgets( bool on )
     if ( somehadfocus )
         setFocus();
     d->m_formsVisible = on;
+    // create the widgets of the pages around the viewport
+    if ( on )
+        slotRequestVisiblePixmaps();
     if ( d->aToggleForms ) // it may not exist if we are on dummy mode
     {
         if ( d->m_formsVisible )
@@ -4711,6 +4807,9 @@ void PageView::slotRelayoutPages()
             for ( int i = 0; i < cIdx; ++i )
                 insertX += colWidth[ i ];
         }
+        d->layoutItems.clear();
+        d->layoutRowTops.clear();
+        d->layoutMaxBottoms.clear();
         for ( PageViewItem * item : qAsConst( d->items ) )
         {
             int cWidth = colWidth[ cIdx ],
@@ -4752,6 +4851,12 @@ void PageView::slotRelayoutPages()
                 item->moveTo( actualX,
                               (continuousView ? insertY : origInsertY) + (rHeight - item->croppedHeight()) / 2 );
                 item->setVisible( true );
+
+                const int maxBottom = d->layoutMaxBottoms.isEmpty() ? item->croppedGeometry().bottom()
+                                      : qMax( d->layoutMaxBottoms.last(), item->croppedGeometry().bottom() );
+                d->layoutItems.append( item );
+                d->layoutRowTops.append( continuousView ? insertY : origInsertY );
+                d->layoutMaxBottoms.append( maxBottom );
             }
             else
             {
@@ -4876,13 +4981,35 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
            minDistance = -1.0;
     // Margin (in pixels) around the viewport to preload
     const int pixelsToExpand = 512;
-
-    // iterate over all items
-    d->visibleItems.clear();
-    QLinkedList< Okular::PixmapRequest * > requestedPixmaps;
-    QVector< Okular::VisiblePageRect * > visibleRects;
-    for ( PageViewItem * i : qAsConst( d->items ) )
+    // the form widgets of the pages in the preloaded area are created, and
+    // deleted when the page is more than a viewport further away
+    const QRect formsRect = viewportRect.adjusted( -pixelsToExpand, -pixelsToExpand, pixelsToExpand, pixelsToExpand );
+    const QRect formsKeepRect = formsRect.adjusted( -viewportRect.width(), -viewportRect.height(), viewportRect.width(), viewportRect.height() );
+
+    // the form widgets of the items around the viewport are created, the
+    // ones of the items away are deleted, and the form and video widgets
+    // are moved along the viewport
+    if ( d->m_formsVisible )
+    {
+        int first, last;
+        d->layoutItemRange( formsRect, &first, &last );
+        for ( int j = first; j < last; ++j )
+        {
+            PageViewItem * i = d->layoutItems[ j ];
+            if ( formsRect.intersects( i->croppedGeometry() ) )
+                createFormWidgets( i );
+        }
+    }
+    const QSet< PageViewItem * > formWidgetItems = d->formWidgetItems;
+    for ( PageViewItem * i : formWidgetItems )
     {
+        if ( !i->isVisible() || !formsKeepRect.intersects( i->croppedGeometry() ) )
+        {
+            i->deleteFormWidgets();
+            d->formWidgetItems.remove( i );
+            continue;
+        }
+
         const QSet<FormWidgetIface *> formWidgetsList = i->formWidgets();
         for ( FormWidgetIface *fwi :  formWidgetsList)
         {
@@ -4891,6 +5018,9 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
                 qRound( i->uncroppedGeometry().left() + i->uncroppedWidth() * r.left ) + 1 - viewportRect.left(),
                 qRound( i->uncroppedGeometry().top() + i->uncroppedHeight() * r.top ) + 1 - viewportRect.top() );
         }
+    }
+    for ( PageViewItem * i : qAsConst( d->videoWidgetItems ) )
+    {
         const QHash<Okular::Movie *, VideoWidget *> videoWidgets = i->videoWidgets();
         for ( VideoWidget *vw : videoWidgets )
         {
@@ -4904,9 +5034,17 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
                 vw->pageLeft();
             }
         }
+    }
 
-        if ( !i->isVisible() )
-            continue;
+    // iterate over the items intersecting the viewport
+    d->visibleItems.clear();
+    QLinkedList< Okular::PixmapRequest * > requestedPixmaps;
+    QVector< Okular::VisiblePageRect * > visibleRects;
+    int firstItem, lastItem;
+    d->layoutItemRange( viewportRect, &firstItem, &lastItem );
+    for ( int j = firstItem; j < lastItem; ++j )
+    {
+        PageViewItem * i = d->layoutItems[ j ];
 #ifdef PAGEVIEW_DEBUG
         kWarning() << "checking page" << i->pageNumber();
         kWarning().nospace() << "viewportRect is " << viewportRect << ", page item is " << i->croppedGeometry() << " intersect : " << viewportRect.intersects( i->croppedGeometry() );
@@ -5012,11 +5150,47 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
         }
     }
 
-    // send requests to the document
-    if ( !requestedPixmaps.isEmpty() )
+    // send the requests of the pages whose request is new or changed, the
+    // other ones are still pending in the document: scrolling by a few
+    // pixels usually leaves most of them unchanged
+    QHash< int, PixmapRequestKey > requestKeys;
+    requestKeys.reserve( requestedPixmaps.count() );
+    for ( const Okular::PixmapRequest * p : qAsConst( requestedPixmaps ) )
+        requestKeys.insert( p->pageNumber(), PixmapRequestKey( p ) );
+
+    // the pending requests of the pages not asked for anymore are only
+    // removed by sending the whole list again
+    bool pagesDropped = false;
+    for ( QHash< int, PixmapRequestKey >::const_iterator it = d->pendingPixmapRequests.constBegin(); it != d->pendingPixmapRequests.constEnd(); ++it )
+    {
+        if ( !requestKeys.contains( it.key() ) )
+        {
+            pagesDropped = true;
+            break;
+        }
+    }
+
+    if ( pagesDropped )
     {
-        d->document->requestPixmaps( requestedPixmaps );
+        if ( !requestedPixmaps.isEmpty() )
+            d->document->requestPixmaps( requestedPixmaps );
     }
+    else
+    {
+        QLinkedList< Okular::PixmapRequest * > changedPixmaps;
+        for ( Okular::PixmapRequest * p : qAsConst( requestedPixmaps ) )
+        {
+            const QHash< int, PixmapRequestKey >::const_iterator it = d->pendingPixmapRequests.constFind( p->pageNumber() );
+            if ( it != d->pendingPixmapRequests.constEnd() && *it == requestKeys.value( p->pageNumber() ) )
+                delete p;
+            else
+                changedPixmaps.push_back( p );
+        }
+        // the requests replace the previous ones of the same pages only
+        if ( !changedPixmaps.isEmpty() )
+            d->document->requestPixmaps( changedPixmaps, Okular::Document::NoOption );
+    }
+    d->pendingPixmapRequests = requestKeys;
     // if this functions was invoked by viewport events, send update to document
     if ( isEvent && nearPageNumber != -1 )
     {
@@ -5028,7 +5202,19 @@ void PageView::slotRequestVisiblePixmaps( int newValue )
         // set the viewport to other observers
         d->document->setViewport( newViewport , this );
     }
-    d->document->setVisiblePageRects( visibleRects, this );
+
+    // the other observers are only told about visible rects that changed
+    const QVector< Okular::VisiblePageRect * > &currentRects = d->document->visiblePageRects();
+    bool rectsChanged = currentRects.count() != visibleRects.count();
+    for ( int j = 0; !rectsChanged && j < visibleRects.count(); ++j )
+    {
+        rectsChanged = currentRects.at( j )->pageNumber != visibleRects.at( j )->pageNumber ||
+                       !( currentRects.at( j )->rect == visibleRects.at( j )->rect );
+    }
+    if ( rectsChanged )
+        d->document->setVisiblePageRects( visibleRects, this );
+    else
+        qDeleteAll( visibleRects );
 }
 
 
@@ -5534,28 +5720,14 @@ void PageView::slotRefreshPage()
 #ifdef HAVE_SPEECH
 void PageView::slotSpeakDocument()
 {
-    QString text;
-    for ( const PageViewItem * item : qAsConst( d->items ) )
-    {
-        Okular::RegularAreaRect * area = textSelectionForItem( item );
-        text.append( item->page()->text( area ) );
-        text.append( '\n' );
-        delete area;
-    }
-
-    d->tts()->say( text );
+    d->tts()->sayPages( d->document, 0, d->document->pages() - 1 );
 }
 
 void PageView::slotSpeakCurrentPage()
 {
     const int currentPage = d->document->viewport().pageNumber;
 
-    PageViewItem *item = d->items.at( currentPage );
-    Okular::RegularAreaRect * area = textSelectionForItem( item );
-    const QString text = item->page()->text( area );
-    delete area;
-
-    d->tts()->say( text );
+    d->tts()->sayPages( d->document, currentPage, currentPage );
 }
 
 void PageView::slotStopSpeaks()
@@ -5723,15 +5895,21 @@ void PageView::highlightSignatureFormWidget( const Okular::FormFieldSignature *f
     QVector< PageViewItem * >::const_iterator dIt = d->items.constBegin(), dEnd = d->items.constEnd();
     for ( ; dIt != dEnd; ++dIt )
     {
+        // the page of the signature may be away from the viewport
+        if ( !(*dIt)->page()->formFields().contains( const_cast< Okular::FormFieldSignature * >( form ) ) )
+            continue;
+
+        createFormWidgets( *dIt );
         const QSet<FormWidgetIface *> fwi = (*dIt)->formWidgets();
         for ( FormWidgetIface *fw : fwi )
         {
             if ( fw->formField() == form )
             {
-                SignatureEdit *widget = static_cast< SignatureEdit * >( fw );
+                QPointer< SignatureEdit > widget = static_cast< SignatureEdit * >( fw );
                 widget->setDummyMode( true );
                 QTimer::singleShot( 250, this, [=]{
-                    widget->setDummyMode( false );
+                    if ( widget )
+                        widget->setDummyMode( false );
                 });
                 return;
             }
@@ -212,6 +212,7 @@ Q_OBJECT
         // handle link clicked
         bool mouseReleaseOverLink( const Okular::ObjectRect * rect ) const;
 
+        void createFormWidgets( PageViewItem *item );
         void createAnnotationsVideoWidgets(PageViewItem *item, const QLinkedList< Okular::Annotation * > &annotations);
 
         // don't want to expose classes in here
@@ -47,7 +47,7 @@
 
 PageViewItem::PageViewItem( const Okular::Page * page )
     : m_page( page ), m_zoomFactor( 1.0 ), m_visible( true ),
-    m_formsVisible( false ), m_crop( 0., 0., 1., 1. )
+    m_formsVisible( false ), m_formWidgetsCreated( false ), m_crop( 0., 0., 1., 1. )
 {
 }
 
@@ -127,6 +127,23 @@ QSet<FormWidgetIface*>& PageViewItem::formWidgets()
     return m_formWidgets;
 }
 
+bool PageViewItem::hasFormWidgetsCreated() const
+{
+    return m_formWidgetsCreated;
+}
+
+void PageViewItem::setFormWidgetsCreated()
+{
+    m_formWidgetsCreated = true;
+}
+
+void PageViewItem::deleteFormWidgets()
+{
+    qDeleteAll( m_formWidgets );
+    m_formWidgets.clear();
+    m_formWidgetsCreated = false;
+}
+
 QHash< Okular::Movie *, VideoWidget* >& PageViewItem::videoWidgets()
 {
     return m_videoWidgets;
@@ -52,6 +52,10 @@ class PageViewItem
         double zoomFactor() const;
         bool isVisible() const;
         QSet<FormWidgetIface*>& formWidgets();
+        // the form widgets are only created for the pages close to the viewport
+        bool hasFormWidgetsCreated() const;
+        void setFormWidgetsCreated();
+        void deleteFormWidgets();
         QHash< Okular::Movie *, VideoWidget * >& videoWidgets();
 
         /* The page is cropped as follows: */
@@ -88,6 +92,7 @@ class PageViewItem
         double m_zoomFactor;
         bool m_visible;
         bool m_formsVisible;
+        bool m_formWidgetsCreated;
         QRect m_croppedGeometry;
         QRect m_uncroppedGeometry;
         Okular::NormalizedRect m_crop;
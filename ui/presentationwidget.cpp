@@ -72,6 +72,9 @@
 // comment this to disable the top-right progress indicator
 #define ENABLE_PROGRESS_OVERLAY
 
+// time budget of a transition frame, in milliseconds (~60 fps)
+#define TRANSITION_FRAME_BUDGET 16
+
 
 // a frame contains a pointer to the page object, its geometry and the
 // transition effect to the next frame
@@ -148,6 +151,7 @@ PresentationWidget::PresentationWidget( QWidget * parent, Okular::Document * doc
     : QWidget( nullptr /* must be null, to have an independent widget */, Qt::FramelessWindowHint ),
     m_pressedLink( nullptr ), m_handCursor( false ), m_drawingEngine( nullptr ),
     m_screenInhibitCookie(0), m_sleepInhibitFd(-1),
+    m_transitionDuration( 0 ), m_transitionRectsTotal( 0 ), m_transitionFrames( 0 ), m_transitionDroppedFrames( 0 ),
     m_parentWidget( parent ),
     m_document( doc ), m_frameIndex( -1 ), m_topBar( nullptr ), m_pagesEdit( nullptr ), m_searchBar( nullptr ),
     m_ac( collection ), m_screenSelect( nullptr ), m_isSetup( false ), m_blockNotifications( false ), m_inBlackScreenMode( false ),
@@ -251,6 +255,7 @@ PresentationWidget::PresentationWidget( QWidget * parent, Okular::Document * doc
     setContextMenuPolicy( Qt::PreventContextMenu );
     m_transitionTimer = new QTimer( this );
     m_transitionTimer->setSingleShot( true );
+    m_transitionTimer->setTimerType( Qt::PreciseTimer );
     connect(m_transitionTimer, &QTimer::timeout, this, &PresentationWidget::slotTransitionStep);
     m_overlayHideTimer = new QTimer( this );
     m_overlayHideTimer->setSingleShot( true );
@@ -334,6 +339,7 @@ void PresentationWidget::notifySetup( const QVector< Okular::Page * > & pageSet,
     if ( !m_frames.isEmpty() )
         qCWarning(OkularUiDebug) << "Frames setup changed while a Presentation is in progress.";
     m_frames.clear();
+    m_renderedSlides.clear();
 
     // create the new frames
     float screenRatio = (float)m_height / (float)m_width;
@@ -405,9 +411,24 @@ void PresentationWidget::notifyPageChanged( int pageNumber, int changedFlags )
     if ( m_blockNotifications )
         return;
 
+    if ( !( changedFlags & ( DocumentObserver::Pixmap | DocumentObserver::Annotations | DocumentObserver::Highlights ) ) )
+        return;
+
+    // whatever we composited for this page is outdated now
+    m_renderedSlides.remove( pageNumber );
+
     // check if it's the last requested pixmap. if so update the widget.
-    if ( (changedFlags & ( DocumentObserver::Pixmap | DocumentObserver::Annotations | DocumentObserver::Highlights ) ) && pageNumber == m_frameIndex )
+    if ( pageNumber == m_frameIndex )
+    {
         generatePage( changedFlags & ( DocumentObserver::Annotations | DocumentObserver::Highlights ) );
+    }
+    else if ( m_frameIndex != -1 && qAbs( pageNumber - m_frameIndex ) <= slidesToPrerender() )
+    {
+        // composite the neighbour slide now, so that switching to it is a plain blit
+        const QPixmap slide = renderSlide( pageNumber );
+        if ( !slide.isNull() )
+            m_renderedSlides.insert( pageNumber, slide );
+    }
 }
 
 void PresentationWidget::notifyCurrentPageChanged( int previousPage, int currentPage )
@@ -447,6 +468,7 @@ void PresentationWidget::notifyCurrentPageChanged( int previousPage, int current
     if ( currentPage != -1 )
     {
         m_frameIndex = currentPage;
+        trimRenderedSlides();
 
         // check if pixmap exists or else request it
         PresentationFrame * frame = m_frames[ m_frameIndex ];
@@ -498,16 +520,38 @@ void PresentationWidget::notifyCurrentPageChanged( int previousPage, int current
 
 bool PresentationWidget::canUnloadPixmap( int pageNumber ) const
 {
-    if ( Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Low ||
-         Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Normal )
-    {
-        // can unload all pixmaps except for the currently visible one
-        return pageNumber != m_frameIndex;
+    // can unload all pixmaps except for the currently visible one and the
+    // prerendered ones around it
+    return qAbs(pageNumber - m_frameIndex) > slidesToPrerender();
+}
+
+int PresentationWidget::slidesToPrerender() const
+{
+    switch ( Okular::SettingsCore::memoryLevel() )
+    {
+        case Okular::SettingsCore::EnumMemoryLevel::Low:
+            return 0;
+        case Okular::SettingsCore::EnumMemoryLevel::Normal:
+            return 1;
+        case Okular::SettingsCore::EnumMemoryLevel::Aggressive:
+            return 2;
+        case Okular::SettingsCore::EnumMemoryLevel::Greedy:
+        default:
+            return 3;
     }
-    else
+}
+
+void PresentationWidget::trimRenderedSlides()
+{
+    // keep only the slides that are in the prerendering window
+    const int window = slidesToPrerender();
+    QHash< int, QPixmap >::iterator it = m_renderedSlides.begin();
+    while ( it != m_renderedSlides.end() )
     {
-        // can unload all pixmaps except for the currently visible one, previous and next
-        return qAbs(pageNumber - m_frameIndex) <= 1;
+        if ( qAbs( it.key() - m_frameIndex ) > window )
+            it = m_renderedSlides.erase( it );
+        else
+            ++it;
     }
 }
 
@@ -1097,11 +1141,33 @@ void PresentationWidget::generatePage( bool disableTransition )
     // generate welcome page
     if ( m_frameIndex == -1 )
         generateIntroPage( pixmapPainter );
-    // generate a normal pixmap with extended margin filling
+    // generate a normal pixmap with extended margin filling, unless the
+    // slide was already composited while we were showing the previous one
+    bool slideComposited = false;
     if ( m_frameIndex >= 0 && m_frameIndex < (int)m_document->pages() )
-        generateContentsPage( m_frameIndex, pixmapPainter );
+    {
+        const QPixmap slide = m_renderedSlides.value( m_frameIndex );
+        if ( !slide.isNull() && slide.size() == m_lastRenderedPixmap.size() )
+        {
+            pixmapPainter.drawPixmap( 0, 0, slide );
+        }
+        else
+        {
+            generateContentsPage( m_frameIndex, pixmapPainter );
+            slideComposited = true;
+        }
+    }
     pixmapPainter.end();
 
+    // remember the slide if it contains the real page contents
+    if ( slideComposited )
+    {
+        const PresentationFrame * frame = m_frames[ m_frameIndex ];
+        const qreal dpr = qApp->devicePixelRatio();
+        if ( frame->page->hasPixmap( this, ceil( frame->geometry.width() * dpr ), ceil( frame->geometry.height() * dpr ) ) )
+            m_renderedSlides.insert( m_frameIndex, m_lastRenderedPixmap );
+    }
+
     // generate the top-right corner overlay
 #ifdef ENABLE_PROGRESS_OVERLAY
     if ( Okular::Settings::slidesShowProgress() && m_frameIndex != -1 )
@@ -1190,6 +1256,24 @@ void PresentationWidget::generateIntroPage( QPainter & p )
     }
 }
 
+QPixmap PresentationWidget::renderSlide( int pageNum )
+{
+    const PresentationFrame * frame = m_frames[ pageNum ];
+    const qreal dpr = qApp->devicePixelRatio();
+
+    // compositing a page without its pixmap would just cache a blank slide
+    if ( m_width <= 0 || m_height <= 0 ||
+         !frame->page->hasPixmap( this, ceil( frame->geometry.width() * dpr ), ceil( frame->geometry.height() * dpr ) ) )
+        return QPixmap();
+
+    QPixmap slide( m_width * dpr, m_height * dpr );
+    slide.setDevicePixelRatio( dpr );
+    QPainter p( &slide );
+    generateContentsPage( pageNum, p );
+    p.end();
+    return slide;
+}
+
 void PresentationWidget::generateContentsPage( int pageNum, QPainter & p )
 {
     PresentationFrame * frame = m_frames[ pageNum ];
@@ -1490,7 +1574,7 @@ void PresentationWidget::requestPixmaps()
     // ask for next and previous page if not in low memory usage setting
     if ( Okular::SettingsCore::memoryLevel() != Okular::SettingsCore::EnumMemoryLevel::Low )
     {
-        int pagesToPreload = 1;
+        int pagesToPreload = slidesToPrerender();
 
         // If greedy, preload everything
         if (Okular::SettingsCore::memoryLevel() == Okular::SettingsCore::EnumMemoryLevel::Greedy)
@@ -1606,12 +1690,22 @@ void PresentationWidget::slotHideOverlay()
 
 void PresentationWidget::slotTransitionStep()
 {
+    // the transition is driven by the elapsed time, not by the number of
+    // timer ticks, so a late tick just shows a more advanced frame
+    const qint64 elapsed = m_transitionClock.elapsed();
+    const double progress = m_transitionDuration > 0 ? qMin( 1.0, (double)elapsed / (double)m_transitionDuration ) : 1.0;
+
+    // a frame is due every TRANSITION_FRAME_BUDGET ms from the start, the
+    // ones we could not deliver by now are dropped
+    m_transitionFrames++;
+    m_transitionDroppedFrames = qMax( 0, (int)( elapsed / TRANSITION_FRAME_BUDGET ) + 1 - m_transitionFrames );
+
     switch( m_currentTransition.type() )
     {
         case Okular::PageTransition::Fade:
         {
             QPainter pixmapPainter;
-            m_currentPixmapOpacity += 1.0 / m_transitionSteps;
+            m_currentPixmapOpacity = progress;
             m_lastRenderedPixmap = QPixmap( m_lastRenderedPixmap.size() );
             m_lastRenderedPixmap.setDevicePixelRatio( qApp->devicePixelRatio() );
             m_lastRenderedPixmap.fill( Qt::transparent );
@@ -1621,28 +1715,32 @@ void PresentationWidget::slotTransitionStep()
             pixmapPainter.drawPixmap( 0, 0, m_previousPagePixmap );
             pixmapPainter.setOpacity( m_currentPixmapOpacity );
             pixmapPainter.drawPixmap( 0, 0, m_currentPagePixmap );
+            pixmapPainter.end();
             update();
-            if( m_currentPixmapOpacity >= 1 )
-                return;
         } break;
         default:
         {
-            if ( m_transitionRects.empty() )
-            {
-                // it's better to fix the transition to cover the whole screen than
-                // enabling the following line that wastes cpu for nothing
-                //update();
-                return;
-            }
-
-            for ( int i = 0; i < m_transitionMul && !m_transitionRects.empty(); i++ )
+            // reveal all the pieces that are due at this point of the transition
+            const int done = m_transitionRectsTotal - m_transitionRects.count();
+            const int due = (int)ceil( progress * m_transitionRectsTotal );
+            QRegion dirty;
+            for ( int i = done; i < due && !m_transitionRects.empty(); i++ )
             {
-                update( m_transitionRects.first() );
+                dirty += m_transitionRects.first();
                 m_transitionRects.pop_front();
             }
+            if ( !dirty.isEmpty() )
+                update( dirty );
         } break;
     }
-    m_transitionTimer->start( m_transitionDelay );
+
+    if ( progress >= 1.0 )
+    {
+        finishTransition();
+        return;
+    }
+    // aim at the next frame boundary, so slow frames do not shift the later ones
+    m_transitionTimer->start( TRANSITION_FRAME_BUDGET - (int)( m_transitionClock.elapsed() % TRANSITION_FRAME_BUDGET ) );
 }
 
 void PresentationWidget::slotDelayedEvents()
@@ -1769,6 +1867,7 @@ void PresentationWidget::applyNewScreenSize( const QSize & oldSize )
     {
         frame->recalcGeometry( m_width, m_height, screenRatio );
     }
+    m_renderedSlides.clear();
 
     if ( m_frameIndex != -1 )
     {
@@ -2066,6 +2165,7 @@ void PresentationWidget::initTransition( const Okular::PageTransition *transitio
     m_transitionRects.clear();
     m_currentTransition = *transition;
     m_currentPagePixmap = m_lastRenderedPixmap;
+    m_transitionDuration = qMax( 0, (int)( totalTime * 1000 ) );
 
     switch( transition->type() )
     {
@@ -2123,8 +2223,6 @@ void PresentationWidget::initTransition( const Okular::PageTransition *transitio
                     }
                 }
             }
-            m_transitionMul = 2;
-            m_transitionDelay = (int)( (totalTime * 1000) / steps );
         } break;
 
             // blinds: horizontal(l-to-r) / vertical(t-to-b)
@@ -2164,8 +2262,6 @@ void PresentationWidget::initTransition( const Okular::PageTransition *transitio
                     }
                 }
             }
-            m_transitionMul = blinds;
-            m_transitionDelay = (int)( (totalTime * 1000) / steps );
         } break;
 
             // box: inward / outward
@@ -2208,8 +2304,6 @@ void PresentationWidget::initTransition( const Okular::PageTransition *transitio
                     L = newL; T = newT; R = newR, B = newB;
                 }
             }
-            m_transitionMul = 4;
-            m_transitionDelay = (int)( (totalTime * 1000) / steps );
         } break;
 
             // wipe: implemented for 4 canonical angles
@@ -2262,8 +2356,6 @@ void PresentationWidget::initTransition( const Okular::PageTransition *transitio
                 update();
                 return;
             }
-            m_transitionMul = 1;
-            m_transitionDelay = (int)( (totalTime * 1000) / steps );
         } break;
 
             // dissolve: replace 'random' rects
@@ -2305,9 +2397,6 @@ void PresentationWidget::initTransition( const Okular::PageTransition *transitio
                     m_transitionRects[ n1 ] = r;
                 }
             }
-            // set global transition parameters
-            m_transitionMul = 40;
-            m_transitionDelay = (int)( (m_transitionMul * 1000 * totalTime) / steps );
         } break;
 
             // glitter: similar to dissolve but has a direction
@@ -2401,20 +2490,13 @@ void PresentationWidget::initTransition( const Okular::PageTransition *transitio
                     m_transitionRects[ n1 ] = r;
                 }
             }
-            // set global transition parameters
-            m_transitionMul = (angle == 90) || (angle == 270) ? gridYsteps : gridXsteps;
-            m_transitionMul /= 2;
-            m_transitionDelay = (int)( (m_transitionMul * 1000 * totalTime) / steps );
         } break;
 
         case Okular::PageTransition::Fade:
         {
-            enum {FADE_TRANSITION_FPS = 20};
-            const int steps = totalTime * FADE_TRANSITION_FPS;
-            m_transitionSteps = steps;
+            // start from the previous page, the compositor blends in the new one
             QPainter pixmapPainter;
-            m_currentPixmapOpacity = (double) 1 / steps;
-            m_transitionDelay = (int)( totalTime * 1000 ) / steps;
+            m_currentPixmapOpacity = 0.0;
             m_lastRenderedPixmap = QPixmap( m_lastRenderedPixmap.size() );
             m_lastRenderedPixmap.fill( Qt::transparent );
             pixmapPainter.begin( &m_lastRenderedPixmap );
@@ -2441,9 +2523,23 @@ void PresentationWidget::initTransition( const Okular::PageTransition *transitio
     }
 
     // send the first start to the timer
+    m_transitionRectsTotal = m_transitionRects.count();
+    m_transitionFrames = 0;
+    m_transitionDroppedFrames = 0;
+    m_transitionClock.start();
     m_transitionTimer->start( 0 );
 }
 
+void PresentationWidget::finishTransition()
+{
+    m_transitionTimer->stop();
+    m_transitionRects.clear();
+
+    // report how well the compositor kept up, useful to evaluate slow projector hardware
+    qCDebug(OkularUiDebug) << "Transition" << m_currentTransition.type() << "completed in" << m_transitionClock.elapsed() << "ms:"
+                           << m_transitionFrames << "frames," << m_transitionDroppedFrames << "dropped";
+}
+
 void PresentationWidget::slotProcessMovieAction( const Okular::MovieAction *action )
 {
     const Okular::MovieAnnotation *movieAnnotation = action->annotation();
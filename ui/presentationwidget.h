@@ -11,6 +11,8 @@
 #define _OKULAR_PRESENTATIONWIDGET_H_
 
 #include <QDomElement>
+#include <QElapsedTimer>
+#include <QHash>
 #include <qlist.h>
 #include <qpixmap.h>
 #include <qstringlist.h>
@@ -88,7 +90,11 @@ class PresentationWidget : public QWidget, public Okular::DocumentObserver
         void generateIntroPage( QPainter & p );
         void generateContentsPage( int page, QPainter & p );
         void generateOverlay();
+        QPixmap renderSlide( int pageNum );
+        int slidesToPrerender() const;
+        void trimRenderedSlides();
         void initTransition( const Okular::PageTransition *transition );
+        void finishTransition();
         const Okular::PageTransition defaultTransition() const;
         const Okular::PageTransition defaultTransition( int ) const;
         QRect routeMouseDrawingEvent( QMouseEvent * );
@@ -119,13 +125,18 @@ class PresentationWidget : public QWidget, public Okular::DocumentObserver
         uint m_screenInhibitCookie;
         int m_sleepInhibitFd;
 
+        // fully composited slides around the current one, ready to be shown
+        QHash< int, QPixmap > m_renderedSlides;
+
         // transition related
         QTimer * m_transitionTimer;
         QTimer * m_overlayHideTimer;
         QTimer * m_nextPageTimer;
-        int m_transitionDelay;
-        int m_transitionMul;
-        int m_transitionSteps;
+        QElapsedTimer m_transitionClock;
+        int m_transitionDuration;
+        int m_transitionRectsTotal;
+        int m_transitionFrames;
+        int m_transitionDroppedFrames;
         QList< QRect > m_transitionRects;
         Okular::PageTransition m_currentTransition;
         QPixmap m_currentPagePixmap;
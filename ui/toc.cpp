@@ -53,6 +53,8 @@ TOC::TOC(QWidget *parent, Okular::Document *document) : QWidget(parent), m_docum
     connect(m_treeView, &QTreeView::clicked, this, &TOC::slotExecuted);
     connect(m_treeView, &QTreeView::activated, this, &TOC::slotExecuted);
     m_searchLine->setTreeView( m_treeView );
+
+    connect(m_document, &Okular::Document::documentSynopsisChanged, this, &TOC::reloadSynopsis);
 }
 
 TOC::~TOC()
@@ -65,6 +67,11 @@ void TOC::notifySetup( const QVector< Okular::Page * > & /*pages*/, int setupFla
     if ( !( setupFlags & Okular::DocumentObserver::DocumentChanged ) )
         return;
 
+    reloadSynopsis();
+}
+
+void TOC::reloadSynopsis()
+{
     // clear contents
     m_model->clear();
 
@@ -200,6 +207,9 @@ void TOC::expandRecursively()
     {
         QModelIndex index = worklist.takeLast();
         m_treeView->expand( index );
+        // the children of collapsed items may not have been created yet
+        if ( m_model->canFetchMore( index ) )
+            m_model->fetchMore( index );
         for ( int i = 0; i < m_model->rowCount(index); i++ )
         {
             worklist += m_model->index( i, 0, index );
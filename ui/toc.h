@@ -59,6 +59,7 @@ Q_OBJECT
     private Q_SLOTS:
         void slotExecuted( const QModelIndex & );
         void saveSearchOptions();
+        void reloadSynopsis();
 
     protected:
         void contextMenuEvent( QContextMenuEvent * e ) override;
@@ -11,6 +11,7 @@
 
 #include <qapplication.h>
 #include <qdom.h>
+#include <qhash.h>
 #include <qlist.h>
 #include <qtreeview.h>
 
@@ -20,6 +21,8 @@
 #include "core/document.h"
 #include "core/page.h"
 
+#include <algorithm>
+
 Q_DECLARE_METATYPE( QModelIndex )
 
 struct TOCItem
@@ -35,12 +38,32 @@ struct TOCItem
     Okular::DocumentViewport viewport;
     QString extFileName;
     QString url;
-    bool highlight : 1;
+    // the synopsis node, the children items are created from it on demand
+    QDomNode node;
+    // position in the viewport index, or -1
+    int entry;
+    bool populated : 1;
     TOCItem *parent;
     QList< TOCItem* > children;
     TOCModelPrivate *model;
 };
 
+/**
+ * An entry of the synopsis with a valid viewport.
+ *
+ * The entries are laid out breadth first, so that the children with a
+ * viewport of every entry are contiguous and in the synopsis order.
+ */
+struct TOCEntry
+{
+    int page;
+    // the highest page of the entry and of the entries before it among its
+    // siblings, it only grows so the siblings can be binary searched
+    int maxPage;
+    int childBegin;
+    int childEnd;
+};
+
 
 class TOCModelPrivate
 {
@@ -48,48 +71,64 @@ public:
     TOCModelPrivate( TOCModel *qq );
     ~TOCModelPrivate();
 
-    void addChildren( const QDomNode &parentNode, TOCItem * parentItem );
+    int childCount( const QDomNode &parentNode ) const;
+    void addChildren( TOCItem * parentItem );
+    void buildEntries();
+    void appendEntries( const QDomNode &parentNode, QVector< QDomElement > *elements );
     QModelIndex indexForItem( TOCItem *item ) const;
-    void findViewport( const Okular::DocumentViewport &viewport, TOCItem *item, QList< TOCItem* > &list ) const;
+    QVector< int > findViewport( const Okular::DocumentViewport &viewport ) const;
+    void highlightChanged( const QVector< int > &entries );
+    bool isHighlighted( const TOCItem *item ) const;
 
     TOCModel *q;
     TOCItem *root;
     bool dirty : 1;
     Okular::Document *document;
+    // shares the synopsis of the generator, the items refer to its nodes
+    QDomDocument synopsis;
+    QVector< TOCEntry > entries;
+    int topLevelEntries;
+    QHash< int, TOCItem* > entryItems;
     QList< TOCItem* > itemsToOpen;
-    QList< TOCItem* > currentPage;
+    // the entries of the highlighted items, from the top level down
+    QVector< int > currentPage;
     TOCModel *m_oldModel;
     QVector<QModelIndex> m_oldTocExpandedIndexes;
 };
 
 
-TOCItem::TOCItem()
-    : highlight( false ), parent( nullptr ), model( nullptr )
-{
-}
-
-TOCItem::TOCItem( TOCItem *_parent, const QDomElement &e )
-    : highlight( false ), parent( _parent )
+static Okular::DocumentViewport viewportForElement( const QDomElement &e, Okular::Document *document )
 {
-    parent->children.append( this );
-    model = parent->model;
-    text = e.tagName();
-
     // viewport loading
     if ( e.hasAttribute( QStringLiteral("Viewport") ) )
     {
         // if the node has a viewport, set it
-        viewport = Okular::DocumentViewport( e.attribute( QStringLiteral("Viewport") ) );
+        return Okular::DocumentViewport( e.attribute( QStringLiteral("Viewport") ) );
     }
     else if ( e.hasAttribute( QStringLiteral("ViewportName") ) )
     {
         // if the node references a viewport, get the reference and set it
         const QString & page = e.attribute( QStringLiteral("ViewportName") );
-        QString viewport_string = model->document->metaData( QStringLiteral("NamedViewport"), page ).toString();
+        QString viewport_string = document->metaData( QStringLiteral("NamedViewport"), page ).toString();
         if ( !viewport_string.isEmpty() )
-            viewport = Okular::DocumentViewport( viewport_string );
+            return Okular::DocumentViewport( viewport_string );
     }
 
+    return Okular::DocumentViewport();
+}
+
+TOCItem::TOCItem()
+    : entry( -1 ), populated( false ), parent( nullptr ), model( nullptr )
+{
+}
+
+TOCItem::TOCItem( TOCItem *_parent, const QDomElement &e )
+    : node( e ), entry( -1 ), populated( false ), parent( _parent )
+{
+    parent->children.append( this );
+    model = parent->model;
+    text = e.tagName();
+    viewport = viewportForElement( e, model->document );
     extFileName = e.attribute( QStringLiteral("ExternalFileName") );
     url = e.attribute( QStringLiteral("URL") );
 }
@@ -101,7 +140,7 @@ TOCItem::~TOCItem()
 
 
 TOCModelPrivate::TOCModelPrivate( TOCModel *qq )
-    : q( qq ), root( new TOCItem ), dirty( false ), m_oldModel( nullptr )
+    : q( qq ), root( new TOCItem ), dirty( false ), topLevelEntries( 0 ), m_oldModel( nullptr )
 {
     root->model = this;
 }
@@ -112,21 +151,35 @@ TOCModelPrivate::~TOCModelPrivate()
     delete m_oldModel;
 }
 
-void TOCModelPrivate::addChildren( const QDomNode & parentNode, TOCItem * parentItem )
+int TOCModelPrivate::childCount( const QDomNode &parentNode ) const
 {
-    TOCItem * currentItem = nullptr;
-    QDomNode n = parentNode.firstChild();
-    while( !n.isNull() )
-    {
-        // convert the node to an element (sure it is)
-        QDomElement e = n.toElement();
+    int count = 0;
+    for ( QDomElement e = parentNode.firstChildElement(); !e.isNull(); e = e.nextSiblingElement() )
+        ++count;
+    return count;
+}
+
+void TOCModelPrivate::addChildren( TOCItem * parentItem )
+{
+    parentItem->populated = true;
+
+    // the children with a viewport have the next entries of the parent
+    int entry = -1;
+    if ( parentItem == root )
+        entry = 0;
+    else if ( parentItem->entry >= 0 )
+        entry = entries.at( parentItem->entry ).childBegin;
 
+    for ( QDomElement e = parentItem->node.firstChildElement(); !e.isNull(); e = e.nextSiblingElement() )
+    {
         // insert the entry as top level (listview parented) or 2nd+ level
-        currentItem = new TOCItem( parentItem, e );
+        TOCItem * currentItem = new TOCItem( parentItem, e );
 
-        // descend recursively and advance to the next node
-        if ( e.hasChildNodes() )
-            addChildren( n, currentItem );
+        if ( entry >= 0 && currentItem->viewport.isValid() )
+        {
+            currentItem->entry = entry++;
+            entryItems.insert( currentItem->entry, currentItem );
+        }
 
         // open/keep close the item
         bool isOpen = false;
@@ -134,9 +187,37 @@ void TOCModelPrivate::addChildren( const QDomNode & parentNode, TOCItem * parent
             isOpen = QVariant( e.attribute( QStringLiteral("Open") ) ).toBool();
         if ( isOpen )
             itemsToOpen.append( currentItem );
+    }
+}
+
+void TOCModelPrivate::appendEntries( const QDomNode &parentNode, QVector< QDomElement > *elements )
+{
+    int maxPage = -1;
+    for ( QDomElement e = parentNode.firstChildElement(); !e.isNull(); e = e.nextSiblingElement() )
+    {
+        const Okular::DocumentViewport viewport = viewportForElement( e, document );
+        if ( !viewport.isValid() )
+            continue;
+
+        maxPage = qMax( maxPage, viewport.pageNumber );
+        entries.append( TOCEntry{ viewport.pageNumber, maxPage, -1, -1 } );
+        elements->append( e );
+    }
+}
+
+void TOCModelPrivate::buildEntries()
+{
+    // only the entries with a viewport are looked into when looking for the
+    // current page, so their children are the only ones needed
+    QVector< QDomElement > elements;
+    appendEntries( synopsis, &elements );
+    topLevelEntries = entries.count();
 
-        n = n.nextSibling();
-        emit q->countChanged();
+    for ( int i = 0; i < entries.count(); ++i )
+    {
+        entries[ i ].childBegin = entries.count();
+        appendEntries( elements.at( i ), &elements );
+        entries[ i ].childEnd = entries.count();
     }
 }
 
@@ -151,40 +232,48 @@ QModelIndex TOCModelPrivate::indexForItem( TOCItem *item ) const
     return QModelIndex();
 }
 
-void TOCModelPrivate::findViewport( const Okular::DocumentViewport &viewport, TOCItem *item, QList< TOCItem* > &list ) const
+QVector< int > TOCModelPrivate::findViewport( const Okular::DocumentViewport &viewport ) const
 {
-    TOCItem *todo = item;
+    // at every level, take the first entry on the page of the viewport, or
+    // the one before the first entry past it
+    const auto maxPageLessThan = []( const TOCEntry &entry, int page ) { return entry.maxPage < page; };
 
-    while ( todo )
+    QVector< int > list;
+    int begin = 0;
+    int end = topLevelEntries;
+    while ( begin < end )
     {
-        const TOCItem *current = todo;
-        todo = nullptr;
-        TOCItem *pos = nullptr;
+        int pos = std::lower_bound( entries.constBegin() + begin, entries.constBegin() + end, viewport.pageNumber, maxPageLessThan ) - entries.constBegin();
+        if ( pos == end || entries.at( pos ).page != viewport.pageNumber )
+            --pos;
+        if ( pos < begin )
+            break;
 
-        for ( TOCItem *child : current->children )
-        {
-            if ( child->viewport.isValid() )
-            {
-                if ( child->viewport.pageNumber <= viewport.pageNumber )
-                {
-                    pos = child;
-                    if ( child->viewport.pageNumber == viewport.pageNumber )
-                    {
-                        break;
-                    }
-                }
-                else
-                {
-                    break;
-                }
-            }
-        }
-        if ( pos )
-        {
-            list.append( pos );
-            todo = pos;
-        }
+        list.append( pos );
+        begin = entries.at( pos ).childBegin;
+        end = entries.at( pos ).childEnd;
     }
+    return list;
+}
+
+void TOCModelPrivate::highlightChanged( const QVector< int > &changedEntries )
+{
+    // the entries without an item are not shown yet
+    for ( int entry : changedEntries )
+    {
+        TOCItem *item = entryItems.value( entry );
+        if ( !item )
+            continue;
+
+        const QModelIndex index = indexForItem( item );
+        if ( index.isValid() )
+            emit q->dataChanged( index, index );
+    }
+}
+
+bool TOCModelPrivate::isHighlighted( const TOCItem *item ) const
+{
+    return item->entry >= 0 && currentPage.contains( item->entry );
 }
 
 
@@ -230,10 +319,13 @@ QVariant TOCModel::data( const QModelIndex &index, int role ) const
             return item->text;
             break;
         case Qt::DecorationRole:
-            if ( item->highlight )
+            if ( d->isHighlighted( item ) )
             {
                 const QVariant icon = QIcon::fromTheme( QApplication::layoutDirection() == Qt::RightToLeft ? QStringLiteral("arrow-left") : QStringLiteral("arrow-right") );
-                TOCItem *lastHighlighted = d->currentPage.last();
+                // the deepest highlighted item created so far
+                TOCItem *lastHighlighted = nullptr;
+                for ( int i = d->currentPage.count() - 1; !lastHighlighted && i >= 0; --i )
+                    lastHighlighted = d->entryItems.value( d->currentPage.at( i ) );
 
                 // in the mobile version our parent is not a QTreeView; add icon to the last highlighted item
                 // TODO misusing parent() here, fix
@@ -258,7 +350,7 @@ QVariant TOCModel::data( const QModelIndex &index, int role ) const
             }
             break;
         case HighlightRole:
-            return item->highlight;
+            return d->isHighlighted( item );
         case PageItemDelegate::PageRole:
             if ( item->viewport.isValid() )
                 return item->viewport.pageNumber + 1;
@@ -277,9 +369,36 @@ bool TOCModel::hasChildren( const QModelIndex &parent ) const
         return true;
 
     TOCItem *item = static_cast< TOCItem* >( parent.internalPointer() );
+    if ( !item->populated )
+        return item->node.hasChildNodes();
+
     return !item->children.isEmpty();
 }
 
+bool TOCModel::canFetchMore( const QModelIndex &parent ) const
+{
+    TOCItem *item = parent.isValid() ? static_cast< TOCItem* >( parent.internalPointer() ) : d->root;
+    return !item->populated && item->node.hasChildNodes();
+}
+
+void TOCModel::fetchMore( const QModelIndex &parent )
+{
+    TOCItem *item = parent.isValid() ? static_cast< TOCItem* >( parent.internalPointer() ) : d->root;
+    if ( item->populated )
+        return;
+
+    const int count = d->childCount( item->node );
+    if ( count == 0 )
+    {
+        item->populated = true;
+        return;
+    }
+
+    beginInsertRows( parent, 0, count - 1 );
+    d->addChildren( item );
+    endInsertRows();
+}
+
 QVariant TOCModel::headerData( int section, Qt::Orientation orientation, int role ) const
 {
     if ( orientation != Qt::Horizontal )
@@ -323,7 +442,10 @@ static QModelIndex indexForIndex( const QModelIndex &oldModelIndex, QAbstractIte
     QModelIndex newModelIndex;
     if ( oldModelIndex.parent().isValid() )
     {
-        newModelIndex = newModel->index( oldModelIndex.row(), oldModelIndex.column(), indexForIndex( oldModelIndex.parent(), newModel ) );
+        const QModelIndex newParent = indexForIndex( oldModelIndex.parent(), newModel );
+        if ( newModel->canFetchMore( newParent ) )
+            newModel->fetchMore( newParent );
+        newModelIndex = newModel->index( oldModelIndex.row(), oldModelIndex.column(), newParent );
     }
     else
     {
@@ -339,9 +461,16 @@ void TOCModel::fill( const Okular::DocumentSynopsis *toc )
 
     clear();
     emit layoutAboutToBeChanged();
-    d->addChildren( *toc, d->root );
+    d->synopsis = *toc;
+    d->root->node = d->synopsis;
+    d->buildEntries();
+    // the other items are created when their parent gets expanded
+    d->addChildren( d->root );
+    for ( int i = 0; i < d->itemsToOpen.count(); ++i )
+        d->addChildren( d->itemsToOpen.at( i ) );
     d->dirty = true;
     emit layoutChanged();
+    emit countChanged();
     if ( equals( d->m_oldModel ) )
     {
         for ( const QModelIndex &oldIndex : qAsConst(d->m_oldTocExpandedIndexes) )
@@ -380,6 +509,12 @@ void TOCModel::clear()
     beginResetModel();
     qDeleteAll( d->root->children );
     d->root->children.clear();
+    d->root->node = QDomNode();
+    d->root->populated = false;
+    d->synopsis = QDomDocument();
+    d->entries.clear();
+    d->topLevelEntries = 0;
+    d->entryItems.clear();
     d->currentPage.clear();
     endResetModel();
     d->dirty = false;
@@ -387,31 +522,15 @@ void TOCModel::clear()
 
 void TOCModel::setCurrentViewport( const Okular::DocumentViewport &viewport )
 {
-    for ( TOCItem* item : qAsConst(d->currentPage) )
-    {
-        QModelIndex index = d->indexForItem( item );
-        if ( !index.isValid() )
-            continue;
-
-        item->highlight = false;
-        emit dataChanged( index, index );
-    }
-    d->currentPage.clear();
-
-    QList< TOCItem* > newCurrentPage;
-    d->findViewport( viewport, d->root, newCurrentPage );
+    const QVector< int > newCurrentPage = d->findViewport( viewport );
+    if ( newCurrentPage == d->currentPage )
+        return;
 
+    const QVector< int > oldCurrentPage = d->currentPage;
     d->currentPage = newCurrentPage;
 
-    for ( TOCItem* item : qAsConst(d->currentPage) )
-    {
-        QModelIndex index = d->indexForItem( item );
-        if ( !index.isValid() )
-            continue;
-
-        item->highlight = true;
-        emit dataChanged( index, index );
-    }
+    d->highlightChanged( oldCurrentPage );
+    d->highlightChanged( d->currentPage );
 }
 
 bool TOCModel::isEmpty() const
@@ -419,10 +538,23 @@ bool TOCModel::isEmpty() const
     return d->root->children.isEmpty();
 }
 
+static bool sameSynopsis( const QDomNode &nodeA, const QDomNode &nodeB )
+{
+    QDomElement a = nodeA.firstChildElement();
+    QDomElement b = nodeB.firstChildElement();
+    for ( ; !a.isNull() && !b.isNull(); a = a.nextSiblingElement(), b = b.nextSiblingElement() )
+    {
+        if ( a.tagName() != b.tagName() || !sameSynopsis( a, b ) )
+            return false;
+    }
+    return a.isNull() && b.isNull();
+}
+
 bool TOCModel::equals( const TOCModel *model ) const
 {
+    // compare the synopses, most of the items may not exist yet
     if ( model )
-        return checkequality( model );
+        return sameSynopsis( d->synopsis, model->d->synopsis );
     else
         return false;
 }
@@ -474,27 +606,4 @@ QString TOCModel::urlForIndex( const QModelIndex &index ) const
     return item->url;
 }
 
-bool TOCModel::checkequality( const TOCModel *model, const QModelIndex & parentA, const QModelIndex & parentB ) const
-{
-    if ( rowCount( parentA ) != model->rowCount( parentB ) )
-        return false;
-    for ( int i = 0; i < rowCount( parentA ); i++ )
-    {
-        QModelIndex indxA = index( i, 0, parentA );
-        QModelIndex indxB = model->index( i, 0, parentB );
-        if ( indxA.data() != indxB.data() )
-        {
-            return false;
-        }
-        if ( hasChildren( indxA ) != model->hasChildren( indxB ) )
-        {
-            return false;
-        }
-        if ( !checkequality( model, indxA, indxB ) )
-        {
-            return false;
-        }
-    }
-    return true;
-}
 #include "moc_tocmodel.cpp"
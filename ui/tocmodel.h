@@ -45,6 +45,8 @@ class TOCModel : public QAbstractItemModel
         int columnCount( const QModelIndex &parent = QModelIndex() ) const override;
         QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const override;
         bool hasChildren( const QModelIndex &parent = QModelIndex() ) const override;
+        bool canFetchMore( const QModelIndex &parent ) const override;
+        void fetchMore( const QModelIndex &parent ) override;
         QVariant headerData( int section, Qt::Orientation orientation, int role = Qt::DisplayRole ) const override;
         QModelIndex index( int row, int column, const QModelIndex &parent = QModelIndex() ) const override;
         QModelIndex parent( const QModelIndex &index ) const override;
@@ -76,7 +78,6 @@ class TOCModel : public QAbstractItemModel
         // storage
         friend class TOCModelPrivate;
         TOCModelPrivate *const d;
-        bool checkequality( const TOCModel *model, const QModelIndex &parentA = QModelIndex(), const QModelIndex &parentB = QModelIndex() ) const;
 };
 
 #endif
@@ -10,18 +10,39 @@
 #include "tts.h"
 
 #include <qdbusservicewatcher.h>
+#include <qguiapplication.h>
+#include <qpalette.h>
+#include <qpointer.h>
+#include <qqueue.h>
 #include <qset.h>
+#include <qtimer.h>
 
 #include <KLocalizedString>
 
+#include "core/area.h"
+#include "core/document.h"
+#include "core/page.h"
 #include "settings.h"
 
+// pages whose sentences are extracted ahead of the one being spoken
+static const int LookAheadPages = 2;
+// sentences without punctuation are cut around this length
+static const int MaxSentenceLength = 400;
+
 /* Private storage. */
 class OkularTTS::Private
 {
 public:
+    struct Sentence
+    {
+        int page;
+        QString text;
+        Okular::RegularAreaRect area;
+    };
+
     Private( OkularTTS *qq )
-        : q( qq ), speech( new QTextToSpeech( Okular::Settings::ttsEngine() ) )
+        : q( qq ), speech( new QTextToSpeech( Okular::Settings::ttsEngine() ) ),
+          nextPage( 0 ), lastPage( -1 ), highlightedPage( -1 ), readingId( 0 ), reading( false ), sentenceStarted( false )
     {
     }
 
@@ -31,13 +52,189 @@ public:
         speech = nullptr;
     }
 
+    void extractPage();
+    void fillLookAhead();
+    void speakNextSentence();
+    void stopReading();
+    bool isVisible( int page, const Okular::NormalizedRect &rect ) const;
+    void setHighlight( const Sentence &sentence );
+
     OkularTTS *q;
     QTextToSpeech *speech;
     // Which speech engine was used when above object was created.
     // When the setting changes, we need to stop speaking and recreate.
     QString speechEngine;
+
+    // pages being read
+    QPointer<Okular::Document> document;
+    int nextPage;
+    int lastPage;
+    QQueue<Sentence> sentences;
+    int highlightedPage;
+    // changes on every stop, so that the steps queued for an earlier
+    // reading are dropped
+    int readingId;
+    bool reading;
+    // whether the engine started speaking the current sentence, the end of
+    // the previous speech may be notified after the sentence is given
+    bool sentenceStarted;
 };
 
+static bool endsSentence( const QString &word )
+{
+    for ( int i = word.length() - 1; i >= 0; --i )
+    {
+        const QChar c = word.at( i );
+        if ( c.isSpace() )
+            continue;
+        return c == QLatin1Char( '.' ) || c == QLatin1Char( '!' ) || c == QLatin1Char( '?' ) || c == QLatin1Char( ':' ) || c == QLatin1Char( ';' );
+    }
+    return false;
+}
+
+void OkularTTS::Private::extractPage()
+{
+    const int pageNumber = nextPage++;
+    const Okular::Page *page = document->page( pageNumber );
+    if ( !page )
+        return;
+
+    if ( !page->hasTextPage() )
+        document->requestTextPage( pageNumber );
+
+    const Okular::TextEntity::List words = page->words( nullptr, Okular::TextPage::AnyPixelTextAreaInclusionBehaviour );
+    Sentence sentence{ pageNumber, QString(), Okular::RegularAreaRect() };
+    for ( const Okular::TextEntity *word : words )
+    {
+        sentence.text += word->text();
+        sentence.area.appendShape( *word->area() );
+
+        if ( endsSentence( word->text() ) || sentence.text.length() >= MaxSentenceLength )
+        {
+            if ( !sentence.text.trimmed().isEmpty() )
+            {
+                sentence.area.simplify();
+                sentences.enqueue( sentence );
+            }
+            sentence.text.clear();
+            sentence.area = Okular::RegularAreaRect();
+        }
+    }
+    qDeleteAll( words );
+
+    if ( !sentence.text.trimmed().isEmpty() )
+    {
+        sentence.area.simplify();
+        sentences.enqueue( sentence );
+    }
+}
+
+void OkularTTS::Private::fillLookAhead()
+{
+    if ( !reading || !document || nextPage > lastPage )
+        return;
+
+    const int currentPage = sentences.isEmpty() ? nextPage : sentences.head().page;
+    if ( nextPage - currentPage > LookAheadPages )
+        return;
+
+    // one page at a time, so that the UI keeps responding
+    extractPage();
+    QTimer::singleShot( 0, q, [this] { fillLookAhead(); } );
+}
+
+void OkularTTS::Private::speakNextSentence()
+{
+    if ( !document )
+    {
+        stopReading();
+        return;
+    }
+
+    // pages without text are skipped one at a time, so that the UI keeps
+    // responding on long runs of them
+    if ( sentences.isEmpty() && nextPage <= lastPage )
+    {
+        extractPage();
+        if ( sentences.isEmpty() )
+        {
+            const int id = readingId;
+            QTimer::singleShot( 0, q, [this, id] {
+                if ( reading && readingId == id )
+                    speakNextSentence();
+            } );
+            return;
+        }
+    }
+
+    if ( sentences.isEmpty() )
+    {
+        stopReading();
+        emit q->isSpeaking( false );
+        emit q->canPauseOrResume( false );
+        return;
+    }
+
+    const Sentence sentence = sentences.dequeue();
+    setHighlight( sentence );
+    sentenceStarted = false;
+    speech->say( sentence.text );
+
+    QTimer::singleShot( 0, q, [this] { fillLookAhead(); } );
+}
+
+void OkularTTS::Private::stopReading()
+{
+    if ( document && document->page( highlightedPage ) )
+        document->setPageHighlight( highlightedPage, TTS_HIGHLIGHT_ID, nullptr, QColor() );
+
+    ++readingId;
+    reading = false;
+    sentences.clear();
+    highlightedPage = -1;
+    nextPage = 0;
+    lastPage = -1;
+}
+
+bool OkularTTS::Private::isVisible( int page, const Okular::NormalizedRect &rect ) const
+{
+    for ( const Okular::VisiblePageRect *visibleRect : document->visiblePageRects() )
+    {
+        if ( visibleRect->pageNumber == page && visibleRect->rect.intersects( rect ) )
+            return true;
+    }
+    return false;
+}
+
+void OkularTTS::Private::setHighlight( const Sentence &sentence )
+{
+    const int previousPage = highlightedPage;
+    if ( previousPage != sentence.page && document->page( previousPage ) )
+        document->setPageHighlight( previousPage, TTS_HIGHLIGHT_ID, nullptr, QColor() );
+
+    // the document may have been reloaded since the sentence was extracted
+    highlightedPage = -1;
+    if ( !document->page( sentence.page ) )
+        return;
+
+    // follow the reading when it gets out of sight, without filling the
+    // history with every sentence
+    if ( !sentence.area.isEmpty() && !isVisible( sentence.page, sentence.area.first() ) )
+    {
+        const Okular::NormalizedRect rect = sentence.area.first();
+        Okular::DocumentViewport viewport( sentence.page );
+        viewport.rePos.enabled = true;
+        viewport.rePos.normalizedX = 0.5;
+        viewport.rePos.normalizedY = ( rect.top + rect.bottom ) / 2.0;
+        viewport.rePos.pos = Okular::DocumentViewport::Center;
+        document->setViewportWithHistory( viewport, nullptr, false, false );
+    }
+
+    highlightedPage = sentence.page;
+    document->setPageHighlight( sentence.page, TTS_HIGHLIGHT_ID, new Okular::RegularAreaRect( sentence.area ),
+                                QGuiApplication::palette().color( QPalette::Active, QPalette::Highlight ) );
+}
+
 OkularTTS::OkularTTS( QObject *parent )
     : QObject( parent ), d( new Private( this ) )
 {
@@ -58,14 +255,28 @@ void OkularTTS::say( const QString &text )
     if ( text.isEmpty() )
         return;
 
+    d->stopReading();
     d->speech->say( text );
 }
 
+void OkularTTS::sayPages( Okular::Document *document, int firstPage, int lastPage )
+{
+    d->stopReading();
+    d->speech->stop();
+    d->document = document;
+    d->nextPage = qMax( firstPage, 0 );
+    d->lastPage = qMin( lastPage, int( document->pages() ) - 1 );
+    d->reading = true;
+
+    d->speakNextSentence();
+}
+
 void OkularTTS::stopAllSpeechs()
 {
     if ( !d->speech )
         return;
 
+    d->stopReading();
     d->speech->stop();
 }
 
@@ -82,6 +293,25 @@ void OkularTTS::pauseResumeSpeech()
 
 void OkularTTS::slotSpeechStateChanged(QTextToSpeech::State state)
 {
+    if (d->reading)
+    {
+        if (state == QTextToSpeech::Speaking)
+        {
+            d->sentenceStarted = true;
+        }
+        else if (state == QTextToSpeech::Ready)
+        {
+            // a sentence was spoken, go on with the next one
+            if (d->sentenceStarted)
+                d->speakNextSentence();
+            return;
+        }
+        else if (state == QTextToSpeech::BackendError)
+        {
+            d->stopReading();
+        }
+    }
+
     if (state == QTextToSpeech::Speaking)
     {
         emit isSpeaking(true);
@@ -102,6 +332,7 @@ void OkularTTS::slotConfigChanged()
     const QString engine = Okular::Settings::ttsEngine();
     if (engine != d->speechEngine)
     {
+        d->stopReading();
         d->speech->stop();
         delete d->speech;
         d->speech = new QTextToSpeech(engine);
@@ -13,6 +13,10 @@
 #include <qobject.h>
 #include <QTextToSpeech>
 
+namespace Okular {
+class Document;
+}
+
 class OkularTTS : public QObject
 {
     Q_OBJECT
@@ -21,6 +25,14 @@ class OkularTTS : public QObject
         ~OkularTTS() override;
 
         void say( const QString &text );
+
+        /**
+         * Reads the pages from @p firstPage to @p lastPage of @p document
+         * one sentence at a time, highlighting the sentence being spoken.
+         * The text of the next pages is extracted while speaking, a few
+         * pages ahead only.
+         */
+        void sayPages( Okular::Document *document, int firstPage, int lastPage );
         void stopAllSpeechs();
         void pauseResumeSpeech();
 